@@ -0,0 +1,316 @@
+/*
+* Copyright © 2008-2012 Kristian Høgsberg
+* Copyright © 2010-2012 Intel Corporation
+* Copyright © 2011 Benjamin Franzke
+* Copyright © 2012 Collabora, Ltd.
+* Copyright © 2015 S-Core Corporation
+* Copyright © 2015-2016 Samsung Electronics co., Ltd. All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <string.h>
+
+#include "drm-internal.h"
+
+static uint32_t
+get_property_id(int fd, drmModeObjectProperties *props, const char *name,
+				uint64_t *value)
+{
+	uint32_t    i, id = 0;
+
+	for (i = 0; i < props->count_props && id == 0; i++) {
+		drmModePropertyRes *prop = drmModeGetProperty(fd, props->props[i]);
+
+		if (!prop)
+			continue;
+
+		if (strcmp(prop->name, name) == 0) {
+			id = prop->prop_id;
+
+			if (value)
+				*value = props->prop_values[i];
+		}
+
+		drmModeFreeProperty(prop);
+	}
+
+	return id;
+}
+
+void
+drm_plane_init_atomic(drm_plane_t *plane)
+{
+	int                         fd = plane->drm->fd;
+	drmModeObjectProperties    *props;
+	uint64_t                    type = DRM_PLANE_TYPE_OVERLAY;
+
+	props = drmModeObjectGetProperties(fd, plane->id, DRM_MODE_OBJECT_PLANE);
+	PEPPER_CHECK(props, return, "drmModeObjectGetProperties() failed.\n");
+
+	if (get_property_id(fd, props, "type", &type))
+		plane->type = (uint32_t)type;
+
+	plane->prop.fb_id = get_property_id(fd, props, "FB_ID", NULL);
+	plane->prop.crtc_id = get_property_id(fd, props, "CRTC_ID", NULL);
+	plane->prop.src_x = get_property_id(fd, props, "SRC_X", NULL);
+	plane->prop.src_y = get_property_id(fd, props, "SRC_Y", NULL);
+	plane->prop.src_w = get_property_id(fd, props, "SRC_W", NULL);
+	plane->prop.src_h = get_property_id(fd, props, "SRC_H", NULL);
+	plane->prop.crtc_x = get_property_id(fd, props, "CRTC_X", NULL);
+	plane->prop.crtc_y = get_property_id(fd, props, "CRTC_Y", NULL);
+	plane->prop.crtc_w = get_property_id(fd, props, "CRTC_W", NULL);
+	plane->prop.crtc_h = get_property_id(fd, props, "CRTC_H", NULL);
+
+	drmModeFreeObjectProperties(props);
+}
+
+static drm_plane_t *
+find_plane(drm_output_t *output, uint32_t type)
+{
+	drm_plane_t *plane;
+
+	pepper_list_for_each(plane, &output->drm->plane_list, link) {
+		if (plane->output || plane->type != type || !plane->prop.fb_id)
+			continue;
+
+		if (plane->plane->possible_crtcs & (1 << output->crtc_index))
+			return plane;
+	}
+
+	return NULL;
+}
+
+pepper_bool_t
+drm_output_init_atomic(drm_output_t *output)
+{
+	pepper_drm_t               *drm = output->drm;
+	drmModeObjectProperties    *props;
+
+	props = drmModeObjectGetProperties(drm->fd, output->crtc_id,
+									   DRM_MODE_OBJECT_CRTC);
+	PEPPER_CHECK(props, return PEPPER_FALSE,
+				 "drmModeObjectGetProperties() failed.\n");
+
+	output->atomic.crtc_mode_id = get_property_id(drm->fd, props, "MODE_ID", NULL);
+	output->atomic.crtc_active = get_property_id(drm->fd, props, "ACTIVE", NULL);
+	drmModeFreeObjectProperties(props);
+
+	props = drmModeObjectGetProperties(drm->fd, output->conn->id,
+									   DRM_MODE_OBJECT_CONNECTOR);
+	PEPPER_CHECK(props, return PEPPER_FALSE,
+				 "drmModeObjectGetProperties() failed.\n");
+
+	output->atomic.conn_crtc_id = get_property_id(drm->fd, props, "CRTC_ID", NULL);
+	drmModeFreeObjectProperties(props);
+
+	PEPPER_CHECK(output->atomic.crtc_mode_id && output->atomic.crtc_active &&
+				 output->atomic.conn_crtc_id, return PEPPER_FALSE,
+				 "Missing atomic CRTC or connector properties.\n");
+
+	output->atomic.primary = find_plane(output, DRM_PLANE_TYPE_PRIMARY);
+	PEPPER_CHECK(output->atomic.primary, return PEPPER_FALSE,
+				 "No primary plane for CRTC %d.\n", output->crtc_id);
+	output->atomic.primary->output = output;
+
+	if (!pepper_list_empty(&output->cursor_cache))
+		output->atomic.cursor = find_plane(output, DRM_PLANE_TYPE_CURSOR);
+
+	if (output->atomic.cursor)
+		output->atomic.cursor->output = output;
+
+	output->atomic.modeset = PEPPER_TRUE;
+	return PEPPER_TRUE;
+}
+
+void
+drm_output_fini_atomic(drm_output_t *output)
+{
+	pepper_drm_t   *drm = output->drm;
+
+	if (output->atomic.cursor) {
+		drmModeSetPlane(drm->fd, output->atomic.cursor->id, output->crtc_id,
+						0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+		output->atomic.cursor->output = NULL;
+		output->atomic.cursor = NULL;
+	}
+
+	if (output->atomic.primary) {
+		output->atomic.primary->output = NULL;
+		output->atomic.primary = NULL;
+	}
+
+	if (output->atomic.mode_blob) {
+		drmModeDestroyPropertyBlob(drm->fd, output->atomic.mode_blob);
+		output->atomic.mode_blob = 0;
+	}
+}
+
+static pepper_bool_t
+add_plane_state(drmModeAtomicReq *req, drm_plane_t *plane, uint32_t crtc_id,
+				uint32_t fb_id, int dx, int dy, int dw, int dh,
+				int sx, int sy, int sw, int sh)
+{
+	int ret = 0;
+
+	ret |= drmModeAtomicAddProperty(req, plane->id, plane->prop.fb_id, fb_id) < 0;
+	ret |= drmModeAtomicAddProperty(req, plane->id, plane->prop.crtc_id, crtc_id) < 0;
+
+	/* A disabled plane needs no geometry. */
+	if (!fb_id)
+		return ret == 0;
+
+	ret |= drmModeAtomicAddProperty(req, plane->id, plane->prop.crtc_x, dx) < 0;
+	ret |= drmModeAtomicAddProperty(req, plane->id, plane->prop.crtc_y, dy) < 0;
+	ret |= drmModeAtomicAddProperty(req, plane->id, plane->prop.crtc_w, dw) < 0;
+	ret |= drmModeAtomicAddProperty(req, plane->id, plane->prop.crtc_h, dh) < 0;
+	ret |= drmModeAtomicAddProperty(req, plane->id, plane->prop.src_x, sx) < 0;
+	ret |= drmModeAtomicAddProperty(req, plane->id, plane->prop.src_y, sy) < 0;
+	ret |= drmModeAtomicAddProperty(req, plane->id, plane->prop.src_w, sw) < 0;
+	ret |= drmModeAtomicAddProperty(req, plane->id, plane->prop.src_h, sh) < 0;
+
+	return ret == 0;
+}
+
+static pepper_bool_t
+add_modeset_state(drmModeAtomicReq *req, drm_output_t *output)
+{
+	int ret = 0;
+
+	if (!output->atomic.mode_blob) {
+		ret = drmModeCreatePropertyBlob(output->drm->fd, output->mode,
+										sizeof(*output->mode),
+										&output->atomic.mode_blob);
+		PEPPER_CHECK(ret == 0, return PEPPER_FALSE,
+					 "drmModeCreatePropertyBlob() failed.\n");
+	}
+
+	ret |= drmModeAtomicAddProperty(req, output->crtc_id, output->atomic.crtc_mode_id,
+									output->atomic.mode_blob) < 0;
+	ret |= drmModeAtomicAddProperty(req, output->crtc_id, output->atomic.crtc_active,
+									1) < 0;
+	ret |= drmModeAtomicAddProperty(req, output->conn->id, output->atomic.conn_crtc_id,
+									output->crtc_id) < 0;
+
+	return ret == 0;
+}
+
+static pepper_bool_t
+add_cursor_state(drmModeAtomicReq *req, drm_output_t *output)
+{
+	pepper_drm_t   *drm = output->drm;
+	drm_plane_t    *cursor = output->atomic.cursor;
+	double          x, y;
+
+	if (!output->cursor_view) {
+		/* Look the image up again when the cursor is shown next time. */
+		if (output->cursor) {
+			output->cursor = NULL;
+			output->need_set_cursor = PEPPER_TRUE;
+		}
+
+		return add_plane_state(req, cursor, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	}
+
+	drm_output_update_cursor_bo(output);
+	if (!output->cursor) {
+		output->cursor_view = NULL;
+		return add_plane_state(req, cursor, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	}
+
+	pepper_view_get_position(output->cursor_view, &x, &y);
+	output->cursor_x = (int)x;
+	output->cursor_y = (int)y;
+	output->cursor_view = NULL;
+
+	return add_plane_state(req, cursor, output->crtc_id,
+						   output->cursor->fb,
+						   output->cursor_x, output->cursor_y,
+						   drm->cursor_width, drm->cursor_height,
+						   0, 0, drm->cursor_width << 16, drm->cursor_height << 16);
+}
+
+/* Build the whole state of the output (CRTC, primary, overlay and cursor
+ * planes) into a single request. With test_only, the kernel only checks
+ * whether the currently assigned buffers can be scanned out together; planes
+ * without a pending buffer are left untouched in that case. */
+pepper_bool_t
+drm_output_commit_atomic(drm_output_t *output, pepper_bool_t test_only)
+{
+	pepper_drm_t       *drm = output->drm;
+	drmModeAtomicReq   *req;
+	drm_buffer_t       *fb = output->back ? output->back : output->front;
+	drm_plane_t        *plane;
+	uint32_t            flags;
+	pepper_bool_t       ok = PEPPER_TRUE;
+	int                 ret;
+
+	req = drmModeAtomicAlloc();
+	PEPPER_CHECK(req, return PEPPER_FALSE, "drmModeAtomicAlloc() failed.\n");
+
+	if (test_only)
+		flags = DRM_MODE_ATOMIC_TEST_ONLY;
+	else
+		flags = DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK;
+
+	if (output->atomic.modeset) {
+		ok &= add_modeset_state(req, output);
+		flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
+	}
+
+	if (fb) {
+		ok &= add_plane_state(req, output->atomic.primary, output->crtc_id, fb->id,
+							  0, 0, output->mode->hdisplay, output->mode->vdisplay,
+							  0, 0, fb->w << 16, fb->h << 16);
+	}
+
+	pepper_list_for_each(plane, &drm->plane_list, link) {
+		if (plane->output != output || !plane->base)
+			continue;
+
+		if (plane->back) {
+			ok &= add_plane_state(req, plane, output->crtc_id, plane->back->id,
+								  plane->dx, plane->dy, plane->dw, plane->dh,
+								  plane->sx, plane->sy, plane->sw, plane->sh);
+		} else if (!test_only && plane->front) {
+			ok &= add_plane_state(req, plane, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+		}
+	}
+
+	if (!test_only && output->atomic.cursor)
+		ok &= add_cursor_state(req, output);
+
+	if (!ok) {
+		PEPPER_ERROR("Failed to build atomic request.\n");
+		drmModeAtomicFree(req);
+		return PEPPER_FALSE;
+	}
+
+	ret = drmModeAtomicCommit(drm->fd, req, flags, output);
+	drmModeAtomicFree(req);
+
+	if (test_only)
+		return ret == 0;
+
+	PEPPER_CHECK(ret == 0, return PEPPER_FALSE, "drmModeAtomicCommit() failed.\n");
+	output->atomic.modeset = PEPPER_FALSE;
+
+	return PEPPER_TRUE;
+}
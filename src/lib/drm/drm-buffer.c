@@ -101,35 +101,67 @@ error:
 	return NULL;
 }
 
+static pepper_bool_t
+add_fb(drm_buffer_t *buffer, uint32_t format)
+{
+	int         ret = -1;
+	uint32_t    handles[4], strides[4], offsets[4];
+	uint64_t    modifiers[4];
+	int         i, count;
+
+	memset(handles, 0x00, sizeof(handles));
+	memset(strides, 0x00, sizeof(strides));
+	memset(offsets, 0x00, sizeof(offsets));
+	memset(modifiers, 0x00, sizeof(modifiers));
+
+	count = gbm_bo_get_plane_count(buffer->bo);
+
+	for (i = 0; i < count && i < 4; i++) {
+		handles[i] = gbm_bo_get_handle_for_plane(buffer->bo, i).u32;
+		strides[i] = gbm_bo_get_stride_for_plane(buffer->bo, i);
+		offsets[i] = gbm_bo_get_offset(buffer->bo, i);
+		modifiers[i] = buffer->modifier;
+	}
+
+	if (buffer->modifier != DRM_FORMAT_MOD_INVALID) {
+		ret = drmModeAddFB2WithModifiers(buffer->drm->fd, buffer->w, buffer->h, format,
+										 handles, strides, offsets, modifiers,
+										 &buffer->id, DRM_MODE_FB_MODIFIERS);
+	}
+
+	/* Without explicit modifiers the layout is left to the driver. */
+	if (ret != 0) {
+		ret = drmModeAddFB2(buffer->drm->fd, buffer->w, buffer->h, format,
+							handles, strides, offsets, &buffer->id, 0);
+	}
+
+	if (ret != 0 && count == 1) {
+		ret = drmModeAddFB(buffer->drm->fd, buffer->w, buffer->h, 24, 32,
+						   buffer->stride, buffer->handle, &buffer->id);
+	}
+
+	PEPPER_CHECK(ret == 0, return PEPPER_FALSE, "Failed to add framebuffer.\n");
+
+	buffer->format = format;
+	return PEPPER_TRUE;
+}
+
 static inline pepper_bool_t
 init_buffer_gbm(drm_buffer_t *buffer, pepper_drm_t *drm, struct gbm_bo *bo,
 				uint32_t format)
 {
-	int         ret;
-	uint32_t    handles[4], strides[4], offsets[4];
-
 	buffer->drm = drm;
 	buffer->handle = gbm_bo_get_handle(bo).u32;
 	buffer->w = gbm_bo_get_width(bo);
 	buffer->h = gbm_bo_get_height(bo);
 	buffer->stride = gbm_bo_get_stride(bo);
 	buffer->size = buffer->h * buffer->stride;
+	buffer->modifier = gbm_bo_get_modifier(bo);
+	buffer->bo = bo;
 
-	handles[0] = buffer->handle;
-	strides[0] = buffer->stride;
-	offsets[0] = 0;
-
-	ret = drmModeAddFB2(drm->fd, buffer->w, buffer->h,
-						format ? format : gbm_bo_get_format(bo),
-						handles, strides, offsets, &buffer->id , 0);
-
-	if (ret != 0) {
-		ret = drmModeAddFB(drm->fd, buffer->w, buffer->h, 24, 32,
-						   buffer->stride, buffer->handle, &buffer->id);
-		PEPPER_CHECK(ret, return PEPPER_FALSE, "drmModeAddFB() failed.\n");
-	}
+	if (!add_fb(buffer, format ? format : gbm_bo_get_format(bo)))
+		return PEPPER_FALSE;
 
-	buffer->bo = bo;
 	gbm_bo_set_user_data(bo, buffer, NULL);
 
 	return PEPPER_TRUE;
@@ -145,6 +177,7 @@ drm_buffer_create_gbm(pepper_drm_t *drm, struct gbm_surface *surface,
 	PEPPER_CHECK(buffer, return NULL, "calloc() failed.\n");
 
 	if (!init_buffer_gbm(buffer, drm, bo, 0)) {
+		/* The bo belongs to the gbm surface. */
 		free(buffer);
 		return NULL;
 	}
@@ -162,47 +195,169 @@ handle_client_buffer_destroy(pepper_event_listener_t *listener,
 							 uint32_t id, void *info, void *data)
 {
 	drm_buffer_t *buffer = data;
+
+	pepper_event_listener_remove(buffer->client_buffer_destroy_listener);
 	buffer->client_buffer = NULL;
+
+	/* Still being scanned out, destroyed when the last user releases it. */
+	if (buffer->busy_count == 0)
+		drm_buffer_destroy(buffer);
 }
 
-drm_buffer_t *
-drm_buffer_create_client(pepper_drm_t *drm,
-						 struct gbm_bo *bo, pepper_buffer_t *client_buffer, uint32_t format)
+static struct gbm_bo *
+import_dmabuf(pepper_drm_t *drm, const pepper_dmabuf_attributes_t *attributes)
 {
-	drm_buffer_t *buffer;
+	struct gbm_import_fd_modifier_data  data;
+	int                                 i;
 
-	buffer = calloc(1, sizeof(drm_buffer_t));
-	PEPPER_CHECK(buffer, return NULL, "calloc() failed.\n");
+	if (attributes->n_planes > GBM_MAX_PLANES)
+		return NULL;
 
-	if (!init_buffer_gbm(buffer, drm, bo, format)) {
-		free(buffer);
+	/* Interlaced buffers and y-inverted contents can't be scanned out as is. */
+	if (attributes->flags)
 		return NULL;
+
+	memset(&data, 0x00, sizeof(data));
+	data.width = attributes->width;
+	data.height = attributes->height;
+	data.format = attributes->format;
+	data.num_fds = attributes->n_planes;
+	data.modifier = attributes->modifier[0];
+
+	for (i = 0; i < attributes->n_planes; i++) {
+		data.fds[i] = attributes->fd[i];
+		data.strides[i] = attributes->stride[i];
+		data.offsets[i] = attributes->offset[i];
 	}
 
+	return gbm_bo_import(drm->gbm_device, GBM_BO_IMPORT_FD_MODIFIER, &data,
+						 GBM_BO_USE_SCANOUT);
+}
+
+drm_buffer_t *
+drm_buffer_get_client(pepper_drm_t *drm, pepper_buffer_t *client_buffer)
+{
+	drm_buffer_t                       *buffer;
+	struct gbm_bo                      *bo;
+	const pepper_dmabuf_attributes_t   *attributes;
+
+	buffer = pepper_object_get_user_data((pepper_object_t *)client_buffer, drm);
+	if (buffer)
+		return buffer;
+
+	buffer = calloc(1, sizeof(drm_buffer_t));
+	PEPPER_CHECK(buffer, return NULL, "calloc() failed.\n");
+
+	buffer->drm = drm;
 	buffer->type = DRM_BUFFER_TYPE_CLIENT;
 	buffer->client_buffer = client_buffer;
-	pepper_buffer_reference(client_buffer);
 	buffer->client_buffer_destroy_listener =
 		pepper_object_add_event_listener((pepper_object_t *)client_buffer,
 										 PEPPER_EVENT_OBJECT_DESTROY, 0,
 										 handle_client_buffer_destroy, buffer);
+	pepper_object_set_user_data((pepper_object_t *)client_buffer, drm, buffer, NULL);
+	pepper_list_insert(&drm->client_buffer_list, &buffer->link);
+
+	/* A buffer that cannot be imported is kept with a NULL bo so that it is not
+	 * tried again. */
+	attributes = pepper_buffer_get_dmabuf_attributes(client_buffer);
+
+	if (attributes) {
+		bo = import_dmabuf(drm, attributes);
+	} else {
+		bo = gbm_bo_import(drm->gbm_device, GBM_BO_IMPORT_WL_BUFFER,
+						   pepper_buffer_get_resource(client_buffer), GBM_BO_USE_SCANOUT);
+	}
+
+	if (bo && !init_buffer_gbm(buffer, drm, bo, 0)) {
+		gbm_bo_destroy(bo);
+		buffer->bo = NULL;
+		buffer->id = 0;
+	}
 
 	return buffer;
 }
 
+pepper_bool_t
+drm_buffer_set_format(drm_buffer_t *buffer, uint32_t format)
+{
+	if (!buffer->bo)
+		return PEPPER_FALSE;
+
+	if (buffer->id && buffer->format == format)
+		return PEPPER_TRUE;
+
+	/* The framebuffer of a busy buffer can't be replaced under the scanout. */
+	if (buffer->busy_count > 0)
+		return PEPPER_FALSE;
+
+	if (buffer->id)
+		drmModeRmFB(buffer->drm->fd, buffer->id);
+
+	buffer->id = 0;
+	return add_fb(buffer, format);
+}
+
+void
+drm_buffer_reference(drm_buffer_t *buffer)
+{
+	if (buffer->type != DRM_BUFFER_TYPE_CLIENT)
+		return;
+
+	if (buffer->client_buffer)
+		pepper_buffer_reference(buffer->client_buffer);
+
+	buffer->busy_count++;
+}
+
+pepper_bool_t
+drm_buffer_is_rejected(drm_buffer_t *buffer, uint32_t plane_mask,
+					   int x, int y, int w, int h)
+{
+	if (buffer->reject.x != x || buffer->reject.y != y ||
+		buffer->reject.w != w || buffer->reject.h != h) {
+		buffer->reject.mask = 0;
+		return PEPPER_FALSE;
+	}
+
+	return (buffer->reject.mask & plane_mask) != 0;
+}
+
+void
+drm_buffer_reject(drm_buffer_t *buffer, uint32_t plane_mask,
+				  int x, int y, int w, int h)
+{
+	if (buffer->reject.x != x || buffer->reject.y != y ||
+		buffer->reject.w != w || buffer->reject.h != h)
+		buffer->reject.mask = 0;
+
+	buffer->reject.x = x;
+	buffer->reject.y = y;
+	buffer->reject.w = w;
+	buffer->reject.h = h;
+	buffer->reject.mask |= plane_mask;
+}
+
 void
 drm_buffer_release(drm_buffer_t *buffer)
 {
 	if (buffer->type == DRM_BUFFER_TYPE_GBM)
 		gbm_surface_release_buffer(buffer->surface, buffer->bo);
-	else if (buffer->type == DRM_BUFFER_TYPE_CLIENT)
-		drm_buffer_destroy(buffer);
+	else if (buffer->type == DRM_BUFFER_TYPE_CLIENT) {
+		buffer->busy_count--;
+
+		if (buffer->client_buffer)
+			pepper_buffer_unreference(buffer->client_buffer);
+		else if (buffer->busy_count == 0)
+			drm_buffer_destroy(buffer);
+	}
 }
 
 void
 drm_buffer_destroy(drm_buffer_t *buffer)
 {
-	drmModeRmFB(buffer->drm->fd, buffer->id);
+	if (buffer->id)
+		drmModeRmFB(buffer->drm->fd, buffer->id);
 
 	if (buffer->type == DRM_BUFFER_TYPE_DUMB) {
 		struct drm_mode_destroy_dumb destroy_arg;
@@ -221,11 +376,15 @@ drm_buffer_destroy(drm_buffer_t *buffer)
 		gbm_surface_release_buffer(buffer->surface, buffer->bo);
 	} else if (buffer->type == DRM_BUFFER_TYPE_CLIENT) {
 		if (buffer->client_buffer) {
-			pepper_buffer_unreference(buffer->client_buffer);
 			pepper_event_listener_remove(buffer->client_buffer_destroy_listener);
+			pepper_object_set_user_data((pepper_object_t *)buffer->client_buffer,
+										buffer->drm, NULL, NULL);
 		}
 
-		gbm_bo_destroy(buffer->bo);
+		pepper_list_remove(&buffer->link);
+
+		if (buffer->bo)
+			gbm_bo_destroy(buffer->bo);
 	}
 
 	free(buffer);
@@ -180,6 +180,7 @@ pepper_drm_create(pepper_compositor_t *compositor, struct udev *udev,
 	drm_magic_t             magic;
 	uint64_t                cap;
 	clockid_t               clock_id;
+	const char             *use_atomic_env = getenv("PEPPER_DRM_USE_ATOMIC");
 
 	drm = calloc(1, sizeof(pepper_drm_t));
 	PEPPER_CHECK(drm, goto error, "calloc() failed.\n");
@@ -187,6 +188,7 @@ pepper_drm_create(pepper_compositor_t *compositor, struct udev *udev,
 	drm->compositor = compositor;
 	drm->fd = -1;
 	pepper_list_init(&drm->plane_list);
+	pepper_list_init(&drm->client_buffer_list);
 	pepper_list_init(&drm->connector_list);
 
 	/* Find primary GPU udev device. Usually card0. */
@@ -269,6 +271,15 @@ pepper_drm_create(pepper_compositor_t *compositor, struct udev *udev,
 	ret = drmGetCap(drm->fd, 0x9 /* DRM_CAP_CURSOR_HEIGHT */, &cap);
 	drm->cursor_height = (ret == 0) ? cap : 64;
 
+	/* Atomic implies universal planes, so it must be enabled before the planes
+	 * are enumerated. */
+	if (use_atomic_env && strcmp(use_atomic_env, "1") == 0) {
+		if (drmSetClientCap(drm->fd, DRM_CLIENT_CAP_ATOMIC, 1) == 0)
+			drm->atomic = PEPPER_TRUE;
+		else
+			PEPPER_ERROR("Atomic modesetting is not supported, fall back to legacy.\n");
+	}
+
 	drm_init_planes(drm);
 	drm_init_connectors(drm);
 	udev_device_unref(udev_device);
@@ -301,6 +312,7 @@ pepper_drm_destroy(pepper_drm_t *drm)
 {
 	drm_connector_t *conn, *next_conn;
 	drm_plane_t     *plane, *next_plane;
+	drm_buffer_t    *buffer, *next_buffer;
 
 	pepper_list_for_each_safe(conn, next_conn, &drm->connector_list, link)
 	drm_connector_destroy(conn);
@@ -308,6 +320,9 @@ pepper_drm_destroy(pepper_drm_t *drm)
 	pepper_list_for_each_safe(plane, next_plane, &drm->plane_list, link)
 	drm_plane_destroy(plane);
 
+	pepper_list_for_each_safe(buffer, next_buffer, &drm->client_buffer_list, link)
+	drm_buffer_destroy(buffer);
+
 	if (drm->pixman_renderer)
 		pepper_renderer_destroy(drm->pixman_renderer);
 
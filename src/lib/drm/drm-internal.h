@@ -33,6 +33,7 @@
 #include <pixman.h>
 #include <xf86drm.h>
 #include <xf86drmMode.h>
+#include <drm_fourcc.h>
 #include <gbm.h>
 #ifdef HAVE_TBM
 #include <wayland-tbm-server.h>
@@ -47,6 +48,8 @@ typedef struct drm_output       drm_output_t;
 typedef struct drm_buffer       drm_buffer_t;
 typedef struct drm_plane        drm_plane_t;
 typedef struct drm_connector    drm_connector_t;
+typedef struct drm_view_state   drm_view_state_t;
+typedef struct drm_cursor       drm_cursor_t;
 
 typedef enum drm_buffer_type {
 	DRM_BUFFER_TYPE_DUMB,
@@ -73,6 +76,7 @@ struct pepper_drm {
 	pepper_list_t               connector_list;
 	uint32_t                    used_crtcs;
 	pepper_list_t               plane_list;
+	pepper_list_t               client_buffer_list;
 
 	drmModeRes                 *resources;
 	struct gbm_device          *gbm_device;
@@ -85,6 +89,8 @@ struct pepper_drm {
 	pepper_bool_t               cursor_broken;
 	int32_t                     cursor_width;
 	int32_t                     cursor_height;
+
+	pepper_bool_t               atomic;
 };
 
 struct drm_connector {
@@ -124,8 +130,22 @@ struct drm_buffer {
 	void                    *map;
 
 	pixman_image_t          *image;
+
+	/* client buffer import cache */
+	uint32_t                 format;
+	uint64_t                 modifier;
+	int                      busy_count;
+	struct {
+		uint32_t             mask;
+		int                  x, y, w, h;
+	} reject;
+	pepper_list_t            link;
 };
 
+/* Plane types a client buffer has been rejected for. */
+#define DRM_BUFFER_REJECT_FB        (1 << 0)
+#define DRM_BUFFER_REJECT_OVERLAY   (1 << 1)
+
 drm_buffer_t *
 drm_buffer_create_dumb(pepper_drm_t *drm, uint32_t w, uint32_t h);
 
@@ -134,8 +154,21 @@ drm_buffer_create_gbm(pepper_drm_t *drm, struct gbm_surface *surface,
 					  struct gbm_bo *bo);
 
 drm_buffer_t *
-drm_buffer_create_client(pepper_drm_t *drm,
-						 struct gbm_bo *bo, pepper_buffer_t *buffer, uint32_t format);
+drm_buffer_get_client(pepper_drm_t *drm, pepper_buffer_t *client_buffer);
+
+pepper_bool_t
+drm_buffer_set_format(drm_buffer_t *buffer, uint32_t format);
+
+void
+drm_buffer_reference(drm_buffer_t *buffer);
+
+pepper_bool_t
+drm_buffer_is_rejected(drm_buffer_t *buffer, uint32_t plane_mask,
+					   int x, int y, int w, int h);
+
+void
+drm_buffer_reject(drm_buffer_t *buffer, uint32_t plane_mask,
+				  int x, int y, int w, int h);
 
 void
 drm_buffer_release(drm_buffer_t *buffer);
@@ -143,6 +176,23 @@ drm_buffer_release(drm_buffer_t *buffer);
 void
 drm_buffer_destroy(drm_buffer_t *buffer);
 
+/* Number of cursor images kept uploaded per output. */
+#define DRM_CURSOR_CACHE_SIZE   8
+
+/* Frames to composite everything after a failed atomic commit before trying overlays again. */
+#define DRM_OVERLAY_RETRY_FRAMES    60
+
+struct drm_cursor {
+	struct gbm_bo          *bo;
+	uint32_t                fb;         /* atomic modesetting only */
+
+	/* Image in the bo, kept to tell hash collisions apart. */
+	uint32_t                hash;
+	uint32_t               *pixels;
+
+	pepper_list_t           link;
+};
+
 struct drm_output {
 	pepper_drm_t           *drm;
 	pepper_output_t        *base;
@@ -159,16 +209,28 @@ struct drm_output {
 	int                     vblank_pending_count;
 
 	pepper_view_t          *cursor_view;
+	pepper_view_t          *cursor_shown;   /* on the cursor plane since the last repaint */
 	pepper_buffer_t        *cursor_buffer;
-	struct gbm_bo          *cursor_bo[2];
-	int                     cursor_bo_index;
+	pepper_list_t           cursor_cache;   /* most recently used first */
+	int                     cursor_cache_size;
+	drm_cursor_t           *cursor;         /* image of cursor_view */
 	int                     cursor_x, cursor_y;
 	pepper_bool_t           need_set_cursor;
 
+	/* restored when the cursor plane assignment is dropped */
+	pepper_buffer_t        *cursor_buffer_prev;
+	pepper_bool_t           need_set_cursor_prev;
+
 	pepper_plane_t         *cursor_plane;
 	pepper_plane_t         *primary_plane;
 	pepper_plane_t         *fb_plane;
 	pepper_bool_t           use_overlay;
+	int                     overlay_retry;      /* frames left without overlays */
+	pepper_region_t         overlay_damage;     /* dropped overlays to recomposite */
+
+	/* plane assignment */
+	pepper_list_t           view_state_list;
+	struct wl_array         plane_candidates;
 
 	drm_render_type_t       render_type;
 	pepper_renderer_t      *renderer;
@@ -187,6 +249,46 @@ struct drm_output {
 	pepper_bool_t           disable_no_comp;
 
 	drm_buffer_t           *front, *back;
+
+	/* atomic modesetting */
+	struct {
+		drm_plane_t        *primary;
+		drm_plane_t        *cursor;
+		uint32_t            crtc_mode_id;
+		uint32_t            crtc_active;
+		uint32_t            conn_crtc_id;
+		uint32_t            mode_blob;
+		pepper_bool_t       modeset;
+	} atomic;
+};
+
+typedef enum drm_candidate_type {
+	DRM_CANDIDATE_NONE,
+	DRM_CANDIDATE_CURSOR,
+	DRM_CANDIDATE_FB,
+	DRM_CANDIDATE_OVERLAY,
+} drm_candidate_type_t;
+
+typedef struct drm_plane_candidate {
+	pepper_view_t          *view;
+	drm_view_state_t       *state;
+	drm_candidate_type_t    type;
+	int64_t                 score;
+	pepper_plane_t         *plane;
+} drm_plane_candidate_t;
+
+/* Per view plane assignment history of an output. */
+struct drm_view_state {
+	drm_output_t            *output;
+	pepper_view_t           *view;
+	pepper_event_listener_t *view_destroy_listener;
+
+	int                      candidate_frames;
+	int                      damage_rate;
+	pepper_bool_t            on_plane;
+	drm_plane_candidate_t   *candidate;
+
+	pepper_list_t            link;
 };
 
 drm_output_t *
@@ -203,11 +305,25 @@ void
 drm_handle_page_flip(int fd, unsigned int frame, unsigned int sec,
 					 unsigned int usec, void *data);
 
+pepper_bool_t
+drm_output_update_cursor_bo(drm_output_t *output);
+
+pepper_bool_t
+drm_output_init_atomic(drm_output_t *output);
+
+void
+drm_output_fini_atomic(drm_output_t *output);
+
+pepper_bool_t
+drm_output_commit_atomic(drm_output_t *output, pepper_bool_t test_only);
+
 struct drm_plane {
 	pepper_drm_t   *drm;
 	uint32_t        id;
 	drmModePlane   *plane;
 
+	uint32_t        type;
+
 	drm_output_t   *output;
 	pepper_plane_t *base;
 
@@ -215,12 +331,22 @@ struct drm_plane {
 	int             dx, dy, dw, dh;
 	int             sx, sy, sw, sh;
 
+	/* atomic property ids */
+	struct {
+		uint32_t    fb_id, crtc_id;
+		uint32_t    src_x, src_y, src_w, src_h;
+		uint32_t    crtc_x, crtc_y, crtc_w, crtc_h;
+	} prop;
+
 	pepper_list_t   link;
 };
 
 void
 drm_init_planes(pepper_drm_t *drm);
 
+void
+drm_plane_init_atomic(drm_plane_t *plane);
+
 void
 drm_plane_destroy(drm_plane_t *plane);
 
@@ -34,6 +34,10 @@
 #include <pepper-pixman-renderer.h>
 #include <pepper-gl-renderer.h>
 
+/* Page flip and vblank events carry the hardware vblank time and counter. */
+#define DRM_PRESENT_FLAGS   (PEPPER_OUTPUT_PRESENT_VSYNC | PEPPER_OUTPUT_PRESENT_HW_CLOCK | \
+							 PEPPER_OUTPUT_PRESENT_HW_COMPLETION)
+
 static int32_t
 drm_output_get_subpixel_order(void *data)
 {
@@ -124,6 +128,15 @@ drm_output_set_mode(void *o, const pepper_output_mode_t *mode)
 
 		if (same_mode(info, mode)) {
 			output->mode = info;
+
+			if (output->drm->atomic) {
+				if (output->atomic.mode_blob)
+					drmModeDestroyPropertyBlob(output->drm->fd, output->atomic.mode_blob);
+
+				output->atomic.mode_blob = 0;
+				output->atomic.modeset = PEPPER_TRUE;
+			}
+
 			pepper_output_update_mode(output->base);
 			return PEPPER_TRUE;
 		}
@@ -149,6 +162,9 @@ assign_cursor_plane(drm_output_t *output, pepper_view_t *view)
 	if (output->drm->cursor_broken)
 		return NULL;
 
+	if (output->drm->atomic && !output->atomic.cursor)
+		return NULL;
+
 	pepper_view_get_size(view, &w, &h);
 	if ((output->drm->cursor_width < w) || (output->drm->cursor_height < h))
 		return NULL;
@@ -163,7 +179,11 @@ assign_cursor_plane(drm_output_t *output, pepper_view_t *view)
 		return NULL;
 
 	output->cursor_view = view;
-	if (output->cursor_buffer != buffer) {
+	output->cursor_buffer_prev = output->cursor_buffer;
+	output->need_set_cursor_prev = output->need_set_cursor;
+
+	if (output->cursor_buffer != buffer ||
+		pepper_region_not_empty(pepper_surface_get_damage_region(surface))) {
 		output->cursor_buffer = buffer;
 		output->need_set_cursor = PEPPER_TRUE;
 	}
@@ -171,6 +191,30 @@ assign_cursor_plane(drm_output_t *output, pepper_view_t *view)
 	return output->cursor_plane;
 }
 
+/* Format to scan out a buffer with when its alpha channel can be ignored. */
+static uint32_t
+get_opaque_format(uint32_t format)
+{
+	switch (format) {
+	case GBM_FORMAT_ARGB8888:
+		return GBM_FORMAT_XRGB8888;
+	case GBM_FORMAT_ABGR8888:
+		return GBM_FORMAT_XBGR8888;
+	case GBM_FORMAT_RGBA8888:
+		return GBM_FORMAT_RGBX8888;
+	case GBM_FORMAT_BGRA8888:
+		return GBM_FORMAT_BGRX8888;
+	case GBM_FORMAT_ARGB2101010:
+		return GBM_FORMAT_XRGB2101010;
+	case GBM_FORMAT_ABGR2101010:
+		return GBM_FORMAT_XBGR2101010;
+	case GBM_FORMAT_ARGB4444:
+		return GBM_FORMAT_XRGB4444;
+	}
+
+	return format;
+}
+
 static pepper_plane_t *
 assign_fb_plane(drm_output_t *output, pepper_view_t *view)
 {
@@ -178,8 +222,8 @@ assign_fb_plane(drm_output_t *output, pepper_view_t *view)
 	int32_t             w, h;
 	pepper_surface_t   *surface;
 	pepper_buffer_t    *buffer;
-	struct wl_resource *resource;
-	struct gbm_bo      *bo;
+	drm_buffer_t       *fb;
+	uint32_t            format;
 
 	const pepper_output_geometry_t *geometry;
 
@@ -216,17 +260,19 @@ assign_fb_plane(drm_output_t *output, pepper_view_t *view)
 	if (!buffer)
 		return NULL;
 
-	resource = pepper_buffer_get_resource(buffer);
-	if (!resource)
+	if (wl_shm_buffer_get(pepper_buffer_get_resource(buffer)))
+		return NULL;
+
+	fb = drm_buffer_get_client(output->drm, buffer);
+	if (!fb || !fb->bo)
 		return NULL;
 
-	bo = gbm_bo_import(output->drm->gbm_device,
-					   GBM_BO_IMPORT_WL_BUFFER, resource, GBM_BO_USE_SCANOUT);
-	if (!bo)
+	if (drm_buffer_is_rejected(fb, DRM_BUFFER_REJECT_FB, (int)x, (int)y, w, h))
 		return NULL;
 
-	/* TODO: Other alpha formats like ARGB4444, ABGR8888 ?? */
-	if (gbm_bo_get_format(bo) == GBM_FORMAT_ARGB8888) {
+	format = gbm_bo_get_format(fb->bo);
+
+	if (get_opaque_format(format) != format) {
 		pepper_box_t      box;
 		pepper_region_t  *opaque;
 
@@ -237,17 +283,26 @@ assign_fb_plane(drm_output_t *output, pepper_view_t *view)
 
 		opaque = pepper_surface_get_opaque_region(surface);
 
-		if (pepper_region_contains_rectangle(opaque, &box) != PEPPER_REGION_IN) {
-			gbm_bo_destroy(bo);
+		if (pepper_region_contains_rectangle(opaque, &box) != PEPPER_REGION_IN)
 			return NULL;
-		}
+
+		format = get_opaque_format(format);
 	}
 
-	/* TODO: Hard-coded XRGB8888 */
-	output->back = drm_buffer_create_client(output->drm, bo, buffer,
-											GBM_FORMAT_XRGB8888);
-	if (!output->back) {
-		gbm_bo_destroy(bo);
+	/* A legacy page flip can't change the format of the mode framebuffer. */
+	if (!output->drm->atomic && format != GBM_FORMAT_XRGB8888)
+		return NULL;
+
+	if (!drm_buffer_set_format(fb, format))
+		return NULL;
+
+	drm_buffer_reference(fb);
+	output->back = fb;
+
+	if (output->drm->atomic && !drm_output_commit_atomic(output, PEPPER_TRUE)) {
+		drm_buffer_release(fb);
+		output->back = NULL;
+		drm_buffer_reject(fb, DRM_BUFFER_REJECT_FB, (int)x, (int)y, w, h);
 		return NULL;
 	}
 
@@ -261,7 +316,7 @@ assign_overlay_plane(drm_output_t *output, pepper_view_t *view)
 	pepper_surface_t   *surface;
 	pepper_buffer_t    *buffer;
 	struct wl_resource *resource;
-	struct gbm_bo      *bo;
+	drm_buffer_t       *fb;
 	uint32_t            format;
 	pepper_bool_t       found;
 	uint32_t            i;
@@ -269,7 +324,7 @@ assign_overlay_plane(drm_output_t *output, pepper_view_t *view)
 	double              x, y;
 	int                 w, h;
 
-	if (!output->use_overlay)
+	if (!output->use_overlay || output->overlay_retry > 0)
 		return NULL;
 
 	if (!output->drm->gbm_device)
@@ -296,7 +351,7 @@ assign_overlay_plane(drm_output_t *output, pepper_view_t *view)
 	found = PEPPER_FALSE;
 
 	pepper_list_for_each(plane, &output->drm->plane_list, link) {
-		if (plane->back)
+		if (plane->output != output || !plane->base || plane->back)
 			continue;
 
 		if (!(plane->plane->possible_crtcs & (1 << output->crtc_index)))
@@ -309,15 +364,16 @@ assign_overlay_plane(drm_output_t *output, pepper_view_t *view)
 	if (!found)
 		return NULL;
 
-	bo = gbm_bo_import(output->drm->gbm_device,
-					   GBM_BO_IMPORT_WL_BUFFER, resource, GBM_BO_USE_SCANOUT);
-	if (!bo)
+	fb = drm_buffer_get_client(output->drm, buffer);
+	if (!fb || !fb->bo)
+		return NULL;
+
+	if (drm_buffer_is_rejected(fb, DRM_BUFFER_REJECT_OVERLAY, (int)x, (int)y, w, h))
 		return NULL;
 
-	/* TODO: Other alpha formats like ARGB4444, ABGR8888 ?? */
-	format = gbm_bo_get_format(bo);
+	format = gbm_bo_get_format(fb->bo);
 
-	if (format == GBM_FORMAT_ARGB8888) {
+	if (get_opaque_format(format) != format) {
 		pepper_box_t      box;
 		pepper_region_t  *opaque;
 
@@ -329,7 +385,7 @@ assign_overlay_plane(drm_output_t *output, pepper_view_t *view)
 		opaque = pepper_surface_get_opaque_region(surface);
 
 		if (pepper_region_contains_rectangle(opaque, &box) == PEPPER_REGION_IN)
-			format = GBM_FORMAT_XRGB8888;
+			format = get_opaque_format(format);
 	}
 
 	found = PEPPER_FALSE;
@@ -341,16 +397,14 @@ assign_overlay_plane(drm_output_t *output, pepper_view_t *view)
 		}
 	}
 
-	if (!found) {
-		gbm_bo_destroy(bo);
+	if (!found)
 		return NULL;
-	}
 
-	plane->back = drm_buffer_create_client(output->drm, bo, buffer, format);
-	if (!plane->back) {
-		gbm_bo_destroy(bo);
+	if (!drm_buffer_set_format(fb, format))
 		return NULL;
-	}
+
+	drm_buffer_reference(fb);
+	plane->back = fb;
 
 	/* set position  */
 	plane->dx = (int)x;
@@ -363,35 +417,331 @@ assign_overlay_plane(drm_output_t *output, pepper_view_t *view)
 	plane->sw = w << 16;
 	plane->sh = h << 16;
 
-	plane->output = output;
+	if (output->drm->atomic && !drm_output_commit_atomic(output, PEPPER_TRUE)) {
+		drm_buffer_release(fb);
+		plane->back = NULL;
+		drm_buffer_reject(fb, DRM_BUFFER_REJECT_OVERLAY, (int)x, (int)y, w, h);
+		return NULL;
+	}
 
 	return plane->base;
 }
 
+/* Frames a view has to stay a plane candidate before it is promoted. */
+#define DRM_PLANE_PROMOTE_FRAMES    3
+
+static void
+view_state_destroy(drm_view_state_t *state)
+{
+	pepper_event_listener_remove(state->view_destroy_listener);
+	pepper_object_set_user_data((pepper_object_t *)state->view, state->output,
+								NULL, NULL);
+	pepper_list_remove(&state->link);
+	free(state);
+}
+
+static void
+view_state_handle_view_destroy(pepper_event_listener_t *listener,
+							   pepper_object_t *object,
+							   uint32_t id, void *info, void *data)
+{
+	view_state_destroy(data);
+}
+
+static drm_view_state_t *
+get_view_state(drm_output_t *output, pepper_view_t *view)
+{
+	drm_view_state_t *state = pepper_object_get_user_data((pepper_object_t *)view,
+							  output);
+
+	if (!state) {
+		state = calloc(1, sizeof(drm_view_state_t));
+		PEPPER_CHECK(state, return NULL, "calloc() failed.\n");
+
+		state->output = output;
+		state->view = view;
+		state->view_destroy_listener =
+			pepper_object_add_event_listener((pepper_object_t *)view,
+											 PEPPER_EVENT_OBJECT_DESTROY, 0,
+											 view_state_handle_view_destroy, state);
+		pepper_object_set_user_data((pepper_object_t *)view, output, state, NULL);
+		pepper_list_insert(&output->view_state_list, &state->link);
+	}
+
+	return state;
+}
+
+static int64_t
+region_area(pepper_region_t *region)
+{
+	pepper_box_t   *rects;
+	int             i, n;
+	int64_t         area = 0;
+
+	rects = pepper_region_rectangles(region, &n);
+
+	for (i = 0; i < n; i++)
+		area += (int64_t)(rects[i].x2 - rects[i].x1) * (rects[i].y2 - rects[i].y1);
+
+	return area;
+}
+
+static pepper_bool_t
+region_overlap(pepper_region_t *a, pepper_region_t *b)
+{
+	pepper_region_t    tmp;
+	pepper_bool_t      overlap;
+
+	pepper_region_init(&tmp);
+	pepper_region_intersect(&tmp, a, b);
+	overlap = pepper_region_not_empty(&tmp);
+	pepper_region_fini(&tmp);
+
+	return overlap;
+}
+
+/* Classify a view and score it by the visible area it would take out of
+ * composition, weighted by how often its surface is damaged. Only a pointer
+ * cursor or the topmost view may take the cursor plane, candidates are tried
+ * by score and a large shm popup would otherwise push the pointer off it. */
+static void
+plane_candidate_init(drm_output_t *output, drm_plane_candidate_t *candidate,
+					 pepper_region_t *occluded, pepper_bool_t topmost)
+{
+	const pepper_output_geometry_t *geometry = pepper_output_get_geometry(
+				output->base);
+	drm_view_state_t   *state = candidate->state;
+	pepper_surface_t   *surface = pepper_view_get_surface(candidate->view);
+	pepper_buffer_t    *buffer = surface ? pepper_surface_get_buffer(surface) : NULL;
+	pepper_region_t     visible;
+	pepper_bool_t       damaged;
+	double              x, y;
+	int                 w, h;
+
+	candidate->type = DRM_CANDIDATE_NONE;
+	candidate->score = 0;
+	candidate->plane = NULL;
+
+	if (!state || !buffer)
+		return;
+
+	damaged = pepper_region_not_empty(pepper_surface_get_damage_region(surface));
+	state->damage_rate += (damaged ? 32 : 0) - state->damage_rate / 8;
+
+	pepper_region_init(&visible);
+	pepper_region_subtract(&visible, pepper_view_get_bounding_region(candidate->view),
+						   occluded);
+	pepper_region_intersect_rect(&visible, &visible, geometry->x, geometry->y,
+								 geometry->w, geometry->h);
+	candidate->score = region_area(&visible);
+	pepper_region_fini(&visible);
+
+	/* Hidden views are not drawn anyway. */
+	if (candidate->score == 0)
+		goto done;
+
+	pepper_view_get_position(candidate->view, &x, &y);
+	pepper_view_get_size(candidate->view, &w, &h);
+
+	if (wl_shm_buffer_get(pepper_buffer_get_resource(buffer))) {
+		if (!topmost && !pepper_view_get_cursor_hotspot(candidate->view, NULL, NULL))
+			goto done;
+
+		candidate->type = DRM_CANDIDATE_CURSOR;
+	} else if (geometry->x == (int)x && geometry->y == (int)y &&
+			 geometry->w == w && geometry->h == h)
+		candidate->type = DRM_CANDIDATE_FB;
+	else
+		candidate->type = DRM_CANDIDATE_OVERLAY;
+
+	candidate->score = candidate->score * (256 + state->damage_rate * 3) / 256;
+
+	/* Hysteresis, a view keeps its plane against similar candidates. */
+	if (state->on_plane)
+		candidate->score += candidate->score / 2;
+
+done:
+	if (candidate->type == DRM_CANDIDATE_NONE)
+		state->candidate_frames = 0;
+	else if (state->candidate_frames < DRM_PLANE_PROMOTE_FRAMES)
+		state->candidate_frames++;
+}
+
+static int
+compare_plane_candidates(const void *a, const void *b)
+{
+	const drm_plane_candidate_t *ca = a;
+	const drm_plane_candidate_t *cb = b;
+
+	if (ca->score > cb->score)
+		return -1;
+	if (ca->score < cb->score)
+		return 1;
+
+	return 0;
+}
+
+static void
+plane_candidate_assign(drm_output_t *output, drm_plane_candidate_t *candidate)
+{
+	pepper_bool_t promoted = candidate->state->on_plane ||
+							 candidate->state->candidate_frames >= DRM_PLANE_PROMOTE_FRAMES;
+
+	switch (candidate->type) {
+	case DRM_CANDIDATE_CURSOR:
+		candidate->plane = assign_cursor_plane(output, candidate->view);
+		break;
+	case DRM_CANDIDATE_FB:
+		if (promoted)
+			candidate->plane = assign_fb_plane(output, candidate->view);
+	/* fall through */
+	case DRM_CANDIDATE_OVERLAY:
+		if (promoted && !candidate->plane)
+			candidate->plane = assign_overlay_plane(output, candidate->view);
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+unassign_plane(drm_output_t *output, pepper_plane_t *plane)
+{
+	drm_plane_t *drm_plane;
+
+	if (plane == output->cursor_plane) {
+		output->cursor_view = NULL;
+		output->cursor_buffer = output->cursor_buffer_prev;
+		output->need_set_cursor = output->need_set_cursor_prev;
+		return;
+	}
+
+	if (plane == output->fb_plane) {
+		drm_buffer_release(output->back);
+		output->back = NULL;
+		return;
+	}
+
+	pepper_list_for_each(drm_plane, &output->drm->plane_list, link) {
+		if (drm_plane->base == plane && drm_plane->back) {
+			drm_buffer_release(drm_plane->back);
+			drm_plane->back = NULL;
+			return;
+		}
+	}
+}
+
+/* A hardware plane must not show through a composited view stacked above it.
+ * The stacking between overlay planes is not known, so overlapping overlay
+ * views are not allowed either. Overlays sit above the primary plane, so they
+ * must not overlap a view scanned out from it above them. The cursor plane is
+ * always on top. */
+static pepper_bool_t
+plane_conflicts(drm_output_t *output, pepper_plane_t *plane,
+				pepper_region_t *bounding, pepper_region_t *above,
+				pepper_region_t *composited, pepper_region_t *overlays,
+				pepper_region_t *scanout)
+{
+	if (plane == output->cursor_plane)
+		return region_overlap(bounding, above);
+
+	if (plane == output->fb_plane)
+		return region_overlap(bounding, composited);
+
+	return region_overlap(bounding, composited) || region_overlap(bounding, overlays) ||
+		   region_overlap(bounding, scanout);
+}
+
 static void
 drm_output_assign_planes(void *o, const pepper_list_t *view_list)
 {
-	pepper_list_t      *l;
-	drm_output_t       *output = o;
+	drm_output_t           *output = o;
+	drm_plane_candidate_t  *candidate;
+	pepper_list_t          *l;
+	pepper_region_t         occluded, above, composited, overlays, scanout;
+	size_t                  count;
+
+	if (output->overlay_retry > 0)
+		output->overlay_retry--;
+
+	/* Collect candidates top to bottom, the opaque views above occlude. */
+	output->plane_candidates.size = 0;
+	pepper_region_init(&occluded);
+
+	pepper_list_for_each_list(l, view_list) {
+		pepper_view_t *view = l->item;
+
+		candidate = wl_array_add(&output->plane_candidates, sizeof(*candidate));
+		PEPPER_CHECK(candidate, break, "wl_array_add() failed.\n");
+
+		candidate->view = view;
+		candidate->state = get_view_state(output, view);
+		plane_candidate_init(output, candidate, &occluded,
+							 l == view_list->next);
+
+		pepper_region_union(&occluded, &occluded, pepper_view_get_opaque_region(view));
+	}
+
+	pepper_region_fini(&occluded);
+
+	/* Best candidates get the planes first. */
+	count = output->plane_candidates.size / sizeof(drm_plane_candidate_t);
+	qsort(output->plane_candidates.data, count, sizeof(drm_plane_candidate_t),
+		  compare_plane_candidates);
+
+	wl_array_for_each(candidate, &output->plane_candidates) {
+		if (!candidate->state)
+			continue;
+
+		candidate->state->candidate = candidate;
+		plane_candidate_assign(output, candidate);
+	}
+
+	/* Drop the assignments that conflict with the final stacking. */
+	pepper_region_init(&above);
+	pepper_region_init(&composited);
+	pepper_region_init(&overlays);
+	pepper_region_init(&scanout);
 
 	pepper_list_for_each_list(l, view_list) {
 		pepper_view_t      *view = l->item;
+		pepper_region_t    *bounding = pepper_view_get_bounding_region(view);
+		drm_view_state_t   *state = pepper_object_get_user_data((pepper_object_t *)view,
+									output);
 		pepper_plane_t     *plane = NULL;
 
-		if (plane == NULL)
-			plane = assign_cursor_plane(output, view);
-
-		if (plane == NULL)
-			plane = assign_fb_plane(output, view);
+		if (state && state->candidate)
+			plane = state->candidate->plane;
 
-		if (plane == NULL)
-			plane = assign_overlay_plane(output, view);
+		if (plane && plane_conflicts(output, plane, bounding, &above, &composited,
+									 &overlays, &scanout)) {
+			unassign_plane(output, plane);
+			plane = NULL;
+		}
 
-		if (plane == NULL)
+		if (!plane) {
 			plane = output->primary_plane;
+			pepper_region_union(&composited, &composited, bounding);
+		} else if (plane == output->fb_plane) {
+			pepper_region_union(&scanout, &scanout, bounding);
+		} else if (plane != output->cursor_plane) {
+			pepper_region_union(&overlays, &overlays, bounding);
+		}
+
+		pepper_region_union(&above, &above, bounding);
+
+		if (state) {
+			state->on_plane = (plane != output->primary_plane);
+			state->candidate = NULL;
+		}
 
 		pepper_view_assign_plane(view, output->base, plane);
 	}
+
+	pepper_region_fini(&above);
+	pepper_region_fini(&composited);
+	pepper_region_fini(&overlays);
+	pepper_region_fini(&scanout);
 }
 
 static void
@@ -479,59 +829,194 @@ drm_output_start_repaint_loop(void *o)
 	pepper_output_finish_frame(output->base, &ts);
 }
 
+static drm_cursor_t *
+drm_cursor_create(drm_output_t *output)
+{
+	pepper_drm_t   *drm = output->drm;
+	drm_cursor_t   *cursor;
+	int             ret;
+
+	cursor = calloc(1, sizeof(drm_cursor_t));
+	PEPPER_CHECK(cursor, return NULL, "calloc() failed.\n");
+
+	cursor->pixels = calloc(drm->cursor_width * drm->cursor_height, sizeof(uint32_t));
+	PEPPER_CHECK(cursor->pixels, goto error, "calloc() failed.\n");
+
+	cursor->bo = gbm_bo_create(drm->gbm_device, drm->cursor_width, drm->cursor_height,
+							   GBM_FORMAT_ARGB8888, GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE);
+	PEPPER_CHECK(cursor->bo, goto error, "failed to create cursor bo\n");
+
+	if (drm->atomic) {
+		ret = drmModeAddFB(drm->fd, drm->cursor_width, drm->cursor_height, 32, 32,
+						   gbm_bo_get_stride(cursor->bo), gbm_bo_get_handle(cursor->bo).u32,
+						   &cursor->fb);
+		PEPPER_CHECK(ret == 0, goto error, "failed to add cursor fb\n");
+	}
+
+	pepper_list_insert(output->cursor_cache.prev, &cursor->link);
+	output->cursor_cache_size++;
+
+	return cursor;
+
+error:
+	if (cursor->bo)
+		gbm_bo_destroy(cursor->bo);
+
+	free(cursor->pixels);
+	free(cursor);
+	return NULL;
+}
+
 static void
-drm_output_set_cursor(drm_output_t *output)
+drm_cursor_destroy(drm_output_t *output, drm_cursor_t *cursor)
 {
-	pepper_drm_t       *drm = output->drm;
-	pepper_surface_t   *surface;
-	pepper_buffer_t    *buffer;
+	if (cursor->fb)
+		drmModeRmFB(output->drm->fd, cursor->fb);
 
-	double              x, y;
+	gbm_bo_destroy(cursor->bo);
+	pepper_list_remove(&cursor->link);
+	output->cursor_cache_size--;
 
-	if (!output->cursor_view) {
-		drmModeSetCursor(drm->fd, output->crtc_id, 0, 0, 0);
-		return;
+	free(cursor->pixels);
+	free(cursor);
+}
+
+static uint32_t
+hash_cursor_image(const uint32_t *pixels, int count)
+{
+	uint32_t    hash = 2166136261u;
+	int         i;
+
+	/* FNV-1a over whole pixels. */
+	for (i = 0; i < count; i++)
+		hash = (hash ^ pixels[i]) * 16777619u;
+
+	return hash;
+}
+
+/* Find the cache entry holding the image, or upload the image into the least
+ * recently used one. The entries shown now and by the previous frame are
+ * always the two most recently used, so they are never overwritten. */
+static drm_cursor_t *
+get_cursor(drm_output_t *output, const uint32_t *pixels, int count)
+{
+	uint32_t        hash = hash_cursor_image(pixels, count);
+	drm_cursor_t   *cursor;
+
+	pepper_list_for_each(cursor, &output->cursor_cache, link) {
+		if (cursor->hash == hash &&
+			memcmp(cursor->pixels, pixels, count * sizeof(uint32_t)) == 0)
+			goto done;
 	}
 
+	cursor = NULL;
+	if (output->cursor_cache_size < DRM_CURSOR_CACHE_SIZE)
+		cursor = drm_cursor_create(output);
+
+	if (!cursor) {
+		cursor = pepper_container_of(output->cursor_cache.prev, cursor, link);
+
+		if (cursor == output->cursor)
+			return NULL;
+	}
+
+	if (gbm_bo_write(cursor->bo, pixels, count * sizeof(uint32_t))) {
+		PEPPER_ERROR("gbm_bo_write() failed.\n");
+		cursor->hash = 0;
+		memset(cursor->pixels, 0, count * sizeof(uint32_t));
+		return NULL;
+	}
+
+	cursor->hash = hash;
+	memcpy(cursor->pixels, pixels, count * sizeof(uint32_t));
+
+done:
+	pepper_list_remove(&cursor->link);
+	pepper_list_insert(&output->cursor_cache, &cursor->link);
+	return cursor;
+}
+
+/* Select the cached bo holding the cursor image, uploading the image only if
+ * it is not cached yet. Returns PEPPER_TRUE when output->cursor has changed. */
+pepper_bool_t
+drm_output_update_cursor_bo(drm_output_t *output)
+{
+	pepper_drm_t           *drm = output->drm;
+	pepper_surface_t       *surface;
+	pepper_buffer_t        *buffer;
+	drm_cursor_t           *cursor;
+
+	int32_t                 i, w, h, stride;
+	uint8_t                *data;
+	uint32_t                buf[drm->cursor_width * drm->cursor_height];
+
+	struct wl_resource     *resource;
+	struct wl_shm_buffer   *shm_buffer;
+
 	surface = pepper_view_get_surface(output->cursor_view);
 	buffer = pepper_surface_get_buffer(surface);
 
-	if (buffer && output->need_set_cursor) {
+	if (!buffer || !output->need_set_cursor)
+		return PEPPER_FALSE;
 
-		int32_t                 i, w, h, stride;
-		uint8_t                *data;
-		uint32_t                buf[drm->cursor_width * drm->cursor_height];
+	resource = pepper_buffer_get_resource(buffer);
+
+	shm_buffer = wl_shm_buffer_get(resource);
+	PEPPER_CHECK(shm_buffer, return PEPPER_FALSE, "shm_buffer is NULL.\n");
+	stride = wl_shm_buffer_get_stride(shm_buffer);
+	data = wl_shm_buffer_get_data(shm_buffer);
+
+	pepper_view_get_size(output->cursor_view, &w, &h);
+
+	memset(buf, 0, sizeof(buf));
+	wl_shm_buffer_begin_access(shm_buffer);
+	for (i = 0; i < h; i++)
+		memcpy(buf + i * drm->cursor_width, data + i * stride, w * sizeof(uint32_t));
+	wl_shm_buffer_end_access(shm_buffer);
 
-		struct gbm_bo          *bo;
-		struct wl_resource     *resource;
-		struct wl_shm_buffer   *shm_buffer;
+	cursor = get_cursor(output, buf, drm->cursor_width * drm->cursor_height);
+	if (!cursor)
+		return PEPPER_FALSE;
+
+	output->need_set_cursor = PEPPER_FALSE;
+
+	if (cursor == output->cursor)
+		return PEPPER_FALSE;
+
+	output->cursor = cursor;
+	return PEPPER_TRUE;
+}
 
-		resource = pepper_buffer_get_resource(buffer);
+static void
+drm_output_set_cursor(drm_output_t *output)
+{
+	pepper_drm_t       *drm = output->drm;
+	struct gbm_bo      *bo;
 
-		shm_buffer = wl_shm_buffer_get(resource);
-		PEPPER_CHECK(shm_buffer, return, "shm_buffer is NULL.\n");
-		stride = wl_shm_buffer_get_stride(shm_buffer);
-		data = wl_shm_buffer_get_data(shm_buffer);
+	double              x, y;
 
-		pepper_view_get_size(output->cursor_view, &w, &h);
+	output->cursor_shown = NULL;
 
-		memset(buf, 0, sizeof(buf));
-		wl_shm_buffer_begin_access(shm_buffer);
-		for (i = 0; i < h; i++)
-			memcpy(buf + i * drm->cursor_width, data + i * stride, w * sizeof(uint32_t));
-		wl_shm_buffer_end_access(shm_buffer);
+	if (!output->cursor_view) {
+		if (output->cursor) {
+			drmModeSetCursor(drm->fd, output->crtc_id, 0, 0, 0);
 
-		output->cursor_bo_index ^= 1;
-		bo = output->cursor_bo[output->cursor_bo_index];
-		gbm_bo_write(bo, buf, sizeof(buf));
+			/* Look the image up again when the cursor is shown next time. */
+			output->cursor = NULL;
+			output->need_set_cursor = PEPPER_TRUE;
+		}
+
+		return;
+	}
+
+	if (drm_output_update_cursor_bo(output)) {
+		bo = output->cursor->bo;
 
 		if (drmModeSetCursor(drm->fd, output->crtc_id, gbm_bo_get_handle(bo).s32,
 							 drm->cursor_width, drm->cursor_height)) {
 			PEPPER_TRACE("failed to set cursor\n");
 			drm->cursor_broken = PEPPER_TRUE;
 		}
-
-		output->need_set_cursor = PEPPER_FALSE;
 	}
 
 	pepper_view_get_position(output->cursor_view, &x, &y);
@@ -545,9 +1030,80 @@ drm_output_set_cursor(drm_output_t *output)
 		output->cursor_y = (int)y;
 	}
 
+	if (!drm->cursor_broken)
+		output->cursor_shown = output->cursor_view;
+
 	output->cursor_view = NULL;
 }
 
+static pepper_bool_t
+drm_output_move_cursor(void *o, pepper_view_t *view, double x, double y)
+{
+	drm_output_t   *output = o;
+	pepper_drm_t   *drm = output->drm;
+
+	/* The cursor plane is part of the atomic state, leave it to the next commit. */
+	if (drm->atomic || drm->cursor_broken || output->cursor_shown != view)
+		return PEPPER_FALSE;
+
+	if ((output->cursor_x == (int)x) && (output->cursor_y == (int)y))
+		return PEPPER_TRUE;
+
+	if (drmModeMoveCursor(drm->fd, output->crtc_id, (int)x, (int)y)) {
+		PEPPER_TRACE("failed to move cursor\n");
+		drm->cursor_broken = PEPPER_TRUE;
+		output->cursor_shown = NULL;
+		return PEPPER_FALSE;
+	}
+
+	output->cursor_x = (int)x;
+	output->cursor_y = (int)y;
+
+	return PEPPER_TRUE;
+}
+
+static pepper_bool_t
+drm_output_repaint_atomic(drm_output_t *output)
+{
+	drm_plane_t    *plane;
+
+	if (drm_output_commit_atomic(output, PEPPER_FALSE)) {
+		/* Primary, overlays and cursor complete with a single page flip event. */
+		output->page_flip_pending = PEPPER_TRUE;
+
+		pepper_list_for_each(plane, &output->drm->plane_list, link) {
+			if (plane->output == output && plane->base && plane->back)
+				pepper_plane_clear_damage_region(plane->base);
+		}
+
+		return PEPPER_TRUE;
+	}
+
+	/* Drop the overlays and let the legacy path flip the primary plane. The primary
+	 * buffer was rendered without the overlay views, so they are damaged when this
+	 * frame finishes and composited for a while before overlays are tried again. */
+	pepper_list_for_each(plane, &output->drm->plane_list, link) {
+		if (plane->output != output || !plane->base)
+			continue;
+
+		if (plane->back) {
+			PEPPER_ERROR("Atomic commit failed, compositing overlay views.\n");
+			output->overlay_retry = DRM_OVERLAY_RETRY_FRAMES;
+			pepper_region_union_rect(&output->overlay_damage, &output->overlay_damage,
+									 plane->dx, plane->dy, plane->dw, plane->dh);
+
+			drm_buffer_release(plane->back);
+			plane->back = NULL;
+		}
+
+		if (plane->front)
+			drmModeSetPlane(output->drm->fd, plane->id, output->crtc_id,
+							0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	}
+
+	return PEPPER_FALSE;
+}
+
 static void
 drm_output_repaint(void *o, const pepper_list_t *plane_list)
 {
@@ -561,6 +1117,9 @@ drm_output_repaint(void *o, const pepper_list_t *plane_list)
 	if (!output->back)
 		drm_output_render(output);
 
+	if (output->drm->atomic && drm_output_repaint_atomic(output))
+		return;
+
 	if (output->back) {
 		if (!output->front) {
 			ret = drmModeSetCrtc(output->drm->fd, output->crtc_id, output->back->id, 0, 0,
@@ -626,15 +1185,13 @@ drm_output_flush_surface_damage(void *o, pepper_surface_t *surface,
 
 	pepper_renderer_flush_surface_damage(output->renderer, surface);
 
-	if (output->render_type == DRM_RENDER_TYPE_PIXMAN)
+	if (!pepper_renderer_has_surface_copy(output->renderer, surface))
 		goto keep;
 
 	if (buffer) {
 		int w, h;
 
-		if (!wl_shm_buffer_get(pepper_buffer_get_resource(buffer)))
-			goto keep;
-
+		/* Cursor sized shm buffers might be copied into the cursor plane. */
 		pepper_buffer_get_size(buffer, &w, &h);
 		if ((w <= output->drm->cursor_width) && (h <= output->drm->cursor_height))
 			goto keep;
@@ -663,6 +1220,7 @@ struct pepper_output_backend drm_output_backend = {
 	drm_output_repaint,
 	drm_output_attach_surface,
 	drm_output_flush_surface_damage,
+	drm_output_move_cursor,
 };
 
 static int
@@ -848,6 +1406,10 @@ drm_output_create(drm_connector_t *conn)
 
 	output->drm = drm;
 	output->conn = conn;
+	pepper_list_init(&output->view_state_list);
+	pepper_list_init(&output->cursor_cache);
+	wl_array_init(&output->plane_candidates);
+	pepper_region_init(&output->overlay_damage);
 	output->crtc_index = find_crtc_for_connector(conn);
 	if (output->crtc_index == -1) {
 		PEPPER_ERROR("find_crtc_for_connector() failed.\n");
@@ -884,18 +1446,10 @@ drm_output_create(drm_connector_t *conn)
 	if (use_overlay_env && strcmp(use_overlay_env, "1") == 0)
 		output->use_overlay = PEPPER_TRUE;
 
-	if (drm->gbm_device) {
-		int i;
-
-		for (i = 0; i < 2; i++)
-			output->cursor_bo[i] = gbm_bo_create(drm->gbm_device,
-												 drm->cursor_width, drm->cursor_height,
-												 GBM_FORMAT_ARGB8888,
-												 GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE);
-		if (!output->cursor_bo[0] || !output->cursor_bo[1]) {
-			PEPPER_TRACE("failed to create cursor bo\n");
-			drm->cursor_broken = PEPPER_TRUE;
-		}
+	/* Cursor bos are allocated on demand, check with the first one that it works. */
+	if (drm->gbm_device && !drm_cursor_create(output)) {
+		PEPPER_TRACE("failed to create cursor bo\n");
+		drm->cursor_broken = PEPPER_TRUE;
 	}
 
 	output->primary_plane = pepper_output_add_plane(output->base, NULL);
@@ -910,14 +1464,23 @@ drm_output_create(drm_connector_t *conn)
 	output->fb_plane = pepper_output_add_plane(output->base, output->primary_plane);
 	PEPPER_CHECK(output->fb_plane, goto error,
 				 "pepper_output_add_plane() failed.\n");
+	pepper_plane_set_zero_copy(output->fb_plane, PEPPER_TRUE);
+
+	if (drm->atomic && !drm_output_init_atomic(output)) {
+		PEPPER_ERROR("drm_output_init_atomic() failed.\n");
+		drm_output_fini_atomic(output);
+		goto error;
+	}
 
 	pepper_list_for_each_safe(plane, tmp, &output->drm->plane_list, link) {
-		if (plane->output == NULL &&
+		if (plane->output == NULL && plane->type == DRM_PLANE_TYPE_OVERLAY &&
 			(plane->plane->possible_crtcs & (1 << output->crtc_index))) {
 			plane->base = pepper_output_add_plane(output->base, output->primary_plane);
 
-			if (plane->base)
+			if (plane->base) {
 				plane->output = output;
+				pepper_plane_set_zero_copy(plane->base, PEPPER_TRUE);
+			}
 		}
 	}
 
@@ -941,20 +1504,16 @@ error:
 void
 drm_output_destroy(void *o)
 {
-   int           i;
-   drm_output_t *output = o;
-   drm_plane_t  *plane;
+   drm_output_t     *output = o;
+   drm_plane_t      *plane;
+   drm_view_state_t *state, *tmp;
+   drm_cursor_t     *cursor, *next;
 
    if (output->page_flip_pending || (output->vblank_pending_count > 0)) {
         output->destroy_pending = PEPPER_TRUE;
         return;
    }
 
-   for (i = 0; i < 2; i++) {
-        if (output->cursor_bo[i])
-          gbm_bo_destroy(output->cursor_bo[i]);
-   }
-
    if (output->render_type == DRM_RENDER_TYPE_PIXMAN)
      fini_pixman_renderer(output);
    else if (output->render_type == DRM_RENDER_TYPE_GL)
@@ -970,6 +1529,12 @@ drm_output_destroy(void *o)
         drmModeFreeCrtc(output->saved_crtc);
    }
 
+   if (output->drm->atomic)
+     drm_output_fini_atomic(output);
+
+   pepper_list_for_each_safe(cursor, next, &output->cursor_cache, link)
+     drm_cursor_destroy(output, cursor);
+
    if (output->fb_plane)
      pepper_plane_destroy(output->fb_plane);
 
@@ -988,6 +1553,12 @@ drm_output_destroy(void *o)
         }
    }
 
+   pepper_list_for_each_safe(state, tmp, &output->view_state_list, link)
+     view_state_destroy(state);
+
+   wl_array_release(&output->plane_candidates);
+   pepper_region_fini(&output->overlay_damage);
+
    /* destroy renderer. */
    free(output);
 }
@@ -1014,7 +1585,8 @@ drm_handle_vblank(int fd, unsigned int frame, unsigned int sec,
 		} else {
 			ts.tv_sec = sec;
 			ts.tv_nsec = usec * 1000;
-			pepper_output_finish_frame(plane->output->base, &ts);
+			pepper_output_finish_frame_presented(plane->output->base, &ts, frame,
+												 DRM_PRESENT_FLAGS);
 		}
 	}
 }
@@ -1024,25 +1596,51 @@ drm_handle_page_flip(int fd, unsigned int frame, unsigned int sec,
 					 unsigned int usec, void *data)
 {
 	drm_output_t       *output = data;
+	drm_plane_t        *plane;
 	struct timespec     ts;
 
 	if (output->page_flip_pending == PEPPER_TRUE) {
 		output->page_flip_pending = PEPPER_FALSE;
 
-		if (output->front)
-			drm_buffer_release(output->front);
+		/* An atomic commit may keep scanning out the current front buffer. */
+		if (output->back) {
+			if (output->front)
+				drm_buffer_release(output->front);
 
-		output->front = output->back;
-		output->back = NULL;
+			output->front = output->back;
+			output->back = NULL;
+		}
+
+		/* With atomic, overlay planes are flipped by the same commit. */
+		if (output->drm->atomic) {
+			pepper_list_for_each(plane, &output->drm->plane_list, link) {
+				if (plane->output != output || !plane->base)
+					continue;
+
+				if (plane->front)
+					drm_buffer_release(plane->front);
+
+				plane->front = plane->back;
+				plane->back = NULL;
+			}
+		}
 	}
 
 	if (output->vblank_pending_count == 0) {
 		if (output->destroy_pending) {
 			drm_output_destroy(output);
 		} else {
+			/* The repaint is in progress until the frame finishes, damage added while
+			 * it runs would not schedule another one. */
+			if (pepper_region_not_empty(&output->overlay_damage)) {
+				pepper_output_add_damage_region(output->base, &output->overlay_damage);
+				pepper_region_clear(&output->overlay_damage);
+			}
+
 			ts.tv_sec = sec;
 			ts.tv_nsec = usec * 1000;
-			pepper_output_finish_frame(output->base, &ts);
+			pepper_output_finish_frame_presented(output->base, &ts, frame,
+												 DRM_PRESENT_FLAGS);
 		}
 	}
 }
@@ -48,6 +48,10 @@ drm_init_planes(pepper_drm_t *drm)
 		}
 		plane->drm = drm;
 		plane->id = plane->plane->plane_id;
+		plane->type = DRM_PLANE_TYPE_OVERLAY;
+
+		if (drm->atomic)
+			drm_plane_init_atomic(plane);
 
 		pepper_list_insert(drm->plane_list.prev, &plane->link);
 	}
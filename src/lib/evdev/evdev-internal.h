@@ -25,10 +25,30 @@
 #define PEPPER_EVDEV_INTERNAL_H
 
 #include <pepper.h>
+#include <linux/input.h>
 #include <pepper-evdev.h>
 
 #define MAX_PATH_LEN 16
 
+/* Key and button events of a device queued until the next SYN_REPORT */
+#define MAX_KEY_EVENTS 64
+
+/* Multitouch slots tracked per device, contacts in higher slots are ignored */
+#define MAX_TOUCH_SLOTS 10
+
+/* Changes accumulated in a frame until the next SYN_REPORT */
+#define EVDEV_FRAME_REL_MOTION (1 << 0)
+#define EVDEV_FRAME_ABS_MOTION (1 << 1)
+#define EVDEV_FRAME_AXIS       (1 << 2)
+#define EVDEV_FRAME_TOUCH      (1 << 3)
+
+/* Changes of a touch slot in a frame */
+#define EVDEV_TOUCH_DOWN   (1 << 0)
+#define EVDEV_TOUCH_MOTION (1 << 1)
+#define EVDEV_TOUCH_UP     (1 << 2)
+
+typedef struct evdev_touch_slot evdev_touch_slot_t;
+
 #ifndef BITS_PER_LONG
 #define BITS_PER_LONG (sizeof(unsigned long) * 8)
 #endif
@@ -38,10 +58,24 @@ struct pepper_evdev
        pepper_compositor_t *compositor;
        struct wl_display *display;
        struct wl_event_loop *event_loop;
-       pepper_list_t key_event_queue;
        pepper_list_t device_list;
 };
 
+struct evdev_key_event
+{
+       unsigned int keycode;
+       unsigned int state;
+       unsigned int time;
+};
+
+struct evdev_touch_slot
+{
+       int tracking_id;
+       int x, y;
+       unsigned int changes;
+       pepper_bool_t down;  /* as last posted */
+};
+
 struct evdev_device_info
 {
        pepper_evdev_t *evdev;
@@ -50,16 +84,30 @@ struct evdev_device_info
        int fd;
        char path[MAX_PATH_LEN];
        unsigned int caps;
-       pepper_list_t link;
-};
+       evdev_key_event_t key_events[MAX_KEY_EVENTS];
+       unsigned int num_key_events;
+
+       /* keys and buttons pressed as last posted */
+       unsigned long key_state[(KEY_CNT + BITS_PER_LONG - 1) / BITS_PER_LONG];
+
+       /* events are discarded until the next SYN_REPORT after a SYN_DROPPED */
+       pepper_bool_t dropped;
+
+       unsigned int frame_changes;
+
+       /* pointer */
+       int rel_x, rel_y;
+       int wheel, hwheel;
+       int abs_x, abs_y;
+
+       /* absolute axis ranges of an absolute pointer or a touchscreen */
+       struct input_absinfo absinfo_x, absinfo_y;
+
+       /* touch (single touch devices use slot 0) */
+       pepper_bool_t multitouch;
+       int slot;
+       evdev_touch_slot_t touch_slots[MAX_TOUCH_SLOTS];
 
-struct evdev_key_event
-{
-       pepper_evdev_t *evdev;
-       pepper_input_device_t *device;
-       unsigned int keycode;
-       unsigned int state;
-       unsigned int time;
        pepper_list_t link;
 };
 
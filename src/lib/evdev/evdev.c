@@ -65,52 +65,564 @@ _evdev_keyboard_event_post(pepper_input_device_t *device, uint32_t keycode, int
 }
 
 static void
-_evdev_keyboard_event_flush(pepper_evdev_t *evdev)
+_evdev_pointer_button_post(pepper_input_device_t *device, uint32_t button, int state, uint32_t time)
+{
+	pepper_input_event_t event;
+
+	event.time = time;
+	event.button = button;
+	event.state = state ? PEPPER_BUTTON_STATE_PRESSED : PEPPER_BUTTON_STATE_RELEASED;
+
+	pepper_object_emit_event((pepper_object_t *)device,
+								PEPPER_EVENT_INPUT_DEVICE_POINTER_BUTTON, &event);
+}
+
+static int
+_evdev_is_button(uint32_t code)
+{
+	return (code >= BTN_MISC && code < KEY_OK) || code >= BTN_TRIGGER_HAPPY;
+}
+
+static int
+bit_is_set(const unsigned long *array, int bit)
+{
+    return !!(array[bit / LONG_BITS] & (1LL << (bit % LONG_BITS)));
+}
+
+static void
+bit_set(unsigned long *array, int bit, int value)
+{
+	if (value)
+		array[bit / LONG_BITS] |= (1UL << (bit % LONG_BITS));
+	else
+		array[bit / LONG_BITS] &= ~(1UL << (bit % LONG_BITS));
+}
+
+static void
+_evdev_keyboard_event_flush(evdev_device_info_t *device_info)
 {
 	evdev_key_event_t *event = NULL;
-	evdev_key_event_t *tmp = NULL;
+	unsigned int i;
 
-	pepper_list_for_each_safe(event, tmp, &evdev->key_event_queue, link)
+	for (i = 0; i < device_info->num_key_events; i++)
 	{
-		_evdev_keyboard_event_post(event->device, event->keycode, event->state, event->time);
-		pepper_list_remove(&event->link);
-		free(event);
+		event = &device_info->key_events[i];
+
+		if (event->keycode < KEY_CNT)
+			bit_set(device_info->key_state, event->keycode, event->state);
+
+		if (!_evdev_is_button(event->keycode))
+		{
+			if (device_info->caps & WL_SEAT_CAPABILITY_KEYBOARD)
+				_evdev_keyboard_event_post(device_info->device, event->keycode, event->state, event->time);
+		}
+		else if (device_info->caps & WL_SEAT_CAPABILITY_POINTER)
+		{
+			_evdev_pointer_button_post(device_info->device, event->keycode, event->state, event->time);
+		}
 	}
+
+	device_info->num_key_events = 0;
 }
 
 static void
 _evdev_keyboard_event_queue(uint32_t keycode, int state, uint32_t time, evdev_device_info_t *device_info)
 {
 	evdev_key_event_t *event = NULL;
-	pepper_evdev_t *evdev = device_info->evdev;
 
-	event = (evdev_key_event_t *)calloc(1, sizeof(evdev_key_event_t));
-	PEPPER_CHECK(event, return, "[%s] Failed to allocate memory for key event.\n", __FUNCTION__);
+	/* Post what has been queued so far rather than dropping events of an overlong frame. */
+	if (device_info->num_key_events == MAX_KEY_EVENTS)
+		_evdev_keyboard_event_flush(device_info);
 
+	event = &device_info->key_events[device_info->num_key_events++];
 	event->keycode = keycode;
 	event->state = state;
 	event->time = time;
-	event->device = device_info->device;
+}
+
+/* Map a position in the absolute axis ranges of the device onto the first output. */
+static void
+_evdev_abs_transform(evdev_device_info_t *device_info, int x, int y, double *ox, double *oy)
+{
+	const pepper_list_t *output_list = pepper_compositor_get_output_list(device_info->evdev->compositor);
+	const pepper_output_geometry_t *geometry;
+	struct input_absinfo *ax = &device_info->absinfo_x;
+	struct input_absinfo *ay = &device_info->absinfo_y;
+
+	if (pepper_list_empty(output_list) || ax->maximum <= ax->minimum || ay->maximum <= ay->minimum)
+	{
+		*ox = x;
+		*oy = y;
+		return;
+	}
+
+	geometry = pepper_output_get_geometry((pepper_output_t *)output_list->next->item);
+
+	*ox = geometry->x + (double)(x - ax->minimum) * geometry->w / (ax->maximum - ax->minimum + 1);
+	*oy = geometry->y + (double)(y - ay->minimum) * geometry->h / (ay->maximum - ay->minimum + 1);
+}
+
+static void
+_evdev_touch_frame_post(evdev_device_info_t *device_info, uint32_t time)
+{
+	pepper_input_event_t event;
+	evdev_touch_slot_t *touch_slot;
+	int i;
+
+	event.time = time;
+
+	for (i = 0; i < MAX_TOUCH_SLOTS; i++)
+	{
+		touch_slot = &device_info->touch_slots[i];
+
+		if (!touch_slot->changes)
+			continue;
+
+		event.slot = i;
+		_evdev_abs_transform(device_info, touch_slot->x, touch_slot->y, &event.x, &event.y);
+
+		if (touch_slot->changes & EVDEV_TOUCH_DOWN)
+			pepper_object_emit_event((pepper_object_t *)device_info->device,
+										PEPPER_EVENT_INPUT_DEVICE_TOUCH_DOWN, &event);
+		else if (touch_slot->changes & EVDEV_TOUCH_MOTION)
+			pepper_object_emit_event((pepper_object_t *)device_info->device,
+										PEPPER_EVENT_INPUT_DEVICE_TOUCH_MOTION, &event);
+
+		if (touch_slot->changes & EVDEV_TOUCH_UP)
+			pepper_object_emit_event((pepper_object_t *)device_info->device,
+										PEPPER_EVENT_INPUT_DEVICE_TOUCH_UP, &event);
+
+		if (touch_slot->changes & EVDEV_TOUCH_UP)
+			touch_slot->down = PEPPER_FALSE;
+		else if (touch_slot->changes & EVDEV_TOUCH_DOWN)
+			touch_slot->down = PEPPER_TRUE;
+
+		touch_slot->changes = 0;
+	}
+
+	pepper_object_emit_event((pepper_object_t *)device_info->device,
+								PEPPER_EVENT_INPUT_DEVICE_TOUCH_FRAME, &event);
+}
+
+/* Post everything accumulated since the last SYN_REPORT as a single frame. */
+static void
+_evdev_frame_flush(evdev_device_info_t *device_info, uint32_t time)
+{
+	pepper_input_event_t event;
+	unsigned int changes = device_info->frame_changes;
+	int pointer_frame = 0;
+
+	event.time = time;
 
-	pepper_list_insert(&evdev->key_event_queue, &event->link);
+	if (changes & EVDEV_FRAME_REL_MOTION)
+	{
+		event.x = device_info->rel_x;
+		event.y = device_info->rel_y;
+		pepper_object_emit_event((pepper_object_t *)device_info->device,
+									PEPPER_EVENT_INPUT_DEVICE_POINTER_MOTION, &event);
+		pointer_frame = 1;
+	}
+
+	if (changes & EVDEV_FRAME_ABS_MOTION)
+	{
+		_evdev_abs_transform(device_info, device_info->abs_x, device_info->abs_y, &event.x, &event.y);
+		pepper_object_emit_event((pepper_object_t *)device_info->device,
+									PEPPER_EVENT_INPUT_DEVICE_POINTER_MOTION_ABSOLUTE, &event);
+		pointer_frame = 1;
+	}
+
+	if (device_info->num_key_events)
+	{
+		pointer_frame |= !!(device_info->caps & WL_SEAT_CAPABILITY_POINTER);
+		_evdev_keyboard_event_flush(device_info);
+	}
+
+	if (changes & EVDEV_FRAME_AXIS)
+	{
+		/* One wheel click scrolls by 10, positive values scroll down and right. */
+		if (device_info->wheel)
+		{
+			event.axis = PEPPER_POINTER_AXIS_VERTICAL;
+			event.value = -10.0 * device_info->wheel;
+			pepper_object_emit_event((pepper_object_t *)device_info->device,
+										PEPPER_EVENT_INPUT_DEVICE_POINTER_AXIS, &event);
+		}
+
+		if (device_info->hwheel)
+		{
+			event.axis = PEPPER_POINTER_AXIS_HORIZONTAL;
+			event.value = 10.0 * device_info->hwheel;
+			pepper_object_emit_event((pepper_object_t *)device_info->device,
+										PEPPER_EVENT_INPUT_DEVICE_POINTER_AXIS, &event);
+		}
+
+		pointer_frame = 1;
+	}
+
+	if (pointer_frame)
+		pepper_object_emit_event((pepper_object_t *)device_info->device,
+									PEPPER_EVENT_INPUT_DEVICE_POINTER_FRAME, &event);
+
+	if (changes & EVDEV_FRAME_TOUCH)
+		_evdev_touch_frame_post(device_info, time);
+
+	device_info->rel_x = device_info->rel_y = 0;
+	device_info->wheel = device_info->hwheel = 0;
+	device_info->frame_changes = 0;
+}
+
+static evdev_touch_slot_t *
+_evdev_current_touch_slot(evdev_device_info_t *device_info)
+{
+	if (device_info->slot < 0 || device_info->slot >= MAX_TOUCH_SLOTS)
+		return NULL;
+
+	return &device_info->touch_slots[device_info->slot];
+}
+
+static void
+_evdev_touch_slot_down(evdev_device_info_t *device_info, int tracking_id)
+{
+	evdev_touch_slot_t *touch_slot = _evdev_current_touch_slot(device_info);
+
+	if (!touch_slot)
+		return;
+
+	/* Lifted and put down again within a frame, seen as a motion. */
+	if (touch_slot->changes & EVDEV_TOUCH_UP)
+		touch_slot->changes = (touch_slot->changes & ~EVDEV_TOUCH_UP) | EVDEV_TOUCH_MOTION;
+	else
+		touch_slot->changes |= EVDEV_TOUCH_DOWN;
+
+	touch_slot->tracking_id = tracking_id;
+	device_info->frame_changes |= EVDEV_FRAME_TOUCH;
 }
 
 static void
-_evdev_keyboard_event_process(struct input_event *ev, evdev_device_info_t *device_info)
+_evdev_touch_slot_up(evdev_device_info_t *device_info)
+{
+	evdev_touch_slot_t *touch_slot = _evdev_current_touch_slot(device_info);
+
+	if (!touch_slot || touch_slot->tracking_id < 0)
+		return;
+
+	touch_slot->changes |= EVDEV_TOUCH_UP;
+	touch_slot->tracking_id = -1;
+	device_info->frame_changes |= EVDEV_FRAME_TOUCH;
+}
+
+static void
+_evdev_touch_slot_move(evdev_device_info_t *device_info, int code, int value)
+{
+	evdev_touch_slot_t *touch_slot = _evdev_current_touch_slot(device_info);
+
+	if (!touch_slot)
+		return;
+
+	if (code == ABS_MT_POSITION_X || code == ABS_X)
+		touch_slot->x = value;
+	else
+		touch_slot->y = value;
+
+	if (touch_slot->tracking_id >= 0)
+	{
+		touch_slot->changes |= EVDEV_TOUCH_MOTION;
+		device_info->frame_changes |= EVDEV_FRAME_TOUCH;
+	}
+}
+
+static void
+_evdev_key_event_process(struct input_event *ev, uint32_t timestamp, evdev_device_info_t *device_info)
+{
+	if (device_info->caps & WL_SEAT_CAPABILITY_TOUCH)
+	{
+		/* Contacts of a multitouch device are tracked with slots. */
+		if (ev->code == BTN_TOUCH && !device_info->multitouch)
+		{
+			device_info->slot = 0;
+
+			if (ev->value)
+				_evdev_touch_slot_down(device_info, 0);
+			else
+				_evdev_touch_slot_up(device_info);
+		}
+
+		/* BTN_TOUCH and the BTN_TOOL_* tool types are no button presses. */
+		if (ev->code >= BTN_DIGI && ev->code < BTN_WHEEL)
+			return;
+	}
+
+	_evdev_keyboard_event_queue((uint32_t)ev->code, ev->value, timestamp, device_info);
+}
+
+static void
+_evdev_rel_event_process(struct input_event *ev, evdev_device_info_t *device_info)
+{
+	switch (ev->code)
+	{
+		case REL_X:
+			device_info->rel_x += ev->value;
+			device_info->frame_changes |= EVDEV_FRAME_REL_MOTION;
+			break;
+
+		case REL_Y:
+			device_info->rel_y += ev->value;
+			device_info->frame_changes |= EVDEV_FRAME_REL_MOTION;
+			break;
+
+		case REL_WHEEL:
+			device_info->wheel += ev->value;
+			device_info->frame_changes |= EVDEV_FRAME_AXIS;
+			break;
+
+		case REL_HWHEEL:
+			device_info->hwheel += ev->value;
+			device_info->frame_changes |= EVDEV_FRAME_AXIS;
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void
+_evdev_abs_event_process(struct input_event *ev, evdev_device_info_t *device_info)
+{
+	if (device_info->caps & WL_SEAT_CAPABILITY_TOUCH)
+	{
+		switch (ev->code)
+		{
+			case ABS_MT_SLOT:
+				device_info->slot = ev->value;
+				break;
+
+			case ABS_MT_TRACKING_ID:
+				if (ev->value >= 0)
+					_evdev_touch_slot_down(device_info, ev->value);
+				else
+					_evdev_touch_slot_up(device_info);
+				break;
+
+			case ABS_MT_POSITION_X:
+			case ABS_MT_POSITION_Y:
+				_evdev_touch_slot_move(device_info, ev->code, ev->value);
+				break;
+
+			case ABS_X:
+			case ABS_Y:
+				if (!device_info->multitouch)
+				{
+					device_info->slot = 0;
+					_evdev_touch_slot_move(device_info, ev->code, ev->value);
+				}
+				break;
+
+			default:
+				break;
+		}
+
+		return;
+	}
+
+	switch (ev->code)
+	{
+		case ABS_X:
+			device_info->abs_x = ev->value;
+			device_info->frame_changes |= EVDEV_FRAME_ABS_MOTION;
+			break;
+
+		case ABS_Y:
+			device_info->abs_y = ev->value;
+			device_info->frame_changes |= EVDEV_FRAME_ABS_MOTION;
+			break;
+
+		default:
+			break;
+	}
+}
+
+/* Throw away the partial frame, it is incomplete after the kernel dropped events. */
+static void
+_evdev_frame_discard(evdev_device_info_t *device_info)
+{
+	int i;
+
+	device_info->num_key_events = 0;
+	device_info->rel_x = device_info->rel_y = 0;
+	device_info->wheel = device_info->hwheel = 0;
+	device_info->frame_changes = 0;
+
+	for (i = 0; i < MAX_TOUCH_SLOTS; i++)
+		device_info->touch_slots[i].changes = 0;
+}
+
+static void
+_evdev_touch_slot_resync(evdev_device_info_t *device_info, int slot, int tracking_id, int x, int y)
+{
+	evdev_touch_slot_t *touch_slot = &device_info->touch_slots[slot];
+
+	touch_slot->tracking_id = tracking_id;
+
+	if (tracking_id >= 0)
+	{
+		if (!touch_slot->down)
+			touch_slot->changes = EVDEV_TOUCH_DOWN;
+		else if (touch_slot->x != x || touch_slot->y != y)
+			touch_slot->changes = EVDEV_TOUCH_MOTION;
+
+		touch_slot->x = x;
+		touch_slot->y = y;
+	}
+	else if (touch_slot->down)
+	{
+		touch_slot->changes = EVDEV_TOUCH_UP;
+	}
+
+	if (touch_slot->changes)
+		device_info->frame_changes |= EVDEV_FRAME_TOUCH;
+}
+
+/* Bring keys, buttons and touch points up to the device state after a SYN_DROPPED,
+ * queueing the differences to what has been posted as the next frame. */
+static void
+_evdev_device_resync(evdev_device_info_t *device_info, uint32_t timestamp)
+{
+	unsigned long key_bits[NLONGS(KEY_CNT)] = {0, };
+	struct input_absinfo absinfo;
+	int i;
+
+	if (ioctl(device_info->fd, EVIOCGKEY(sizeof(key_bits)), key_bits) >= 0)
+	{
+		for (i = 0; i < KEY_CNT; i++)
+		{
+			int pressed = bit_is_set(key_bits, i);
+
+			if (pressed == bit_is_set(device_info->key_state, i))
+				continue;
+
+			/* Touch state is resynced from the slots below. */
+			if ((device_info->caps & WL_SEAT_CAPABILITY_TOUCH) && i >= BTN_DIGI && i < BTN_WHEEL)
+				continue;
+
+			_evdev_keyboard_event_queue(i, pressed, timestamp, device_info);
+		}
+	}
+	else
+		PEPPER_ERROR("Failed to get key state\n");
+
+	if (!(device_info->caps & WL_SEAT_CAPABILITY_TOUCH))
+	{
+		/* Absolute pointers only, the ranges are left empty for the others. */
+		if (device_info->absinfo_x.maximum <= device_info->absinfo_x.minimum)
+			return;
+
+		if (ioctl(device_info->fd, EVIOCGABS(ABS_X), &absinfo) >= 0 &&
+			absinfo.value != device_info->abs_x)
+		{
+			device_info->abs_x = absinfo.value;
+			device_info->frame_changes |= EVDEV_FRAME_ABS_MOTION;
+		}
+
+		if (ioctl(device_info->fd, EVIOCGABS(ABS_Y), &absinfo) >= 0 &&
+			absinfo.value != device_info->abs_y)
+		{
+			device_info->abs_y = absinfo.value;
+			device_info->frame_changes |= EVDEV_FRAME_ABS_MOTION;
+		}
+
+		return;
+	}
+
+	if (device_info->multitouch)
+	{
+		struct {
+			uint32_t code;
+			int32_t values[MAX_TOUCH_SLOTS];
+		} ids, xs, ys;
+
+		ids.code = ABS_MT_TRACKING_ID;
+		xs.code = ABS_MT_POSITION_X;
+		ys.code = ABS_MT_POSITION_Y;
+
+		if (ioctl(device_info->fd, EVIOCGMTSLOTS(sizeof(ids)), &ids) < 0 ||
+			ioctl(device_info->fd, EVIOCGMTSLOTS(sizeof(xs)), &xs) < 0 ||
+			ioctl(device_info->fd, EVIOCGMTSLOTS(sizeof(ys)), &ys) < 0)
+		{
+			/* Without the device state, lift everything rather than leave it stuck. */
+			PEPPER_ERROR("Failed to get multitouch slots\n");
+
+			for (i = 0; i < MAX_TOUCH_SLOTS; i++)
+				_evdev_touch_slot_resync(device_info, i, -1, 0, 0);
+
+			return;
+		}
+
+		for (i = 0; i < MAX_TOUCH_SLOTS; i++)
+			_evdev_touch_slot_resync(device_info, i, ids.values[i], xs.values[i], ys.values[i]);
+
+		if (ioctl(device_info->fd, EVIOCGABS(ABS_MT_SLOT), &absinfo) >= 0)
+			device_info->slot = absinfo.value;
+	}
+	else
+	{
+		evdev_touch_slot_t *touch_slot = &device_info->touch_slots[0];
+		int x = touch_slot->x, y = touch_slot->y;
+
+		if (ioctl(device_info->fd, EVIOCGABS(ABS_X), &absinfo) >= 0)
+			x = absinfo.value;
+
+		if (ioctl(device_info->fd, EVIOCGABS(ABS_Y), &absinfo) >= 0)
+			y = absinfo.value;
+
+		_evdev_touch_slot_resync(device_info, 0, bit_is_set(key_bits, BTN_TOUCH) ? 0 : -1, x, y);
+		device_info->slot = 0;
+	}
+}
+
+static void
+_evdev_event_process(struct input_event *ev, evdev_device_info_t *device_info)
 {
 	 uint32_t timestamp;
 
 	/* FIXME : need to think about using current time vs. time within event from kernel */
 	timestamp = ev->time.tv_sec * 1000 + ev->time.tv_usec / 1000;
 
+	if (device_info->dropped)
+	{
+		if (ev->type != EV_SYN || ev->code != SYN_REPORT)
+			return;
+
+		device_info->dropped = PEPPER_FALSE;
+		_evdev_device_resync(device_info, timestamp);
+		_evdev_frame_flush(device_info, timestamp);
+		return;
+	}
+
 	switch (ev->type)
 	{
 		case EV_KEY:
-			_evdev_keyboard_event_queue((uint32_t)ev->code, ev->value, timestamp, device_info);
+			_evdev_key_event_process(ev, timestamp, device_info);
+			break;
+
+		case EV_REL:
+			_evdev_rel_event_process(ev, device_info);
+			break;
+
+		case EV_ABS:
+			_evdev_abs_event_process(ev, device_info);
 			break;
 
 		case EV_SYN:
-			_evdev_keyboard_event_flush(device_info->evdev);
+			if (ev->code == SYN_REPORT)
+			{
+				_evdev_frame_flush(device_info, timestamp);
+			}
+			else if (ev->code == SYN_DROPPED)
+			{
+				PEPPER_TRACE("[%s] events dropped, resyncing %s\n", __FUNCTION__, device_info->path);
+				_evdev_frame_discard(device_info);
+				device_info->dropped = PEPPER_TRUE;
+			}
 			break;
 
 		default:
@@ -119,7 +631,7 @@ _evdev_keyboard_event_process(struct input_event *ev, evdev_device_info_t *devic
 }
 
 static int
-_evdev_keyboard_event_fd_read(int fd, uint32_t mask, void *data)
+_evdev_event_fd_read(int fd, uint32_t mask, void *data)
 {
 	uint32_t i;
 	int nread;
@@ -135,32 +647,43 @@ _evdev_keyboard_event_fd_read(int fd, uint32_t mask, void *data)
 	if (!(mask & WL_EVENT_READABLE))
 		return 0;
 
-	nread = read(fd, &ev, sizeof(ev));
-	PEPPER_CHECK(nread>=0, return 0, "[%s] Failed on reading given fd. (error : %s, fd:%d)\n",
-					__FUNCTION__, strerror_r(errno, buf, 128), fd);
-
-	for (i = 0 ; i < (nread / sizeof(ev[0])); i++)
+	/* Drain the fd at once instead of waking up again for every EVENT_MAX batch. */
+	for (;;)
 	{
-		_evdev_keyboard_event_process(&ev[i], device_info);
+		nread = read(fd, &ev, sizeof(ev));
+		if (nread < 0 && errno == EINTR)
+			continue;
+
+		if (nread < 0 && errno == EAGAIN)
+			break;
+
+		PEPPER_CHECK(nread>=0, return 0, "[%s] Failed on reading given fd. (error : %s, fd:%d)\n",
+						__FUNCTION__, strerror_r(errno, buf, 128), fd);
+
+		for (i = 0 ; i < (nread / sizeof(ev[0])); i++)
+		{
+			_evdev_event_process(&ev[i], device_info);
+		}
+
+		/* A short read means the kernel buffer is empty. */
+		if (nread < (int)sizeof(ev))
+			break;
 	}
 
 	return 0;
 }
 
-static int
-bit_is_set(const unsigned long *array, int bit)
-{
-    return !!(array[bit / LONG_BITS] & (1LL << (bit % LONG_BITS)));
-}
-
 static void
 _evdev_device_configure(evdev_device_info_t *device_info)
 {
 	int rc;
 	unsigned long bits[NLONGS(EV_CNT)] = {0, };
 	unsigned long key_bits[NLONGS(KEY_CNT)] = {0, };
+	unsigned long rel_bits[NLONGS(REL_CNT)] = {0, };
+	unsigned long abs_bits[NLONGS(ABS_CNT)] = {0, };
+	unsigned long prop_bits[NLONGS(INPUT_PROP_CNT)] = {0, };
 	unsigned long found = 0, i;
-	char device_name[256] = {0, };
+	struct input_absinfo absinfo;
 
 	rc = ioctl(device_info->fd, EVIOCGBIT(0, sizeof(bits)), bits);
 	PEPPER_CHECK(rc >= 0, return, "Failed to get event bits\n");
@@ -187,19 +710,54 @@ _evdev_device_configure(evdev_device_info_t *device_info)
 	}
 
 	if (bit_is_set(bits, EV_REL)) {
-		rc = ioctl(device_info->fd, EVIOCGNAME(sizeof(device_name) - 1), device_name);
+		rc = ioctl(device_info->fd, EVIOCGBIT(EV_REL, sizeof(rel_bits)), rel_bits);
 		if (rc >= 0) {
-			if (strcasestr(device_name, "mouse"))
+			if (bit_is_set(rel_bits, REL_X) && bit_is_set(rel_bits, REL_Y))
 				device_info->caps |= WL_SEAT_CAPABILITY_POINTER;
 		} else
-			PEPPER_ERROR("Failed to get device name\n");
+			PEPPER_ERROR("Failed to get rel bits\n");
+	}
+
+	if (bit_is_set(bits, EV_ABS)) {
+		rc = ioctl(device_info->fd, EVIOCGBIT(EV_ABS, sizeof(abs_bits)), abs_bits);
+		PEPPER_CHECK(rc >= 0, return, "Failed to get abs bits\n");
+
+		/* Touchpads are left to libinput. */
+		ioctl(device_info->fd, EVIOCGPROP(sizeof(prop_bits)), prop_bits);
+		if (bit_is_set(prop_bits, INPUT_PROP_POINTER))
+			return;
+
+		if (bit_is_set(abs_bits, ABS_MT_SLOT) &&
+			bit_is_set(abs_bits, ABS_MT_POSITION_X) && bit_is_set(abs_bits, ABS_MT_POSITION_Y)) {
+			/* multitouch protocol B */
+			device_info->multitouch = PEPPER_TRUE;
+			device_info->caps |= WL_SEAT_CAPABILITY_TOUCH;
+
+			ioctl(device_info->fd, EVIOCGABS(ABS_MT_POSITION_X), &device_info->absinfo_x);
+			ioctl(device_info->fd, EVIOCGABS(ABS_MT_POSITION_Y), &device_info->absinfo_y);
+
+			if (ioctl(device_info->fd, EVIOCGABS(ABS_MT_SLOT), &absinfo) >= 0)
+				device_info->slot = absinfo.value;
+		} else if (bit_is_set(abs_bits, ABS_X) && bit_is_set(abs_bits, ABS_Y)) {
+			if (bit_is_set(key_bits, BTN_TOUCH) && !bit_is_set(key_bits, BTN_TOOL_PEN))
+				device_info->caps |= WL_SEAT_CAPABILITY_TOUCH;
+			else if (bit_is_set(key_bits, BTN_LEFT))
+				device_info->caps |= WL_SEAT_CAPABILITY_POINTER;
+			else
+				return;
+
+			ioctl(device_info->fd, EVIOCGABS(ABS_X), &device_info->absinfo_x);
+			ioctl(device_info->fd, EVIOCGABS(ABS_Y), &device_info->absinfo_y);
+			device_info->abs_x = device_info->absinfo_x.value;
+			device_info->abs_y = device_info->absinfo_y.value;
+		}
 	}
 }
 
 static int
-_evdev_keyboard_device_open(pepper_evdev_t *evdev, const char *path)
+_evdev_device_open(pepper_evdev_t *evdev, const char *path, uint32_t caps)
 {
-	int fd;
+	int fd, i;
 	char device_path[32];
 	uint32_t event_mask;
 	evdev_device_info_t *device_info = NULL;
@@ -219,16 +777,20 @@ _evdev_keyboard_device_open(pepper_evdev_t *evdev, const char *path)
 	device_info->evdev = evdev;
 	strncpy(device_info->path, path, MAX_PATH_LEN - 1);
 
+	for (i = 0; i < MAX_TOUCH_SLOTS; i++)
+		device_info->touch_slots[i].tracking_id = -1;
+
 	_evdev_device_configure(device_info);
-	if (device_info->caps != WL_SEAT_CAPABILITY_KEYBOARD) goto error;
+	device_info->caps &= caps;
+	if (!device_info->caps) goto error;
 
-	device = pepper_input_device_create(evdev->compositor, WL_SEAT_CAPABILITY_KEYBOARD, NULL, NULL);
+	device = pepper_input_device_create(evdev->compositor, device_info->caps, NULL, NULL);
 	PEPPER_CHECK(device, goto error, "[%s] Failed to create pepper input device.\n", __FUNCTION__);
 
 	device_info->device = device;
 	event_mask = WL_EVENT_READABLE;
 	device_info->event_source = wl_event_loop_add_fd(evdev->event_loop,
-			fd, event_mask, _evdev_keyboard_event_fd_read, device_info);
+			fd, event_mask, _evdev_event_fd_read, device_info);
 	PEPPER_CHECK(device_info->event_source, goto error, "[%s] Failed to add fd as an event source...\n", __FUNCTION__);
 
 	pepper_list_insert(&evdev->device_list, &device_info->link);
@@ -258,7 +820,7 @@ error:
 }
 
 static void
-_evdev_keyboard_device_close(pepper_evdev_t *evdev, const char *path)
+_evdev_device_close(pepper_evdev_t *evdev, const char *path)
 {
 	evdev_device_info_t *device_info = NULL;
 
@@ -290,7 +852,8 @@ pepper_evdev_device_path_add(pepper_evdev_t *evdev, const char *path)
 	PEPPER_CHECK(path, return PEPPER_FALSE, "Invalid path.\n");
 
 	if (!strncmp(path, "event", 5)) {
-		res = _evdev_keyboard_device_open(evdev, path);
+		res = _evdev_device_open(evdev, path, WL_SEAT_CAPABILITY_KEYBOARD |
+								 WL_SEAT_CAPABILITY_POINTER | WL_SEAT_CAPABILITY_TOUCH);
 	} else {
 		PEPPER_ERROR("Invalid path to open: %s\n", path);
 	}
@@ -306,7 +869,7 @@ pepper_evdev_device_path_remove(pepper_evdev_t *evdev, const char *path)
 	PEPPER_CHECK(path, return, "Invalid path.\n");
 
 	if (!strncmp(path, "event", 5)) {
-		_evdev_keyboard_device_close(evdev, path);
+		_evdev_device_close(evdev, path);
 	} else {
 		PEPPER_ERROR("Invalid path to close: %s\n", path);
 	}
@@ -329,8 +892,7 @@ pepper_evdev_device_probe(pepper_evdev_t *evdev, uint32_t caps)
 		{
 			if (!strncmp(dir_entry->d_name, "event", 5))
 			{
-				if (caps & WL_SEAT_CAPABILITY_KEYBOARD)
-					probed += _evdev_keyboard_device_open(evdev, dir_entry->d_name);
+				probed += _evdev_device_open(evdev, dir_entry->d_name, caps);
 			}
 		}
 
@@ -354,7 +916,6 @@ pepper_evdev_create(pepper_compositor_t *compositor)
 	evdev->event_loop = wl_display_get_event_loop(evdev->display);
 
 	pepper_list_init(&evdev->device_list);
-	pepper_list_init(&evdev->key_event_queue);
 
 	return evdev;
 }
@@ -368,18 +929,14 @@ pepper_evdev_destroy(pepper_evdev_t *evdev)
 	if (!evdev)
 		return;
 
-	/* clean-up/destroy key event queue */
-	if (!pepper_list_empty(&evdev->key_event_queue))
-	{
-		_evdev_keyboard_event_flush(evdev);
-		pepper_list_remove(&evdev->key_event_queue);
-	}
-
 	/* clean-up/destory device list */
 	if (!pepper_list_empty(&evdev->device_list))
 	{
 		pepper_list_for_each_safe(device_info, tmp, &evdev->device_list, link)
 		{
+			/* post key events of an unfinished frame */
+			_evdev_keyboard_event_flush(device_info);
+
 			if (device_info->device)
 				pepper_input_device_destroy(device_info->device);
 			if (device_info->event_source)
@@ -54,6 +54,12 @@ pepper_fbdev_create(pepper_compositor_t *compositor, struct udev *udev,
 	fbdev->udev = udev;
 	pepper_list_init(&fbdev->output_list);
 
+	/* Frame times are taken from CLOCK_MONOTONIC. */
+	if (!pepper_compositor_set_clock_id(compositor, CLOCK_MONOTONIC)) {
+		PEPPER_ERROR("Failed to set clock id in %s\n", __FUNCTION__);
+		goto error;
+	}
+
 	if (!pepper_fbdev_output_create(fbdev, renderer)) {
 		PEPPER_ERROR("Failed to connect fbdev output in %s\n", __FUNCTION__);
 		goto error;
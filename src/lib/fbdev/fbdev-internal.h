@@ -30,6 +30,7 @@
 #define FBDEV_INTERNAL_H
 
 #include <pixman.h>
+#include <pthread.h>
 
 #include <pepper-output-backend.h>
 #include <pepper-libinput.h>
@@ -66,13 +67,36 @@ struct fbdev_output {
 	int                         w, h;
 	int                         bpp;
 	int                         stride;
+	int32_t                     refresh;
+
+	int                         fd;
 
 	void                       *frame_buffer_pixels;
 	pixman_image_t             *frame_buffer_image;
 	pixman_image_t             *shadow_image;
 	pepper_bool_t               use_shadow;
-
-	struct wl_event_source     *frame_done_timer;
+	pepper_bool_t               use_nt_copy;
+
+	/* Frame done pacing, FBIO_WAITFORVSYNC on a thread or a timer on the refresh grid. */
+	struct {
+		int64_t                 period;
+		int64_t                 next_vblank;
+
+		int                     timer_fd;
+		struct wl_event_source *timer_source;
+
+		pepper_bool_t           use_vsync;
+		pepper_bool_t           has_thread;
+		pthread_t               thread;
+		pthread_mutex_t         mutex;
+		pthread_cond_t          cond;
+		pepper_bool_t           requested;
+		pepper_bool_t           quit;
+		pepper_bool_t           vsync_failed;
+		struct timespec         vblank;
+		int                     event_fd;
+		struct wl_event_source *event_source;
+	} pacing;
 
 	pepper_plane_t             *primary_plane;
 	/* TODO */
@@ -84,4 +108,13 @@ pepper_fbdev_output_create(pepper_fbdev_t *fbdev, const char *renderer);
 void
 pepper_fbdev_output_destroy(fbdev_output_t *output);
 
+pepper_bool_t
+pepper_fbdev_output_init_pacing(fbdev_output_t *output);
+
+void
+pepper_fbdev_output_fini_pacing(fbdev_output_t *output);
+
+void
+pepper_fbdev_output_schedule_frame_done(fbdev_output_t *output);
+
 #endif /* FBDEV_INTERNAL_H */
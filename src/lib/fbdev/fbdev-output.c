@@ -39,6 +39,10 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <pepper-pixman-renderer.h>
 #include <pepper-gl-renderer.h>
 #include <pepper-utils-pixman.h>
@@ -118,8 +122,7 @@ fbdev_output_destroy(void *o)
 
 	pepper_list_remove(&output->link);
 
-	if (output->frame_done_timer)
-		wl_event_source_remove(output->frame_done_timer);
+	pepper_fbdev_output_fini_pacing(output);
 
 	if (output->render_target)
 		pepper_render_target_destroy(output->render_target);
@@ -133,6 +136,9 @@ fbdev_output_destroy(void *o)
 	if (output->frame_buffer_pixels)
 		munmap(output->frame_buffer_pixels, output->h * output->stride);
 
+	if (output->fd >= 0)
+		close(output->fd);
+
 	free(output);
 }
 
@@ -172,7 +178,7 @@ fbdev_output_get_mode(void *o, int index, pepper_output_mode_t *mode)
 	mode->flags = WL_OUTPUT_MODE_CURRENT | WL_OUTPUT_MODE_PREFERRED;
 	mode->w = output->w;
 	mode->h = output->h;
-	mode->refresh = 60000;
+	mode->refresh = output->refresh;
 }
 
 static pepper_bool_t
@@ -204,6 +210,99 @@ fbdev_output_start_repaint_loop(void *o)
 
 }
 
+static void
+fbdev_copy_row_nt(uint8_t *dst, const uint8_t *src, size_t size)
+{
+#ifdef __SSE2__
+	/* Stream whole 16 byte chunks around the cache, the mapping is rarely read back. */
+	size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+
+	if (head > size)
+		head = size;
+
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	size -= head;
+
+	while (size >= 64) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src +  0));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+		__m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+		__m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+
+		_mm_stream_si128((__m128i *)(dst +  0), a);
+		_mm_stream_si128((__m128i *)(dst + 16), b);
+		_mm_stream_si128((__m128i *)(dst + 32), c);
+		_mm_stream_si128((__m128i *)(dst + 48), d);
+
+		dst += 64;
+		src += 64;
+		size -= 64;
+	}
+
+	while (size >= 16) {
+		_mm_stream_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+		dst += 16;
+		src += 16;
+		size -= 16;
+	}
+#endif
+
+	memcpy(dst, src, size);
+}
+
+static void
+fbdev_output_copy_shadow(fbdev_output_t *output, pepper_region_t *damage)
+{
+	uint8_t        *src = (uint8_t *)pixman_image_get_data(output->shadow_image);
+	uint8_t        *dst = output->frame_buffer_pixels;
+	int             src_stride = pixman_image_get_stride(output->shadow_image);
+	int             cpp = output->bpp / 8;
+	int             i, y, nrects;
+	pepper_box_t   *rects;
+
+	if (output->bpp != (int)PEPPER_FORMAT_BPP(output->format)) {
+		/* The row copy below assumes bpp / 8 bytes per pixel, which doesn't hold
+		 * here. Both images share the pixel format, so let pixman copy the damage. */
+		pixman_image_set_clip_region32(output->frame_buffer_image,
+									   (pixman_region32_t *)damage);
+		pixman_image_composite32(PIXMAN_OP_SRC, output->shadow_image, NULL,
+								 output->frame_buffer_image, 0, 0, 0, 0, 0, 0,
+								 output->w, output->h);
+		pixman_image_set_clip_region32(output->frame_buffer_image, NULL);
+		return;
+	}
+
+	rects = pepper_region_rectangles(damage, &nrects);
+
+	for (i = 0; i < nrects; i++) {
+		int     x1 = rects[i].x1 < 0 ? 0 : rects[i].x1;
+		int     y1 = rects[i].y1 < 0 ? 0 : rects[i].y1;
+		int     x2 = rects[i].x2 > output->w ? output->w : rects[i].x2;
+		int     y2 = rects[i].y2 > output->h ? output->h : rects[i].y2;
+		size_t  size = (x2 - x1) * cpp;
+
+		if (x1 >= x2 || y1 >= y2)
+			continue;
+
+		for (y = y1; y < y2; y++) {
+			uint8_t *d = dst + y * output->stride + x1 * cpp;
+			uint8_t *s = src + y * src_stride + x1 * cpp;
+
+			if (output->use_nt_copy)
+				fbdev_copy_row_nt(d, s, size);
+			else
+				memcpy(d, s, size);
+		}
+	}
+
+#ifdef __SSE2__
+	if (output->use_nt_copy)
+		_mm_sfence();
+#endif
+}
+
 static void
 fbdev_output_repaint(void *o, const pepper_list_t *plane_list)
 {
@@ -219,17 +318,16 @@ fbdev_output_repaint(void *o, const pepper_list_t *plane_list)
 
 			pepper_renderer_repaint_output(output->renderer, output->base, render_list,
 										   damage);
-			pepper_plane_clear_damage_region(plane);
 
-			/* FIXME: composite with damage? */
+			/* The frame buffer holds the previous frame, only the damage is stale. */
 			if (output->use_shadow)
-				pixman_image_composite32(PIXMAN_OP_SRC, output->shadow_image, NULL,
-										 output->frame_buffer_image, 0, 0, 0, 0, 0, 0,
-										 output->w, output->h);
+				fbdev_output_copy_shadow(output, damage);
+
+			pepper_plane_clear_damage_region(plane);
 		}
 	}
 
-	wl_event_source_timer_update(output->frame_done_timer, 16);
+	pepper_fbdev_output_schedule_frame_done(output);
 }
 
 static void
@@ -242,8 +340,10 @@ static void
 fbdev_output_flush_surface_damage(void *o, pepper_surface_t *surface,
 								  pepper_bool_t *keep_buffer)
 {
-	pepper_renderer_flush_surface_damage(((fbdev_output_t *)o)->renderer, surface);
-	*keep_buffer = PEPPER_TRUE;
+	pepper_renderer_t *renderer = ((fbdev_output_t *)o)->renderer;
+
+	pepper_renderer_flush_surface_damage(renderer, surface);
+	*keep_buffer = !pepper_renderer_has_surface_copy(renderer, surface);
 }
 
 struct pepper_output_backend fbdev_output_backend = {
@@ -299,12 +399,25 @@ init_renderer(fbdev_output_t *output, const char *renderer)
 	return init_pixman_renderer(output);
 }
 
-static int
-frame_done_handler(void *data)
+static int32_t
+get_refresh_rate(const struct fb_var_screeninfo *info)
 {
-	fbdev_output_t *output = (fbdev_output_t *)data;
-	pepper_output_finish_frame(output->base, NULL);
-	return 1;
+	uint64_t htotal = info->xres + info->left_margin + info->right_margin +
+					  info->hsync_len;
+	uint64_t vtotal = info->yres + info->upper_margin + info->lower_margin +
+					  info->vsync_len;
+	uint64_t refresh;
+
+	if (info->pixclock == 0 || htotal == 0 || vtotal == 0)
+		return 60000;
+
+	/* pixclock is in picoseconds per pixel, refresh in mHz. */
+	refresh = 1000000000000000ULL / (info->pixclock * htotal * vtotal);
+
+	if (refresh < 1000 || refresh > 1000000)
+		return 60000;
+
+	return (int32_t)refresh;
 }
 
 pepper_bool_t
@@ -315,9 +428,6 @@ pepper_fbdev_output_create(pepper_fbdev_t *fbdev, const char *renderer)
 	struct fb_fix_screeninfo    fixed_info;
 	struct fb_var_screeninfo    var_info;
 
-	struct wl_display          *display;
-	struct wl_event_loop       *loop;
-
 	/* fbdev open */
 	fd = open("/dev/fb0"/*FIXME*/, O_RDWR | O_CLOEXEC);
 	if (fd < 0) {
@@ -346,6 +456,9 @@ pepper_fbdev_output_create(pepper_fbdev_t *fbdev, const char *renderer)
 	}
 
 	output->fbdev = fbdev;
+	output->fd = -1;
+	output->pacing.timer_fd = -1;
+	output->pacing.event_fd = -1;
 	pepper_list_init(&output->link);
 
 	output->format = PEPPER_FORMAT_XRGB8888;
@@ -354,6 +467,7 @@ pepper_fbdev_output_create(pepper_fbdev_t *fbdev, const char *renderer)
 	output->h = var_info.yres;
 	output->bpp = var_info.bits_per_pixel;
 	output->stride = output->w * (output->bpp / 8);
+	output->refresh = get_refresh_rate(&var_info);
 
 	output->frame_buffer_pixels = mmap(NULL, output->h * output->stride,
 									   PROT_WRITE, MAP_SHARED, fd, 0);
@@ -362,13 +476,18 @@ pepper_fbdev_output_create(pepper_fbdev_t *fbdev, const char *renderer)
 		goto error;
 	}
 
-	close(fd);
+	/* Kept open for FBIO_WAITFORVSYNC. */
+	output->fd = fd;
 	fd = -1;
 
 	/* TODO: read & set output->use_shadow value from somewhere */
 	output->use_shadow = PEPPER_TRUE;
 	if (output->use_shadow) {
-		pixman_format_code_t pixman_format = pepper_get_pixman_format(output->format);
+		const char             *env = getenv("PEPPER_FBDEV_NT_COPY");
+		pixman_format_code_t    pixman_format = pepper_get_pixman_format(output->format);
+
+		if (env && atoi(env) == 1)
+			output->use_nt_copy = PEPPER_TRUE;
 
 		output->frame_buffer_image = pixman_image_create_bits(pixman_format,
 									 output->w, output->h,
@@ -406,10 +525,10 @@ pepper_fbdev_output_create(pepper_fbdev_t *fbdev, const char *renderer)
 	output->primary_plane = pepper_output_add_plane(output->base, NULL);
 	pepper_list_insert(&fbdev->output_list, &output->link);
 
-	display = pepper_compositor_get_display(fbdev->compositor);
-	loop = wl_display_get_event_loop(display);
-	output->frame_done_timer = wl_event_loop_add_timer(loop, frame_done_handler,
-							   output);
+	if (!pepper_fbdev_output_init_pacing(output)) {
+		PEPPER_ERROR("Failed to initialize frame pacing in %s\n", __FUNCTION__);
+		goto error;
+	}
 
 	return PEPPER_TRUE;
 
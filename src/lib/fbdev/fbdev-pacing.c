@@ -0,0 +1,277 @@
+/*
+* Copyright © 2008-2012 Kristian Høgsberg
+* Copyright © 2010-2012 Intel Corporation
+* Copyright © 2011 Benjamin Franzke
+* Copyright © 2012 Collabora, Ltd.
+* Copyright © 2015 S-Core Corporation
+* Copyright © 2015-2016 Samsung Electronics co., Ltd. All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <errno.h>
+#include <linux/fb.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fbdev-internal.h"
+
+#ifndef FBIO_WAITFORVSYNC
+#define FBIO_WAITFORVSYNC   _IOW('F', 0x20, uint32_t)
+#endif
+
+#define NSEC_PER_SEC        1000000000LL
+
+static int64_t
+timespec_to_nsec(const struct timespec *ts)
+{
+	return (int64_t)ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static void
+timespec_from_nsec(struct timespec *ts, int64_t nsec)
+{
+	ts->tv_sec = nsec / NSEC_PER_SEC;
+	ts->tv_nsec = nsec % NSEC_PER_SEC;
+}
+
+static void
+pacing_finish_frame(fbdev_output_t *output, const struct timespec *ts,
+					uint32_t flags)
+{
+	struct timespec time = *ts;
+
+	pepper_output_finish_frame_presented(output->base, &time, 0, flags);
+}
+
+static void *
+vsync_thread(void *data)
+{
+	fbdev_output_t *output = data;
+	uint64_t        value = 1;
+
+	pthread_mutex_lock(&output->pacing.mutex);
+
+	while (!output->pacing.quit) {
+		uint32_t        crtc = 0;
+		struct timespec ts;
+		int             ret;
+
+		if (!output->pacing.requested) {
+			pthread_cond_wait(&output->pacing.cond, &output->pacing.mutex);
+			continue;
+		}
+
+		pthread_mutex_unlock(&output->pacing.mutex);
+		ret = ioctl(output->fd, FBIO_WAITFORVSYNC, &crtc);
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		pthread_mutex_lock(&output->pacing.mutex);
+
+		output->pacing.requested = PEPPER_FALSE;
+		output->pacing.vblank = ts;
+
+		/* Let the main loop fall back to the timer if the driver gives up. */
+		if (ret < 0)
+			output->pacing.vsync_failed = PEPPER_TRUE;
+
+		if (write(output->pacing.event_fd, &value, sizeof(value)) < 0)
+			PEPPER_ERROR("Failed to signal vblank.\n");
+	}
+
+	pthread_mutex_unlock(&output->pacing.mutex);
+	return NULL;
+}
+
+static int
+handle_vsync_event(int fd, uint32_t mask, void *data)
+{
+	fbdev_output_t *output = data;
+	uint64_t        value;
+	struct timespec ts;
+	pepper_bool_t   failed;
+
+	if (read(fd, &value, sizeof(value)) < 0)
+		return 0;
+
+	pthread_mutex_lock(&output->pacing.mutex);
+	ts = output->pacing.vblank;
+	failed = output->pacing.vsync_failed;
+	pthread_mutex_unlock(&output->pacing.mutex);
+
+	if (failed && output->pacing.use_vsync) {
+		PEPPER_ERROR("FBIO_WAITFORVSYNC failed, falling back to timer pacing.\n");
+		output->pacing.use_vsync = PEPPER_FALSE;
+	}
+
+	output->pacing.next_vblank = timespec_to_nsec(&ts) + output->pacing.period;
+	pacing_finish_frame(output, &ts, failed ? 0 : PEPPER_OUTPUT_PRESENT_VSYNC);
+
+	return 0;
+}
+
+static int
+handle_timer_event(int fd, uint32_t mask, void *data)
+{
+	fbdev_output_t *output = data;
+	uint64_t        expirations;
+	struct timespec ts;
+
+	if (read(fd, &expirations, sizeof(expirations)) < 0)
+		return 0;
+
+	/* Report the predicted vblank rather than the wakeup time, so that
+	 * timer latency neither leaks into frame times nor accumulates. */
+	timespec_from_nsec(&ts, output->pacing.next_vblank);
+	output->pacing.next_vblank += output->pacing.period;
+	pacing_finish_frame(output, &ts, 0);
+
+	return 0;
+}
+
+static void
+schedule_timer(fbdev_output_t *output)
+{
+	struct itimerspec   its;
+	struct timespec     now;
+	int64_t             now_nsec, next = output->pacing.next_vblank;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	now_nsec = timespec_to_nsec(&now);
+
+	/* Skip the vblanks missed while idle or repainting, keeping the phase. */
+	if (next <= now_nsec)
+		next += ((now_nsec - next) / output->pacing.period + 1) * output->pacing.period;
+
+	output->pacing.next_vblank = next;
+
+	memset(&its, 0, sizeof(its));
+	timespec_from_nsec(&its.it_value, next);
+
+	if (timerfd_settime(output->pacing.timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+		PEPPER_ERROR("timerfd_settime() failed.\n");
+		pacing_finish_frame(output, &now, 0);
+	}
+}
+
+void
+pepper_fbdev_output_schedule_frame_done(fbdev_output_t *output)
+{
+	if (output->pacing.use_vsync) {
+		pthread_mutex_lock(&output->pacing.mutex);
+		output->pacing.requested = PEPPER_TRUE;
+		pthread_cond_signal(&output->pacing.cond);
+		pthread_mutex_unlock(&output->pacing.mutex);
+	} else {
+		schedule_timer(output);
+	}
+}
+
+static pepper_bool_t
+vsync_supported(int fd)
+{
+	uint32_t crtc = 0;
+
+	return ioctl(fd, FBIO_WAITFORVSYNC, &crtc) == 0;
+}
+
+pepper_bool_t
+pepper_fbdev_output_init_pacing(fbdev_output_t *output)
+{
+	struct wl_event_loop   *loop;
+	struct timespec         now;
+
+	loop = wl_display_get_event_loop(pepper_compositor_get_display(
+										 output->fbdev->compositor));
+
+	output->pacing.period = NSEC_PER_SEC * 1000 / output->refresh;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	output->pacing.next_vblank = timespec_to_nsec(&now);
+
+	output->pacing.timer_fd = timerfd_create(CLOCK_MONOTONIC,
+											 TFD_CLOEXEC | TFD_NONBLOCK);
+	PEPPER_CHECK(output->pacing.timer_fd >= 0, return PEPPER_FALSE,
+				 "timerfd_create() failed.\n");
+
+	output->pacing.timer_source = wl_event_loop_add_fd(loop, output->pacing.timer_fd,
+								  WL_EVENT_READABLE, handle_timer_event, output);
+	PEPPER_CHECK(output->pacing.timer_source, return PEPPER_FALSE,
+				 "wl_event_loop_add_fd() failed.\n");
+
+	if (!vsync_supported(output->fd))
+		return PEPPER_TRUE;
+
+	output->pacing.event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	PEPPER_CHECK(output->pacing.event_fd >= 0, return PEPPER_TRUE,
+				 "eventfd() failed, using timer pacing.\n");
+
+	output->pacing.event_source = wl_event_loop_add_fd(loop, output->pacing.event_fd,
+								  WL_EVENT_READABLE, handle_vsync_event, output);
+	PEPPER_CHECK(output->pacing.event_source, return PEPPER_TRUE,
+				 "wl_event_loop_add_fd() failed, using timer pacing.\n");
+
+	pthread_mutex_init(&output->pacing.mutex, NULL);
+	pthread_cond_init(&output->pacing.cond, NULL);
+
+	if (pthread_create(&output->pacing.thread, NULL, vsync_thread, output) != 0) {
+		PEPPER_ERROR("Failed to create vsync thread, using timer pacing.\n");
+		pthread_cond_destroy(&output->pacing.cond);
+		pthread_mutex_destroy(&output->pacing.mutex);
+		return PEPPER_TRUE;
+	}
+
+	output->pacing.has_thread = PEPPER_TRUE;
+	output->pacing.use_vsync = PEPPER_TRUE;
+
+	return PEPPER_TRUE;
+}
+
+void
+pepper_fbdev_output_fini_pacing(fbdev_output_t *output)
+{
+	if (output->pacing.has_thread) {
+		pthread_mutex_lock(&output->pacing.mutex);
+		output->pacing.quit = PEPPER_TRUE;
+		pthread_cond_signal(&output->pacing.cond);
+		pthread_mutex_unlock(&output->pacing.mutex);
+
+		pthread_join(output->pacing.thread, NULL);
+		pthread_cond_destroy(&output->pacing.cond);
+		pthread_mutex_destroy(&output->pacing.mutex);
+	}
+
+	if (output->pacing.event_source)
+		wl_event_source_remove(output->pacing.event_source);
+
+	if (output->pacing.event_fd >= 0)
+		close(output->pacing.event_fd);
+
+	if (output->pacing.timer_source)
+		wl_event_source_remove(output->pacing.timer_source);
+
+	if (output->pacing.timer_fd >= 0)
+		close(output->pacing.timer_fd);
+}
@@ -34,6 +34,14 @@
 
 typedef struct li_device            li_device_t;
 typedef struct li_device_property   li_device_property_t;
+typedef struct li_touch_point       li_touch_point_t;
+
+/* Touch points of a device batched until the touch frame event. */
+#define LI_TOUCH_MAX_POINTS 16
+
+#define LI_TOUCH_DOWN       (1 << 0)
+#define LI_TOUCH_MOTION     (1 << 1)
+#define LI_TOUCH_UP         (1 << 2)
 
 struct pepper_libinput {
 	pepper_compositor_t        *compositor;
@@ -42,15 +50,33 @@ struct pepper_libinput {
 	struct wl_event_source     *libinput_event_source;
 	int                         libinput_fd;
 
+	pepper_bool_t               touch_batching;
+
 	pepper_list_t               device_list;
 };
 
+struct li_touch_point {
+	uint32_t                    slot;
+	uint32_t                    changes;
+	uint32_t                    time;
+	double                      x, y;
+};
+
 struct li_device {
 	pepper_libinput_t          *input;
 	pepper_input_device_t      *base;
 
 	uint32_t                    caps;
 
+	/* Pointer events of the current dispatch batch end with a pointer frame. */
+	pepper_bool_t               pointer_frame;
+	uint32_t                    pointer_time;
+
+	struct {
+		li_touch_point_t        points[LI_TOUCH_MAX_POINTS];
+		int                     count;
+	} touch;
+
 	pepper_list_t               property_list;
 	pepper_list_t               link;
 };
@@ -207,6 +207,33 @@ device_removed(pepper_libinput_t *input,
 	li_device_destroy(device);
 }
 
+/* libinput has no pointer frame event, every pointer event read in one dispatch
+ * is taken as part of the same frame. */
+static void
+pointer_frame_queue(li_device_t *device, uint32_t time)
+{
+	device->pointer_frame = PEPPER_TRUE;
+	device->pointer_time = time;
+}
+
+static void
+pointer_frame_flush(pepper_libinput_t *input)
+{
+	li_device_t            *device;
+	pepper_input_event_t    event;
+
+	pepper_list_for_each(device, &input->device_list, link) {
+		if (!device->pointer_frame)
+			continue;
+
+		device->pointer_frame = PEPPER_FALSE;
+
+		event.time = device->pointer_time;
+		pepper_object_emit_event((pepper_object_t *)device->base,
+								 PEPPER_EVENT_INPUT_DEVICE_POINTER_FRAME, &event);
+	}
+}
+
 static void
 pointer_motion(struct libinput_device *libinput_device,
 			   struct libinput_event_pointer *pointer_event)
@@ -215,6 +242,7 @@ pointer_motion(struct libinput_device *libinput_device,
 	pepper_input_event_t    event;
 
 	event.time = libinput_event_pointer_get_time(pointer_event);
+	pointer_frame_queue(device, event.time);
 	event.x = libinput_event_pointer_get_dx(pointer_event);
 	event.y = libinput_event_pointer_get_dy(pointer_event);
 
@@ -230,6 +258,7 @@ pointer_motion_absolute(struct libinput_device *libinput_device,
 	pepper_input_event_t    event;
 
 	event.time = libinput_event_pointer_get_time(pointer_event);
+	pointer_frame_queue(device, event.time);
 	event.x = libinput_event_pointer_get_absolute_x_transformed(pointer_event, 1);
 	event.y = libinput_event_pointer_get_absolute_y_transformed(pointer_event, 1);
 
@@ -245,6 +274,7 @@ pointer_button(struct libinput_device *libinput_device,
 	pepper_input_event_t    event;
 
 	event.time = libinput_event_pointer_get_time(pointer_event);
+	pointer_frame_queue(device, event.time);
 	event.button = libinput_event_pointer_get_button(pointer_event);
 	event.state = libinput_event_pointer_get_button_state(pointer_event);
 
@@ -260,6 +290,7 @@ pointer_axis(struct libinput_device *libinput_device,
 	pepper_input_event_t    event;
 
 	event.time = libinput_event_pointer_get_time(pointer_event);
+	pointer_frame_queue(device, event.time);
 
 	if (libinput_event_pointer_has_axis(pointer_event,
 										LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL)) {
@@ -299,59 +330,140 @@ keyboard_key(struct libinput_device *libinput_device,
 }
 
 static void
-touch_down(struct libinput_device *libinput_device,
-		   struct libinput_event_touch *touch_event)
+touch_emit(li_device_t *device, uint32_t id, uint32_t time, uint32_t slot,
+		   double x, double y)
 {
-	li_device_t            *device = libinput_device_get_user_data(libinput_device);
 	pepper_input_event_t    event;
 
-	event.time = libinput_event_touch_get_time(touch_event);
-	event.slot = libinput_event_touch_get_seat_slot(touch_event);
-	event.x = libinput_event_touch_get_x_transformed(touch_event, 1);
-	event.y = libinput_event_touch_get_y_transformed(touch_event, 1);
+	event.time = time;
+	event.slot = slot;
+	event.x = x;
+	event.y = y;
 
-	pepper_object_emit_event((pepper_object_t *)device->base,
-							 PEPPER_EVENT_INPUT_DEVICE_TOUCH_DOWN, &event);
+	pepper_object_emit_event((pepper_object_t *)device->base, id, &event);
 }
 
+/* Emit the batched touch points, then the frame. */
 static void
-touch_up(struct libinput_device *libinput_device,
-		 struct libinput_event_touch *touch_event)
+touch_flush(li_device_t *device, uint32_t time)
 {
-	li_device_t            *device = libinput_device_get_user_data(libinput_device);
 	pepper_input_event_t    event;
+	int                     i;
+
+	for (i = 0; i < device->touch.count; i++) {
+		li_touch_point_t *point = &device->touch.points[i];
+
+		if (point->changes & LI_TOUCH_DOWN) {
+			touch_emit(device, PEPPER_EVENT_INPUT_DEVICE_TOUCH_DOWN, point->time,
+					   point->slot, point->x, point->y);
+		} else if (point->changes & LI_TOUCH_MOTION) {
+			touch_emit(device, PEPPER_EVENT_INPUT_DEVICE_TOUCH_MOTION, point->time,
+					   point->slot, point->x, point->y);
+		}
+
+		if (point->changes & LI_TOUCH_UP) {
+			touch_emit(device, PEPPER_EVENT_INPUT_DEVICE_TOUCH_UP, point->time,
+					   point->slot, point->x, point->y);
+		}
+	}
 
-	event.time = libinput_event_touch_get_time(touch_event);
-	event.slot = libinput_event_touch_get_seat_slot(touch_event);
+	device->touch.count = 0;
 
+	event.time = time;
 	pepper_object_emit_event((pepper_object_t *)device->base,
-							 PEPPER_EVENT_INPUT_DEVICE_TOUCH_UP, &event);
+							 PEPPER_EVENT_INPUT_DEVICE_TOUCH_FRAME, &event);
 }
 
+/* Merge a touch change into the batch of the current frame. Repeated motion
+ * of a point is merged into the latest position. */
 static void
-touch_motion(struct libinput_device *libinput_device,
-			 struct libinput_event_touch *touch_event)
+touch_queue(li_device_t *device, uint32_t change, uint32_t time, uint32_t slot,
+			double x, double y)
 {
+	li_touch_point_t   *point = NULL;
+	int                 i;
+
+	for (i = 0; i < device->touch.count; i++) {
+		if (device->touch.points[i].slot == slot) {
+			point = &device->touch.points[i];
+			break;
+		}
+	}
 
-	li_device_t            *device = libinput_device_get_user_data(libinput_device);
-	pepper_input_event_t    event;
+	/* A new contact in the slot of a lifted one can't be merged, send the
+	 * frame so far first. Same for a full batch. */
+	if ((point && change == LI_TOUCH_DOWN && (point->changes & LI_TOUCH_UP)) ||
+		(!point && device->touch.count == LI_TOUCH_MAX_POINTS)) {
+		touch_flush(device, time);
+		point = NULL;
+	}
 
-	event.time = libinput_event_touch_get_time(touch_event);
-	event.slot = libinput_event_touch_get_seat_slot(touch_event);
-	event.x = libinput_event_touch_get_x_transformed(touch_event, 1);
-	event.y = libinput_event_touch_get_y_transformed(touch_event, 1);
+	if (!point) {
+		point = &device->touch.points[device->touch.count++];
+		point->slot = slot;
+		point->changes = 0;
+	}
 
-	pepper_object_emit_event((pepper_object_t *)device->base,
-							 PEPPER_EVENT_INPUT_DEVICE_TOUCH_MOTION, &event);
+	point->changes |= change;
+	point->time = time;
+
+	/* Up has no position, keep the last one. */
+	if (change != LI_TOUCH_UP) {
+		point->x = x;
+		point->y = y;
+	}
+}
+
+static void
+touch_dispatch(li_device_t *device, uint32_t change, uint32_t id,
+			struct libinput_event_touch *touch_event)
+{
+	uint32_t    time = libinput_event_touch_get_time(touch_event);
+	uint32_t    slot = libinput_event_touch_get_seat_slot(touch_event);
+	double      x = 0.0, y = 0.0;
+
+	if (change != LI_TOUCH_UP) {
+		x = libinput_event_touch_get_x_transformed(touch_event, 1);
+		y = libinput_event_touch_get_y_transformed(touch_event, 1);
+	}
+
+	if (device->input->touch_batching)
+		touch_queue(device, change, time, slot, x, y);
+	else
+		touch_emit(device, id, time, slot, x, y);
+}
+
+static void
+touch_down(struct libinput_device *libinput_device,
+		   struct libinput_event_touch *touch_event)
+{
+	li_device_t *device = libinput_device_get_user_data(libinput_device);
+	touch_dispatch(device, LI_TOUCH_DOWN, PEPPER_EVENT_INPUT_DEVICE_TOUCH_DOWN, touch_event);
+}
+
+static void
+touch_up(struct libinput_device *libinput_device,
+		 struct libinput_event_touch *touch_event)
+{
+	li_device_t *device = libinput_device_get_user_data(libinput_device);
+	touch_dispatch(device, LI_TOUCH_UP, PEPPER_EVENT_INPUT_DEVICE_TOUCH_UP, touch_event);
+}
+
+static void
+touch_motion(struct libinput_device *libinput_device,
+			 struct libinput_event_touch *touch_event)
+{
+	li_device_t *device = libinput_device_get_user_data(libinput_device);
+	touch_dispatch(device, LI_TOUCH_MOTION, PEPPER_EVENT_INPUT_DEVICE_TOUCH_MOTION,
+				touch_event);
 }
 
 static void
 touch_frame(struct libinput_device *libinput_device,
 			struct libinput_event_touch *touch_event)
 {
-	li_device_t            *device = libinput_device_get_user_data(libinput_device);
-	pepper_object_emit_event((pepper_object_t *)device->base,
-							 PEPPER_EVENT_INPUT_DEVICE_TOUCH_FRAME, NULL);
+	li_device_t *device = libinput_device_get_user_data(libinput_device);
+	touch_flush(device, libinput_event_touch_get_time(touch_event));
 }
 
 static void
@@ -417,6 +529,8 @@ dispatch_events(pepper_libinput_t *input)
 		libinput_event_destroy(event);
 	}
 
+	pointer_frame_flush(input);
+
 	return 0;
 }
 
@@ -480,6 +594,36 @@ error:
 	return NULL;
 }
 
+/**
+ * Enable or disable batching of touch events
+ *
+ * @param input     libinput object
+ * @param enable    PEPPER_TRUE to batch touch events, PEPPER_FALSE to emit every touch event
+ *
+ * When batching is enabled, touch down, motion and up events of a device are held back until the
+ * touch frame event of libinput and emitted together right before the frame. Repeated motion of a
+ * touch point within a frame is merged into a single motion to the latest position. Batching is
+ * disabled by default.
+ */
+PEPPER_API void
+pepper_libinput_set_touch_batching(pepper_libinput_t *input, pepper_bool_t enable)
+{
+	input->touch_batching = enable;
+}
+
+/**
+ * Check if batching of touch events is enabled
+ *
+ * @param input     libinput object
+ *
+ * @return PEPPER_TRUE if touch events are batched, PEPPER_FALSE otherwise
+ */
+PEPPER_API pepper_bool_t
+pepper_libinput_get_touch_batching(pepper_libinput_t *input)
+{
+	return input->touch_batching;
+}
+
 PEPPER_API void
 pepper_libinput_destroy(pepper_libinput_t *input)
 {
@@ -44,6 +44,12 @@ pepper_libinput_create(pepper_compositor_t *compositor, struct udev *udev);
 PEPPER_API void
 pepper_libinput_destroy(pepper_libinput_t *input);
 
+PEPPER_API void
+pepper_libinput_set_touch_batching(pepper_libinput_t *input, pepper_bool_t enable);
+
+PEPPER_API pepper_bool_t
+pepper_libinput_get_touch_batching(pepper_libinput_t *input);
+
 #ifdef __cplusplus
 }
 #endif
@@ -188,6 +188,33 @@ pepper_compositor_schedule_repaint(pepper_compositor_t *compositor)
 		pepper_output_schedule_repaint(output);
 }
 
+void
+pepper_compositor_update_views(pepper_compositor_t *compositor)
+{
+	pepper_view_t *view;
+
+	/* Views are shared by all outputs, so update them only once per frame no matter how many
+	 * outputs are going to be repainted. */
+	if (!compositor->update_scheduled)
+		return;
+
+	compositor->update_scheduled = PEPPER_FALSE;
+
+	pepper_list_for_each(view, &compositor->view_list, compositor_link)
+		pepper_view_update(view);
+}
+
+void
+pepper_compositor_flush_pointer_motion(pepper_compositor_t *compositor)
+{
+	pepper_seat_t *seat;
+
+	pepper_list_for_each(seat, &compositor->seat_list, link) {
+		if (seat->pointer)
+			pepper_pointer_flush_motion(seat->pointer);
+	}
+}
+
 /**
  * Create a compositor with the given fd and socket name
  *
@@ -225,6 +252,7 @@ pepper_compositor_create_fd(const char *socket_name, int fd)
 	pepper_list_init(&compositor->seat_list);
 	pepper_list_init(&compositor->output_list);
 	pepper_list_init(&compositor->input_device_list);
+	pepper_view_grid_init(compositor);
 
 	compositor->display = wl_display_create();
 	PEPPER_CHECK(compositor->display, goto error, "wl_display_create() failed.\n");
@@ -271,6 +299,13 @@ pepper_compositor_create_fd(const char *socket_name, int fd)
 				 "pepper_subcompositor_create() failed.\n");
 
 	compositor->clock_id = CLOCK_MONOTONIC;
+
+	ret = pepper_presentation_init(compositor);
+	PEPPER_CHECK(ret, goto error, "pepper_presentation_init() failed.\n");
+
+	ret = pepper_linux_dmabuf_init(compositor);
+	PEPPER_CHECK(ret, goto error, "pepper_linux_dmabuf_init() failed.\n");
+
 	return compositor;
 
 error:
@@ -323,6 +358,9 @@ pepper_compositor_destroy(pepper_compositor_t *compositor)
 	if (compositor->subcomp)
 		pepper_subcompositor_destroy(compositor->subcomp);
 
+	pepper_presentation_fini(compositor);
+	pepper_linux_dmabuf_fini(compositor);
+
 	if (compositor->socket_name)
 		free(compositor->socket_name);
 
@@ -464,42 +502,7 @@ PEPPER_API pepper_view_t *
 pepper_compositor_pick_view(pepper_compositor_t *compositor,
 							double x, double y, double *vx, double *vy)
 {
-	pepper_view_t  *view;
-	int             ix = (int)x;
-	int             iy = (int)y;
-
-	pepper_list_for_each(view, &compositor->view_list, compositor_link) {
-		double  lx, ly;
-		int     ilx, ily;
-
-		if (!view->surface)
-			continue;
-
-		if (!pepper_region_contains_point(&view->bounding_region, ix, iy, NULL))
-			continue;
-
-		pepper_view_get_local_coordinate(view, x, y, &lx, &ly);
-
-		ilx = (int)lx;
-		ily = (int)ly;
-
-		if (ilx < 0 || ily < 0 || ilx >= view->w || ily >= view->h)
-			continue;
-
-		if (!pepper_region_contains_point(&view->surface->input_region, ilx, ily,
-											NULL))
-			continue;
-
-		if (vx)
-			*vx = lx;
-
-		if (vy)
-			*vy = ly;
-
-		return view;
-	}
-
-	return NULL;
+	return pepper_view_grid_pick(compositor, x, y, vx, vy);
 }
 
 /**
@@ -530,6 +533,9 @@ pepper_compositor_set_clock_id(pepper_compositor_t *compositor, clockid_t id)
 	compositor->clock_id = id;
 	compositor->clock_used = PEPPER_TRUE;
 
+	/* Presentation clock of bound clients follows the compositor clock. */
+	pepper_presentation_send_clock_id(compositor);
+
 	return PEPPER_TRUE;
 }
 
@@ -550,3 +556,36 @@ pepper_compositor_get_time(pepper_compositor_t *compositor, struct timespec *ts)
 	compositor->clock_used = PEPPER_TRUE;
 	return PEPPER_TRUE;
 }
+
+/**
+ * Enable or disable early release of client buffers
+ *
+ * @param compositor    compositor object
+ * @param enable        PEPPER_TRUE to enable, PEPPER_FALSE to disable
+ *
+ * When enabled, renderers that can keep their own copy of the surface contents (e.g. a shadow
+ * image in the pixman renderer) do so, and the buffer is released to the client right after the
+ * copy is made instead of when the next buffer is attached. Clients can then run with fewer
+ * buffers at the cost of the extra copy. Takes effect from the next attached buffer.
+ */
+PEPPER_API void
+pepper_compositor_set_early_buffer_release(pepper_compositor_t *compositor,
+										   pepper_bool_t enable)
+{
+	compositor->early_buffer_release = enable;
+}
+
+/**
+ * Get whether early release of client buffers is enabled
+ *
+ * @param compositor    compositor object
+ *
+ * @return PEPPER_TRUE if enabled, PEPPER_FALSE otherwise
+ *
+ * @see pepper_compositor_set_early_buffer_release()
+ */
+PEPPER_API pepper_bool_t
+pepper_compositor_get_early_buffer_release(pepper_compositor_t *compositor)
+{
+	return compositor->early_buffer_release;
+}
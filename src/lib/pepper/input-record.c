@@ -0,0 +1,740 @@
+/*
+* Copyright © 2015-2016 Samsung Electronics co., Ltd. All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "pepper-internal.h"
+#include <limits.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Input log format (host byte order, not meant to be portable across machines):
+ *
+ *   file header  : uint32_t magic, uint32_t version
+ *   each record  : input_record_header_t followed by the payload fields selected
+ *                  by get_event_fields() for EVENT records. Integer fields are
+ *                  stored as uint32_t, coordinates and axis values as double.
+ *
+ * DEVICE_ADD records carry the device caps in the id field and have no payload.
+ */
+#define INPUT_RECORD_MAGIC          0x52495050  /* "PPIR" */
+#define INPUT_RECORD_VERSION        1
+#define INPUT_RECORD_MAX_DEVICES    256
+
+/* Number of records dispatched per loop iteration when replaying at maximum speed. Clients
+ * get flushed between batches so that the replay also covers the protocol side. */
+#define INPUT_REPLAY_BATCH          1024
+
+enum {
+	INPUT_RECORD_DEVICE_ADD,
+	INPUT_RECORD_DEVICE_REMOVE,
+	INPUT_RECORD_EVENT,
+};
+
+enum {
+	FIELD_TIME      = (1 << 0),
+	FIELD_BUTTON    = (1 << 1),
+	FIELD_STATE     = (1 << 2),
+	FIELD_AXIS      = (1 << 3),
+	FIELD_KEY       = (1 << 4),
+	FIELD_SLOT      = (1 << 5),
+	FIELD_X         = (1 << 6),
+	FIELD_Y         = (1 << 7),
+	FIELD_VALUE     = (1 << 8),
+};
+
+typedef struct input_record_header  input_record_header_t;
+typedef struct input_record_entry   input_record_entry_t;
+
+struct input_record_header {
+	uint8_t     type;
+	uint8_t     device;
+	uint16_t    id;
+	uint32_t    delay;  /* usec since the previous record */
+};
+
+struct input_record_entry {
+	pepper_input_recorder_t    *recorder;
+	pepper_input_device_t      *device;
+	pepper_event_listener_t    *listener;
+};
+
+struct pepper_input_recorder {
+	pepper_compositor_t        *compositor;
+	FILE                       *file;
+	struct timespec             last;
+
+	pepper_event_listener_t    *add_listener;
+	pepper_event_listener_t    *remove_listener;
+
+	input_record_entry_t        devices[INPUT_RECORD_MAX_DEVICES];
+};
+
+static const struct {
+	uint32_t        id;
+	const char     *name;
+} replay_event_types[] = {
+	{ PEPPER_EVENT_INPUT_DEVICE_POINTER_MOTION_ABSOLUTE,  "pointer motion absolute" },
+	{ PEPPER_EVENT_INPUT_DEVICE_POINTER_MOTION,           "pointer motion" },
+	{ PEPPER_EVENT_INPUT_DEVICE_POINTER_BUTTON,           "pointer button" },
+	{ PEPPER_EVENT_INPUT_DEVICE_POINTER_AXIS,             "pointer axis" },
+	{ PEPPER_EVENT_INPUT_DEVICE_POINTER_FRAME,            "pointer frame" },
+	{ PEPPER_EVENT_INPUT_DEVICE_KEYBOARD_KEY,             "keyboard key" },
+	{ PEPPER_EVENT_INPUT_DEVICE_TOUCH_DOWN,               "touch down" },
+	{ PEPPER_EVENT_INPUT_DEVICE_TOUCH_UP,                 "touch up" },
+	{ PEPPER_EVENT_INPUT_DEVICE_TOUCH_MOTION,             "touch motion" },
+	{ PEPPER_EVENT_INPUT_DEVICE_TOUCH_FRAME,              "touch frame" },
+};
+
+#define REPLAY_EVENT_TYPES  (sizeof(replay_event_types) / sizeof(replay_event_types[0]))
+
+typedef struct replay_stats replay_stats_t;
+
+struct replay_stats {
+	uint32_t    count;
+	uint64_t    total_nsec;
+	uint64_t    max_nsec;
+};
+
+struct pepper_input_replay {
+	pepper_compositor_t                *compositor;
+
+	uint8_t                            *log;
+	size_t                              size;
+	size_t                              pos;
+
+	pepper_bool_t                       max_speed;
+	struct wl_event_source             *timer;
+	struct timespec                     start;
+	uint64_t                            offset;     /* usec of the last record since start */
+
+	pepper_input_device_t              *devices[INPUT_RECORD_MAX_DEVICES];
+
+	replay_stats_t                      stats[REPLAY_EVENT_TYPES];
+	pepper_bool_t                       finished;
+
+	pepper_input_replay_done_func_t     done;
+	void                               *data;
+};
+
+static uint32_t
+get_event_fields(uint32_t id)
+{
+	switch (id) {
+	case PEPPER_EVENT_INPUT_DEVICE_POINTER_MOTION_ABSOLUTE:
+	case PEPPER_EVENT_INPUT_DEVICE_POINTER_MOTION:
+		return FIELD_TIME | FIELD_X | FIELD_Y;
+	case PEPPER_EVENT_INPUT_DEVICE_POINTER_BUTTON:
+		return FIELD_TIME | FIELD_BUTTON | FIELD_STATE;
+	case PEPPER_EVENT_INPUT_DEVICE_POINTER_AXIS:
+		return FIELD_TIME | FIELD_AXIS | FIELD_VALUE;
+	case PEPPER_EVENT_INPUT_DEVICE_POINTER_FRAME:
+		return FIELD_TIME;
+	case PEPPER_EVENT_INPUT_DEVICE_KEYBOARD_KEY:
+		return FIELD_TIME | FIELD_KEY | FIELD_STATE;
+	case PEPPER_EVENT_INPUT_DEVICE_TOUCH_DOWN:
+	case PEPPER_EVENT_INPUT_DEVICE_TOUCH_MOTION:
+		return FIELD_TIME | FIELD_SLOT | FIELD_X | FIELD_Y;
+	case PEPPER_EVENT_INPUT_DEVICE_TOUCH_UP:
+		return FIELD_TIME | FIELD_SLOT;
+	case PEPPER_EVENT_INPUT_DEVICE_TOUCH_FRAME:
+		return FIELD_TIME;
+	}
+
+	return 0;
+}
+
+static size_t
+get_payload_size(uint32_t fields)
+{
+	size_t size = 0;
+
+	if (fields & FIELD_TIME)
+		size += sizeof(uint32_t);
+	if (fields & FIELD_BUTTON)
+		size += sizeof(uint32_t);
+	if (fields & FIELD_STATE)
+		size += sizeof(uint32_t);
+	if (fields & FIELD_AXIS)
+		size += sizeof(uint32_t);
+	if (fields & FIELD_KEY)
+		size += sizeof(uint32_t);
+	if (fields & FIELD_SLOT)
+		size += sizeof(uint32_t);
+	if (fields & FIELD_X)
+		size += sizeof(double);
+	if (fields & FIELD_Y)
+		size += sizeof(double);
+	if (fields & FIELD_VALUE)
+		size += sizeof(double);
+
+	return size;
+}
+
+static uint64_t
+timespec_diff_nsec(const struct timespec *a, const struct timespec *b)
+{
+	return (uint64_t)(a->tv_sec - b->tv_sec) * 1000000000ULL + a->tv_nsec - b->tv_nsec;
+}
+
+static void
+recorder_write_record(pepper_input_recorder_t *recorder, uint8_t type, uint8_t device,
+					  uint16_t id, const uint8_t *payload, size_t size)
+{
+	input_record_header_t   header;
+	struct timespec         now;
+	uint64_t                delay;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	delay = timespec_diff_nsec(&now, &recorder->last) / 1000;
+
+	if (delay > UINT32_MAX)
+		delay = UINT32_MAX;
+
+	recorder->last = now;
+
+	header.type = type;
+	header.device = device;
+	header.id = id;
+	header.delay = (uint32_t)delay;
+
+	if (fwrite(&header, sizeof(header), 1, recorder->file) != 1 ||
+		(size && fwrite(payload, size, 1, recorder->file) != 1))
+		PEPPER_ERROR("Failed to write input record.\n");
+}
+
+static void
+recorder_handle_device_event(pepper_event_listener_t *listener, pepper_object_t *object,
+							 uint32_t id, void *info, void *data)
+{
+	input_record_entry_t   *entry = data;
+	pepper_input_event_t    zero, *event = info;
+	uint8_t                 payload[sizeof(uint32_t) * 6 + sizeof(double) * 3];
+	uint8_t                *p = payload;
+	uint32_t                fields = get_event_fields(id);
+
+	if (!fields)
+		return;
+
+	if (!event) {
+		memset(&zero, 0x00, sizeof(zero));
+		event = &zero;
+	}
+
+#define WRITE_FIELD(flag, field)                            \
+	if (fields & flag) {                                    \
+		memcpy(p, &event->field, sizeof(event->field));     \
+		p += sizeof(event->field);                          \
+	}
+
+	WRITE_FIELD(FIELD_TIME, time);
+	WRITE_FIELD(FIELD_BUTTON, button);
+	WRITE_FIELD(FIELD_STATE, state);
+	WRITE_FIELD(FIELD_AXIS, axis);
+	WRITE_FIELD(FIELD_KEY, key);
+	WRITE_FIELD(FIELD_SLOT, slot);
+	WRITE_FIELD(FIELD_X, x);
+	WRITE_FIELD(FIELD_Y, y);
+	WRITE_FIELD(FIELD_VALUE, value);
+
+#undef WRITE_FIELD
+
+	recorder_write_record(entry->recorder, INPUT_RECORD_EVENT,
+						  entry - entry->recorder->devices, id, payload, p - payload);
+}
+
+static void
+recorder_add_device(pepper_input_recorder_t *recorder, pepper_input_device_t *device)
+{
+	input_record_entry_t   *entry = NULL;
+	int                     i;
+
+	for (i = 0; i < INPUT_RECORD_MAX_DEVICES; i++) {
+		if (!recorder->devices[i].device) {
+			entry = &recorder->devices[i];
+			break;
+		}
+	}
+
+	PEPPER_CHECK(entry, return, "Too many input devices to record.\n");
+
+	/* Record ahead of any other listener so that the log sees the event before a grab
+	 * or the keyrouter gets a chance to consume it. */
+	entry->listener = pepper_object_add_event_listener((pepper_object_t *)device,
+													   PEPPER_EVENT_ALL, INT_MAX,
+													   recorder_handle_device_event, entry);
+	PEPPER_CHECK(entry->listener, return, "Failed to add input device listener.\n");
+
+	entry->recorder = recorder;
+	entry->device = device;
+
+	recorder_write_record(recorder, INPUT_RECORD_DEVICE_ADD, i,
+						  pepper_input_device_get_caps(device), NULL, 0);
+}
+
+static void
+recorder_remove_device(pepper_input_recorder_t *recorder, pepper_input_device_t *device)
+{
+	int i;
+
+	for (i = 0; i < INPUT_RECORD_MAX_DEVICES; i++) {
+		input_record_entry_t *entry = &recorder->devices[i];
+
+		if (entry->device == device) {
+			pepper_event_listener_remove(entry->listener);
+			memset(entry, 0x00, sizeof(*entry));
+			recorder_write_record(recorder, INPUT_RECORD_DEVICE_REMOVE, i, 0, NULL, 0);
+			return;
+		}
+	}
+}
+
+static void
+recorder_handle_input_device_add(pepper_event_listener_t *listener,
+								 pepper_object_t *object,
+								 uint32_t id, void *info, void *data)
+{
+	recorder_add_device(data, info);
+}
+
+static void
+recorder_handle_input_device_remove(pepper_event_listener_t *listener,
+									pepper_object_t *object,
+									uint32_t id, void *info, void *data)
+{
+	recorder_remove_device(data, info);
+}
+
+/**
+ * Start recording input device events into a file
+ *
+ * @param compositor    compositor object
+ * @param path          path of the log file to write
+ *
+ * @return recorder object on success, NULL otherwise
+ *
+ * Every PEPPER_EVENT_INPUT_DEVICE_* event emitted on an input device of the compositor is
+ * written to the log together with the time elapsed since the previous one. Devices which
+ * already exist are recorded as if they were added when recording started. The log can be
+ * fed back with pepper_input_replay_create().
+ */
+PEPPER_API pepper_input_recorder_t *
+pepper_input_recorder_create(pepper_compositor_t *compositor, const char *path)
+{
+	pepper_input_recorder_t    *recorder;
+	pepper_input_device_t      *device;
+	uint32_t                    header[2] = { INPUT_RECORD_MAGIC, INPUT_RECORD_VERSION };
+
+	recorder = calloc(1, sizeof(pepper_input_recorder_t));
+	PEPPER_CHECK(recorder, return NULL, "calloc() failed.\n");
+
+	recorder->compositor = compositor;
+
+	recorder->file = fopen(path, "wb");
+	PEPPER_CHECK(recorder->file, goto error, "Failed to open %s.\n", path);
+
+	PEPPER_CHECK(fwrite(header, sizeof(header), 1, recorder->file) == 1, goto error,
+				 "Failed to write input log header.\n");
+
+	recorder->add_listener =
+		pepper_object_add_event_listener(&compositor->base,
+										 PEPPER_EVENT_COMPOSITOR_INPUT_DEVICE_ADD, 0,
+										 recorder_handle_input_device_add, recorder);
+	PEPPER_CHECK(recorder->add_listener, goto error, "Failed to add listener.\n");
+
+	recorder->remove_listener =
+		pepper_object_add_event_listener(&compositor->base,
+										 PEPPER_EVENT_COMPOSITOR_INPUT_DEVICE_REMOVE, 0,
+										 recorder_handle_input_device_remove, recorder);
+	PEPPER_CHECK(recorder->remove_listener, goto error, "Failed to add listener.\n");
+
+	clock_gettime(CLOCK_MONOTONIC, &recorder->last);
+
+	pepper_list_for_each(device, &compositor->input_device_list, link)
+	recorder_add_device(recorder, device);
+
+	return recorder;
+
+error:
+	pepper_input_recorder_destroy(recorder);
+	return NULL;
+}
+
+/**
+ * Stop recording and destroy the given recorder
+ *
+ * @param recorder  recorder object
+ */
+PEPPER_API void
+pepper_input_recorder_destroy(pepper_input_recorder_t *recorder)
+{
+	int i;
+
+	for (i = 0; i < INPUT_RECORD_MAX_DEVICES; i++) {
+		if (recorder->devices[i].listener)
+			pepper_event_listener_remove(recorder->devices[i].listener);
+	}
+
+	if (recorder->add_listener)
+		pepper_event_listener_remove(recorder->add_listener);
+
+	if (recorder->remove_listener)
+		pepper_event_listener_remove(recorder->remove_listener);
+
+	if (recorder->file)
+		fclose(recorder->file);
+
+	free(recorder);
+}
+
+static const char *
+replay_device_get_property(void *device, const char *key)
+{
+	return NULL;
+}
+
+static const pepper_input_device_backend_t replay_device_backend = {
+	replay_device_get_property,
+};
+
+static replay_stats_t *
+replay_get_stats(pepper_input_replay_t *replay, uint32_t id)
+{
+	unsigned int i;
+
+	for (i = 0; i < REPLAY_EVENT_TYPES; i++) {
+		if (replay_event_types[i].id == id)
+			return &replay->stats[i];
+	}
+
+	return NULL;
+}
+
+static pepper_bool_t
+replay_emit_event(pepper_input_replay_t *replay, const input_record_header_t *header,
+				  const uint8_t *payload)
+{
+	pepper_input_device_t  *device = replay->devices[header->device];
+	pepper_input_event_t    event;
+	replay_stats_t         *stats = replay_get_stats(replay, header->id);
+	uint32_t                fields = get_event_fields(header->id);
+	struct timespec         begin, end;
+	uint64_t                nsec;
+
+	PEPPER_CHECK(stats && fields, return PEPPER_FALSE,
+				 "Unknown input event id %d in the log.\n", header->id);
+
+	if (!device)
+		return PEPPER_TRUE;
+
+	memset(&event, 0x00, sizeof(event));
+
+#define READ_FIELD(flag, field)                             \
+	if (fields & flag) {                                    \
+		memcpy(&event.field, payload, sizeof(event.field)); \
+		payload += sizeof(event.field);                     \
+	}
+
+	READ_FIELD(FIELD_TIME, time);
+	READ_FIELD(FIELD_BUTTON, button);
+	READ_FIELD(FIELD_STATE, state);
+	READ_FIELD(FIELD_AXIS, axis);
+	READ_FIELD(FIELD_KEY, key);
+	READ_FIELD(FIELD_SLOT, slot);
+	READ_FIELD(FIELD_X, x);
+	READ_FIELD(FIELD_Y, y);
+	READ_FIELD(FIELD_VALUE, value);
+
+#undef READ_FIELD
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	pepper_object_emit_event((pepper_object_t *)device, header->id, &event);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	nsec = timespec_diff_nsec(&end, &begin);
+
+	stats->count++;
+	stats->total_nsec += nsec;
+
+	if (nsec > stats->max_nsec)
+		stats->max_nsec = nsec;
+
+	return PEPPER_TRUE;
+}
+
+static pepper_bool_t
+replay_dispatch_record(pepper_input_replay_t *replay)
+{
+	input_record_header_t   header;
+	size_t                  size = 0;
+
+	memcpy(&header, replay->log + replay->pos, sizeof(header));
+
+	if (header.type == INPUT_RECORD_EVENT)
+		size = get_payload_size(get_event_fields(header.id));
+
+	PEPPER_CHECK(replay->pos + sizeof(header) + size <= replay->size, return PEPPER_FALSE,
+				 "Truncated input record.\n");
+
+	replay->pos += sizeof(header);
+	replay->offset += header.delay;
+
+	switch (header.type) {
+	case INPUT_RECORD_DEVICE_ADD:
+		if (replay->devices[header.device])
+			pepper_input_device_destroy(replay->devices[header.device]);
+
+		replay->devices[header.device] =
+			pepper_input_device_create(replay->compositor, header.id,
+									   &replay_device_backend, replay);
+		PEPPER_CHECK(replay->devices[header.device], return PEPPER_FALSE,
+					 "Failed to create replay input device.\n");
+		break;
+	case INPUT_RECORD_DEVICE_REMOVE:
+		if (replay->devices[header.device]) {
+			pepper_input_device_destroy(replay->devices[header.device]);
+			replay->devices[header.device] = NULL;
+		}
+		break;
+	case INPUT_RECORD_EVENT:
+		if (!replay_emit_event(replay, &header, replay->log + replay->pos))
+			return PEPPER_FALSE;
+		break;
+	default:
+		PEPPER_ERROR("Unknown input record type %d.\n", header.type);
+		return PEPPER_FALSE;
+	}
+
+	replay->pos += size;
+	return PEPPER_TRUE;
+}
+
+static void
+replay_report(pepper_input_replay_t *replay)
+{
+	struct timespec now;
+	uint64_t        elapsed;
+	uint32_t        total = 0;
+	unsigned int    i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = timespec_diff_nsec(&now, &replay->start);
+
+	for (i = 0; i < REPLAY_EVENT_TYPES; i++)
+		total += replay->stats[i].count;
+
+	PEPPER_TRACE("Input replay: %u events in %.3f s (%.0f events/s)\n", total,
+				 elapsed / 1e9, elapsed ? total * 1e9 / elapsed : 0.0);
+
+	for (i = 0; i < REPLAY_EVENT_TYPES; i++) {
+		replay_stats_t *stats = &replay->stats[i];
+
+		if (!stats->count)
+			continue;
+
+		PEPPER_TRACE("  %-24s %8u events, avg %8.2f us, max %8.2f us\n",
+					 replay_event_types[i].name, stats->count,
+					 stats->total_nsec / 1e3 / stats->count, stats->max_nsec / 1e3);
+	}
+}
+
+static int
+replay_handle_timer(void *data)
+{
+	pepper_input_replay_t  *replay = data;
+	struct timespec         now;
+	uint64_t                elapsed;
+	int                     count = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = timespec_diff_nsec(&now, &replay->start) / 1000;
+
+	while (replay->pos + sizeof(input_record_header_t) <= replay->size) {
+		input_record_header_t header;
+
+		memcpy(&header, replay->log + replay->pos, sizeof(header));
+
+		if (replay->max_speed) {
+			if (count++ == INPUT_REPLAY_BATCH) {
+				wl_event_source_timer_update(replay->timer, 1);
+				return 0;
+			}
+		} else if (replay->offset + header.delay > elapsed) {
+			wl_event_source_timer_update(replay->timer,
+										 (replay->offset + header.delay - elapsed + 999) / 1000);
+			return 0;
+		}
+
+		if (!replay_dispatch_record(replay))
+			break;
+	}
+
+	replay->finished = PEPPER_TRUE;
+	replay_report(replay);
+
+	/* The callback is allowed to destroy the replay, so don't touch it afterwards. */
+	if (replay->done)
+		replay->done(replay, replay->data);
+
+	return 0;
+}
+
+/**
+ * Replay an input log written by pepper_input_recorder_create()
+ *
+ * @param compositor    compositor object
+ * @param path          path of the log file to read
+ * @param max_speed     PEPPER_TRUE to ignore the recorded timing and replay as fast as possible
+ * @param done          callback called when the whole log has been replayed (can be NULL)
+ * @param data          data passed to the callback
+ *
+ * @return replay object on success, NULL otherwise
+ *
+ * Recorded devices are re-created as input devices of the compositor, so the events go
+ * through the same seat, keyboard, pointer and touch paths as the live ones. Replay starts
+ * on the next event loop iteration. When it finishes, the throughput and per event type
+ * latency are logged and can be queried with pepper_input_replay_get_stats(). The replayed
+ * devices stay alive until the replay object is destroyed.
+ */
+PEPPER_API pepper_input_replay_t *
+pepper_input_replay_create(pepper_compositor_t *compositor, const char *path,
+						   pepper_bool_t max_speed, pepper_input_replay_done_func_t done,
+						   void *data)
+{
+	pepper_input_replay_t  *replay;
+	FILE                   *file;
+	long                    size;
+	uint32_t                header[2];
+
+	replay = calloc(1, sizeof(pepper_input_replay_t));
+	PEPPER_CHECK(replay, return NULL, "calloc() failed.\n");
+
+	replay->compositor = compositor;
+	replay->max_speed = max_speed;
+	replay->done = done;
+	replay->data = data;
+
+	file = fopen(path, "rb");
+	PEPPER_CHECK(file, goto error, "Failed to open %s.\n", path);
+
+	if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) > 0 &&
+		fseek(file, 0, SEEK_SET) == 0) {
+		replay->log = malloc(size);
+
+		if (replay->log && fread(replay->log, size, 1, file) == 1)
+			replay->size = size;
+	}
+
+	fclose(file);
+	PEPPER_CHECK(replay->size >= sizeof(header), goto error, "Failed to read %s.\n", path);
+
+	memcpy(header, replay->log, sizeof(header));
+	PEPPER_CHECK(header[0] == INPUT_RECORD_MAGIC && header[1] == INPUT_RECORD_VERSION,
+				 goto error, "%s is not a supported input log.\n", path);
+
+	replay->pos = sizeof(header);
+
+	replay->timer = wl_event_loop_add_timer(wl_display_get_event_loop(compositor->display),
+											replay_handle_timer, replay);
+	PEPPER_CHECK(replay->timer, goto error, "wl_event_loop_add_timer() failed.\n");
+
+	clock_gettime(CLOCK_MONOTONIC, &replay->start);
+	wl_event_source_timer_update(replay->timer, 1);
+
+	return replay;
+
+error:
+	pepper_input_replay_destroy(replay);
+	return NULL;
+}
+
+/**
+ * Stop replaying and destroy the given replay
+ *
+ * @param replay    replay object
+ *
+ * Input devices created for the replay are destroyed as well.
+ */
+PEPPER_API void
+pepper_input_replay_destroy(pepper_input_replay_t *replay)
+{
+	int i;
+
+	if (replay->timer)
+		wl_event_source_remove(replay->timer);
+
+	for (i = 0; i < INPUT_RECORD_MAX_DEVICES; i++) {
+		if (replay->devices[i])
+			pepper_input_device_destroy(replay->devices[i]);
+	}
+
+	free(replay->log);
+	free(replay);
+}
+
+/**
+ * Check if the given replay has dispatched the whole log
+ *
+ * @param replay    replay object
+ *
+ * @return PEPPER_TRUE if finished, PEPPER_FALSE otherwise
+ */
+PEPPER_API pepper_bool_t
+pepper_input_replay_is_finished(pepper_input_replay_t *replay)
+{
+	return replay->finished;
+}
+
+/**
+ * Get the replay statistics of the given input event type
+ *
+ * @param replay        replay object
+ * @param id            input device event id (PEPPER_EVENT_INPUT_DEVICE_*)
+ * @param count         pointer to receive the number of replayed events (can be NULL)
+ * @param total_nsec    pointer to receive the total time spent emitting them (can be NULL)
+ * @param max_nsec      pointer to receive the longest time spent on one of them (can be NULL)
+ *
+ * @return PEPPER_TRUE if the id is an input device event, PEPPER_FALSE otherwise
+ *
+ * The time is measured around pepper_object_emit_event() on the replay device, which
+ * covers every listener down to the wayland events sent to the clients.
+ */
+PEPPER_API pepper_bool_t
+pepper_input_replay_get_stats(pepper_input_replay_t *replay, uint32_t id,
+							  uint32_t *count, uint64_t *total_nsec, uint64_t *max_nsec)
+{
+	replay_stats_t *stats = replay_get_stats(replay, id);
+
+	if (!stats)
+		return PEPPER_FALSE;
+
+	if (count)
+		*count = stats->count;
+
+	if (total_nsec)
+		*total_nsec = stats->total_nsec;
+
+	if (max_nsec)
+		*max_nsec = stats->max_nsec;
+
+	return PEPPER_TRUE;
+}
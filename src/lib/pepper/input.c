@@ -321,6 +321,7 @@ seat_handle_device_event(pepper_event_listener_t *listener,
 	case PEPPER_EVENT_INPUT_DEVICE_POINTER_MOTION:
 	case PEPPER_EVENT_INPUT_DEVICE_POINTER_BUTTON:
 	case PEPPER_EVENT_INPUT_DEVICE_POINTER_AXIS:
+	case PEPPER_EVENT_INPUT_DEVICE_POINTER_FRAME:
 		pepper_pointer_handle_event(seat->pointer, id, info);
 		break;
 	case PEPPER_EVENT_INPUT_DEVICE_KEYBOARD_KEY:
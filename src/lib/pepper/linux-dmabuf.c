@@ -0,0 +1,458 @@
+/*
+* Copyright © 2008-2012 Kristian Høgsberg
+* Copyright © 2010-2012 Intel Corporation
+* Copyright © 2011 Benjamin Franzke
+* Copyright © 2012 Collabora, Ltd.
+* Copyright © 2015 S-Core Corporation
+* Copyright © 2015-2016 Samsung Electronics co., Ltd. All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <unistd.h>
+#include "pepper-internal.h"
+#include "linux-dmabuf-unstable-v1-server-protocol.h"
+
+#define DMABUF_MOD_INVALID  ((1ULL << 56) - 1)
+
+typedef struct pepper_dmabuf_params pepper_dmabuf_params_t;
+typedef struct pepper_dmabuf_buffer pepper_dmabuf_buffer_t;
+
+struct pepper_dmabuf_params {
+	pepper_compositor_t        *compositor;
+	struct wl_resource         *resource;
+	pepper_dmabuf_attributes_t  attributes;
+	pepper_bool_t               used;
+};
+
+struct pepper_dmabuf_buffer {
+	struct wl_resource         *resource;
+	pepper_dmabuf_attributes_t  attributes;
+};
+
+static void
+attributes_init(pepper_dmabuf_attributes_t *attributes)
+{
+	int i;
+
+	memset(attributes, 0x00, sizeof(pepper_dmabuf_attributes_t));
+
+	for (i = 0; i < PEPPER_DMABUF_MAX_PLANES; i++)
+		attributes->fd[i] = -1;
+}
+
+static void
+attributes_fini(pepper_dmabuf_attributes_t *attributes)
+{
+	int i;
+
+	for (i = 0; i < PEPPER_DMABUF_MAX_PLANES; i++) {
+		if (attributes->fd[i] != -1)
+			close(attributes->fd[i]);
+
+		attributes->fd[i] = -1;
+	}
+}
+
+static void
+buffer_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	wl_resource_destroy(resource);
+}
+
+static const struct wl_buffer_interface dmabuf_buffer_implementation = {
+	buffer_destroy,
+};
+
+static void
+dmabuf_buffer_resource_destroy_handler(struct wl_resource *resource)
+{
+	pepper_dmabuf_buffer_t *buffer = wl_resource_get_user_data(resource);
+
+	attributes_fini(&buffer->attributes);
+	free(buffer);
+}
+
+static void
+params_resource_destroy_handler(struct wl_resource *resource)
+{
+	pepper_dmabuf_params_t *params = wl_resource_get_user_data(resource);
+
+	attributes_fini(&params->attributes);
+	free(params);
+}
+
+static void
+params_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	wl_resource_destroy(resource);
+}
+
+static void
+params_add(struct wl_client *client, struct wl_resource *resource, int32_t fd,
+		   uint32_t plane_idx, uint32_t offset, uint32_t stride,
+		   uint32_t modifier_hi, uint32_t modifier_lo)
+{
+	pepper_dmabuf_params_t *params = wl_resource_get_user_data(resource);
+
+	if (params->used) {
+		wl_resource_post_error(resource, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_ALREADY_USED,
+							   "params was already used to create a wl_buffer");
+		close(fd);
+		return;
+	}
+
+	if (plane_idx >= PEPPER_DMABUF_MAX_PLANES) {
+		wl_resource_post_error(resource, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_PLANE_IDX,
+							   "plane index %u is too high", plane_idx);
+		close(fd);
+		return;
+	}
+
+	if (params->attributes.fd[plane_idx] != -1) {
+		wl_resource_post_error(resource, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_PLANE_SET,
+							   "a dmabuf has already been added for plane %u", plane_idx);
+		close(fd);
+		return;
+	}
+
+	params->attributes.fd[plane_idx] = fd;
+	params->attributes.offset[plane_idx] = offset;
+	params->attributes.stride[plane_idx] = stride;
+	params->attributes.modifier[plane_idx] = ((uint64_t)modifier_hi << 32) | modifier_lo;
+	params->attributes.n_planes++;
+}
+
+static pepper_bool_t
+format_supported(pepper_compositor_t *compositor, uint32_t format, uint64_t modifier)
+{
+	pepper_dmabuf_format_t *entry;
+
+	wl_array_for_each(entry, &compositor->linux_dmabuf.formats) {
+		if (entry->format == format &&
+			(entry->modifier == modifier || modifier == DMABUF_MOD_INVALID))
+			return PEPPER_TRUE;
+	}
+
+	return PEPPER_FALSE;
+}
+
+static pepper_bool_t
+params_validate(pepper_dmabuf_params_t *params)
+{
+	pepper_dmabuf_attributes_t *attributes = &params->attributes;
+	int                         i;
+
+	if (attributes->n_planes == 0) {
+		wl_resource_post_error(params->resource, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_INCOMPLETE,
+							   "no dmabuf has been added to the params");
+		return PEPPER_FALSE;
+	}
+
+	/* Planes must be given from 0 without holes. */
+	for (i = 0; i < attributes->n_planes; i++) {
+		if (attributes->fd[i] == -1) {
+			wl_resource_post_error(params->resource,
+								   ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_INCOMPLETE,
+								   "no dmabuf has been added for plane %d", i);
+			return PEPPER_FALSE;
+		}
+
+		/* Mixing modifiers between planes is not allowed. */
+		if (attributes->modifier[i] != attributes->modifier[0]) {
+			wl_resource_post_error(params->resource,
+								   ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_INVALID_FORMAT,
+								   "modifier of plane %d does not match plane 0", i);
+			return PEPPER_FALSE;
+		}
+	}
+
+	if (attributes->width <= 0 || attributes->height <= 0) {
+		wl_resource_post_error(params->resource,
+							   ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_INVALID_DIMENSIONS,
+							   "invalid width %d or height %d",
+							   attributes->width, attributes->height);
+		return PEPPER_FALSE;
+	}
+
+	if (!format_supported(params->compositor, attributes->format,
+						  attributes->modifier[0])) {
+		wl_resource_post_error(params->resource,
+							   ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_INVALID_FORMAT,
+							   "format 0x%08x is not supported", attributes->format);
+		return PEPPER_FALSE;
+	}
+
+	for (i = 0; i < attributes->n_planes; i++) {
+		off_t   size = lseek(attributes->fd[i], 0, SEEK_END);
+		int64_t end = (int64_t)attributes->offset[i] +
+					  (int64_t)attributes->stride[i] * attributes->height;
+
+		/* Not every dmabuf exporter can tell the size. */
+		if (size == -1)
+			continue;
+
+		if (attributes->offset[i] >= size || (i == 0 && end > size)) {
+			wl_resource_post_error(params->resource,
+								   ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_OUT_OF_BOUNDS,
+								   "plane %d is out of the dmabuf bounds", i);
+			return PEPPER_FALSE;
+		}
+	}
+
+	return PEPPER_TRUE;
+}
+
+static void
+params_create_buffer(struct wl_client *client, struct wl_resource *resource,
+					 uint32_t buffer_id, int32_t width, int32_t height,
+					 uint32_t format, uint32_t flags)
+{
+	pepper_dmabuf_params_t *params = wl_resource_get_user_data(resource);
+	pepper_dmabuf_buffer_t *buffer;
+
+	if (params->used) {
+		wl_resource_post_error(resource, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_ALREADY_USED,
+							   "params was already used to create a wl_buffer");
+		return;
+	}
+
+	params->used = PEPPER_TRUE;
+	params->attributes.width = width;
+	params->attributes.height = height;
+	params->attributes.format = format;
+	params->attributes.flags = flags;
+
+	if (!params_validate(params))
+		return;
+
+	buffer = calloc(1, sizeof(pepper_dmabuf_buffer_t));
+	PEPPER_CHECK(buffer, goto error, "calloc() failed.\n");
+
+	buffer->resource = wl_resource_create(client, &wl_buffer_interface, 1, buffer_id);
+	PEPPER_CHECK(buffer->resource, goto error, "wl_resource_create() failed.\n");
+
+	wl_resource_set_implementation(buffer->resource, &dmabuf_buffer_implementation,
+								   buffer, dmabuf_buffer_resource_destroy_handler);
+
+	/* The buffer owns the fds from now on. */
+	buffer->attributes = params->attributes;
+	attributes_init(&params->attributes);
+
+	if (buffer_id == 0)
+		zwp_linux_buffer_params_v1_send_created(resource, buffer->resource);
+
+	return;
+
+error:
+	if (buffer)
+		free(buffer);
+
+	if (buffer_id == 0)
+		zwp_linux_buffer_params_v1_send_failed(resource);
+	else
+		wl_client_post_no_memory(client);
+}
+
+static void
+params_create(struct wl_client *client, struct wl_resource *resource,
+			  int32_t width, int32_t height, uint32_t format, uint32_t flags)
+{
+	params_create_buffer(client, resource, 0, width, height, format, flags);
+}
+
+static void
+params_create_immed(struct wl_client *client, struct wl_resource *resource,
+					uint32_t buffer_id, int32_t width, int32_t height,
+					uint32_t format, uint32_t flags)
+{
+	params_create_buffer(client, resource, buffer_id, width, height, format, flags);
+}
+
+static const struct zwp_linux_buffer_params_v1_interface params_implementation = {
+	params_destroy,
+	params_add,
+	params_create,
+	params_create_immed,
+};
+
+static void
+linux_dmabuf_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	wl_resource_destroy(resource);
+}
+
+static void
+linux_dmabuf_create_params(struct wl_client *client, struct wl_resource *resource,
+						   uint32_t params_id)
+{
+	pepper_dmabuf_params_t *params;
+
+	params = calloc(1, sizeof(pepper_dmabuf_params_t));
+	PEPPER_CHECK(params, goto error, "calloc() failed.\n");
+
+	params->compositor = wl_resource_get_user_data(resource);
+	attributes_init(&params->attributes);
+
+	params->resource = wl_resource_create(client, &zwp_linux_buffer_params_v1_interface,
+										  wl_resource_get_version(resource), params_id);
+	PEPPER_CHECK(params->resource, goto error, "wl_resource_create() failed.\n");
+
+	wl_resource_set_implementation(params->resource, &params_implementation, params,
+								   params_resource_destroy_handler);
+	return;
+
+error:
+	if (params)
+		free(params);
+
+	wl_client_post_no_memory(client);
+}
+
+static const struct zwp_linux_dmabuf_v1_interface linux_dmabuf_implementation = {
+	linux_dmabuf_destroy,
+	linux_dmabuf_create_params,
+};
+
+static void
+linux_dmabuf_bind(struct wl_client *client, void *data, uint32_t version,
+				  uint32_t id)
+{
+	pepper_compositor_t    *compositor = data;
+	struct wl_resource     *resource;
+	pepper_dmabuf_format_t *entry;
+	uint32_t                last_format = 0;
+
+	resource = wl_resource_create(client, &zwp_linux_dmabuf_v1_interface, version, id);
+	if (!resource) {
+		PEPPER_ERROR("wl_resource_create failed\n");
+		wl_client_post_no_memory(client);
+		return;
+	}
+
+	wl_resource_set_implementation(resource, &linux_dmabuf_implementation,
+								   compositor, NULL);
+
+	/* The table is kept grouped by format. */
+	wl_array_for_each(entry, &compositor->linux_dmabuf.formats) {
+		if (version >= ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION) {
+			zwp_linux_dmabuf_v1_send_modifier(resource, entry->format,
+											  (uint32_t)(entry->modifier >> 32),
+											  (uint32_t)(entry->modifier & 0xffffffff));
+		} else if (entry->format != last_format) {
+			zwp_linux_dmabuf_v1_send_format(resource, entry->format);
+		}
+
+		last_format = entry->format;
+	}
+}
+
+pepper_bool_t
+pepper_linux_dmabuf_init(pepper_compositor_t *compositor)
+{
+	wl_array_init(&compositor->linux_dmabuf.formats);
+
+	compositor->linux_dmabuf.global = wl_global_create(compositor->display,
+									  &zwp_linux_dmabuf_v1_interface, 3,
+									  compositor, linux_dmabuf_bind);
+	PEPPER_CHECK(compositor->linux_dmabuf.global, return PEPPER_FALSE,
+				 "wl_global_create() failed.\n");
+
+	return PEPPER_TRUE;
+}
+
+void
+pepper_linux_dmabuf_fini(pepper_compositor_t *compositor)
+{
+	if (compositor->linux_dmabuf.global) {
+		wl_global_destroy(compositor->linux_dmabuf.global);
+		compositor->linux_dmabuf.global = NULL;
+	}
+
+	wl_array_release(&compositor->linux_dmabuf.formats);
+	wl_array_init(&compositor->linux_dmabuf.formats);
+}
+
+/**
+ * Add a dmabuf format and modifier pair supported by the compositor
+ *
+ * @param compositor    compositor object
+ * @param format        DRM fourcc format code
+ * @param modifier      layout modifier, DRM_FORMAT_MOD_INVALID for an implicit modifier
+ *
+ * @return PEPPER_TRUE on success, otherwise PEPPER_FALSE
+ *
+ * Renderers and output backends add the pairs they can import. The table is advertised to the
+ * clients binding zwp_linux_dmabuf_v1 afterwards, so it should be filled before clients connect.
+ * Buffers of the formats not in the table are rejected.
+ */
+PEPPER_API pepper_bool_t
+pepper_compositor_add_dmabuf_format(pepper_compositor_t *compositor,
+									uint32_t format, uint64_t modifier)
+{
+	pepper_dmabuf_format_t *entry, *base;
+	size_t                  count, pos;
+
+	count = compositor->linux_dmabuf.formats.size / sizeof(pepper_dmabuf_format_t);
+	pos = count;
+
+	wl_array_for_each(entry, &compositor->linux_dmabuf.formats) {
+		if (entry->format == format && entry->modifier == modifier)
+			return PEPPER_TRUE;
+
+		/* Keep the entries of a format next to each other. */
+		if (entry->format == format)
+			pos = entry - (pepper_dmabuf_format_t *)compositor->linux_dmabuf.formats.data + 1;
+	}
+
+	entry = wl_array_add(&compositor->linux_dmabuf.formats, sizeof(pepper_dmabuf_format_t));
+	PEPPER_CHECK(entry, return PEPPER_FALSE, "wl_array_add() failed.\n");
+
+	base = compositor->linux_dmabuf.formats.data;
+	entry = base + pos;
+	memmove(entry + 1, entry, (count - pos) * sizeof(pepper_dmabuf_format_t));
+
+	entry->format = format;
+	entry->modifier = modifier;
+
+	return PEPPER_TRUE;
+}
+
+/**
+ * Get the dmabuf attributes of the given buffer
+ *
+ * @param buffer    buffer object
+ *
+ * @return dmabuf attributes, NULL if the buffer was not created through zwp_linux_dmabuf_v1
+ *
+ * The file descriptors are owned by the buffer and stay valid until the wl_buffer is destroyed.
+ */
+PEPPER_API const pepper_dmabuf_attributes_t *
+pepper_buffer_get_dmabuf_attributes(pepper_buffer_t *buffer)
+{
+	pepper_dmabuf_buffer_t *dmabuf;
+
+	if (!wl_resource_instance_of(buffer->resource, &wl_buffer_interface,
+								 &dmabuf_buffer_implementation))
+		return NULL;
+
+	dmabuf = wl_resource_get_user_data(buffer->resource);
+	return &dmabuf->attributes;
+}
@@ -131,14 +131,24 @@ output_update_planes(pepper_output_t *output)
 }
 
 static void
-output_repaint(pepper_output_t *output)
+output_clear_view_list(pepper_output_t *output)
 {
-	pepper_view_t  *view;
+	pepper_list_t *l, *tmp;
 
-	pepper_list_for_each(view, &output->compositor->view_list, compositor_link)
-	pepper_view_update(view);
+	pepper_list_for_each_list_safe(l, tmp, &output->view_list) {
+		l->prev = NULL;
+		l->next = NULL;
+	}
 
 	pepper_list_init(&output->view_list);
+}
+
+static void
+output_build_view_list(pepper_output_t *output)
+{
+	pepper_view_t *view;
+
+	output_clear_view_list(output);
 
 	/* Build a list of views in sorted z-order that are visible on the given output. */
 	pepper_list_for_each(view, &output->compositor->view_list, compositor_link) {
@@ -149,25 +159,145 @@ output_repaint(pepper_output_t *output)
 			continue;
 		}
 
-		pepper_list_insert(output->view_list.prev, &view->link);
+		pepper_list_insert(output->view_list.prev,
+						   &view->plane_entries[output->id].output_link);
 	}
 
+	output->view_list_dirty = PEPPER_FALSE;
+}
+
+static inline int64_t
+timespec_to_nsec(const struct timespec *ts)
+{
+	return (int64_t)ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+static void
+output_update_repaint_cost(pepper_output_t *output, const struct timespec *begin)
+{
+	struct timespec end;
+	int64_t         cost;
+
+	pepper_compositor_get_time(output->compositor, &end);
+	cost = timespec_to_nsec(&end) - timespec_to_nsec(begin);
+
+	if (cost < 0)
+		return;
+
+	if (output->frame.repaint_cost == 0)
+		output->frame.repaint_cost = cost;
+	else
+		output->frame.repaint_cost = (output->frame.repaint_cost * 7 + cost) / 8;
+}
+
+static void
+output_repaint(pepper_output_t *output)
+{
+	pepper_list_t  *l;
+	struct timespec begin;
+
+	pepper_compositor_get_time(output->compositor, &begin);
+
+	/* Coalesced pointer motion is delivered at the start of a frame. */
+	pepper_compositor_flush_pointer_motion(output->compositor);
+	pepper_compositor_update_views(output->compositor);
+
+	if (output->view_list_dirty)
+		output_build_view_list(output);
+
 	output->backend->assign_planes(output->data, &output->view_list);
 	output_update_planes(output);
 	output->backend->repaint(output->data, &output->plane_list);
+	output_update_repaint_cost(output, &begin);
 
 	output->frame.pending = PEPPER_TRUE;
 	output->frame.scheduled = PEPPER_FALSE;
 
-	pepper_list_for_each(view, &output->view_list, link) {
-		/* TODO: Output time stamp and presentation feedback. */
+	pepper_list_for_each_list(l, &output->view_list) {
+		pepper_view_t  *view = l->item;
+		pepper_plane_t *plane;
+		uint32_t        flags = 0;
+
 		PEPPER_CHECK(view->surface, continue, "view->surface is null");
-		pepper_surface_send_frame_callback_done(view->surface,
-												output->frame.time.tv_sec * 1000 +
-												output->frame.time.tv_nsec / 1000000);
+
+		/* Presentation feedback is sent when the backend finishes this frame. */
+		plane = view->plane_entries[output->id].plane;
+		if (plane && plane->zero_copy)
+			flags |= PEPPER_OUTPUT_PRESENT_ZERO_COPY;
+
+		pepper_presentation_feedback_sync_list(&view->surface->feedback_list, output,
+											   flags);
+		pepper_list_insert_list(output->feedback_list.prev,
+								&view->surface->feedback_list);
+		pepper_list_init(&view->surface->feedback_list);
+
+		/* Frame callbacks are done with the presentation time as well. */
+		wl_list_insert_list(output->frame_callback_list.prev,
+							&view->surface->frame_callback_list);
+		wl_list_init(&view->surface->frame_callback_list);
+	}
+}
+
+static void
+output_send_frame_callbacks(pepper_output_t *output, const struct timespec *time)
+{
+	struct wl_resource *callback, *next;
+
+	wl_resource_for_each_safe(callback, next, &output->frame_callback_list) {
+		wl_callback_send_done(callback, time->tv_sec * 1000 + time->tv_nsec / 1000000);
+		wl_resource_destroy(callback);
 	}
 }
 
+static int
+repaint_timer_handler(void *data)
+{
+	pepper_output_t *output = data;
+
+	output->frame.pending = PEPPER_FALSE;
+
+	if (output->frame.scheduled)
+		output_repaint(output);
+
+	return 0;
+}
+
+/* Returns the delay in msec until the repaint should start for the frame presented at the next
+ * vblank after the given one, or 0 to repaint right away. */
+static int
+output_get_repaint_delay(pepper_output_t *output, const struct timespec *vblank)
+{
+	struct timespec now;
+	int64_t         refresh, next, budget, delay;
+
+	if (output->frame.repaint_window <= 0 || output->current_mode.refresh <= 0)
+		return 0;
+
+	/* Mode refresh rate is in mHz. */
+	refresh = 1000000000000LL / output->current_mode.refresh;
+	budget = (int64_t)output->frame.repaint_window * 1000000;
+
+	/* Leave room for the measured repaint cost plus a millisecond of slack. */
+	if (output->frame.repaint_cost + 1000000 > budget)
+		budget = output->frame.repaint_cost + 1000000;
+
+	if (budget >= refresh)
+		return 0;
+
+	pepper_compositor_get_time(output->compositor, &now);
+
+	/* Skip vblanks already passed, the timestamp might be stale. */
+	next = timespec_to_nsec(vblank) + refresh;
+	if (next <= timespec_to_nsec(&now))
+		next += ((timespec_to_nsec(&now) - next) / refresh + 1) * refresh;
+
+	delay = next - budget - timespec_to_nsec(&now);
+	if (delay < 1000000)
+		return 0;
+
+	return (int)(delay / 1000000);
+}
+
 static void
 idle_repaint(void *data)
 {
@@ -218,9 +348,29 @@ pepper_output_add_damage_region(pepper_output_t *output,
  *
  * Output backend should call this function when they are ready to draw a new frame in response to
  * the requests from pepper library.
+ *
+ * @see pepper_output_finish_frame_presented()
  */
 PEPPER_API void
 pepper_output_finish_frame(pepper_output_t *output, struct timespec *ts)
+{
+	pepper_output_finish_frame_presented(output, ts, 0, 0);
+}
+
+/**
+ * Finish the currently pending frame of the given output with presentation information.
+ *
+ * @param output    output object
+ * @param ts        time when the frame was presented, NULL for the current time
+ * @param seq       vertical retrace counter of the presentation, 0 if unknown
+ * @param flags     bitwise OR of #pepper_output_present_flag_t
+ *
+ * Same as pepper_output_finish_frame() but also reports how the frame has been presented to the
+ * clients requested presentation feedback. ts must be in the clock domain of the compositor.
+ */
+PEPPER_API void
+pepper_output_finish_frame_presented(pepper_output_t *output, struct timespec *ts,
+									 uint64_t seq, uint32_t flags)
 {
 	struct timespec time;
 
@@ -257,8 +407,55 @@ pepper_output_finish_frame(pepper_output_t *output, struct timespec *ts)
 	output->frame.count++;
 	output->frame.time = time;
 
-	if (output->frame.scheduled)
+	pepper_presentation_feedback_present_list(&output->feedback_list, output,
+			&time, seq, flags);
+	output_send_frame_callbacks(output, &time);
+
+	if (output->frame.scheduled) {
+		int delay = output_get_repaint_delay(output, &time);
+
+		/* Keep the frame pending so that commits in the meantime join this repaint. */
+		if (delay > 0 && output->frame.repaint_timer) {
+			output->frame.pending = PEPPER_TRUE;
+			wl_event_source_timer_update(output->frame.repaint_timer, delay);
+			return;
+		}
+
 		output_repaint(output);
+	}
+}
+
+/**
+ * Set the repaint window of the given output.
+ *
+ * @param output    output object
+ * @param msec      time before the next vblank to start repainting in milliseconds, 0 to disable
+ *
+ * When enabled, repaint of a scheduled frame is delayed until the given time before the vblank
+ * predicted from the last presentation timestamp and the refresh rate of the current mode, so
+ * that client commits arriving in the meantime still catch the next vblank. The window is
+ * widened automatically if the measured repaint time of the output does not fit in it. The
+ * default value can be given by PEPPER_REPAINT_WINDOW environment variable.
+ */
+PEPPER_API void
+pepper_output_set_repaint_window(pepper_output_t *output, int32_t msec)
+{
+	output->frame.repaint_window = msec > 0 ? msec : 0;
+}
+
+/**
+ * Get the repaint window of the given output.
+ *
+ * @param output    output object
+ *
+ * @return repaint window in milliseconds, 0 if disabled
+ *
+ * @see pepper_output_set_repaint_window()
+ */
+PEPPER_API int32_t
+pepper_output_get_repaint_window(pepper_output_t *output)
+{
+	return output->frame.repaint_window;
 }
 
 /**
@@ -361,12 +558,27 @@ pepper_compositor_add_output(pepper_compositor_t *compositor,
 
 	pepper_list_insert(&compositor->output_list, &output->link);
 	pepper_list_init(&output->plane_list);
+	pepper_list_init(&output->feedback_list);
+	wl_list_init(&output->frame_callback_list);
+	pepper_list_init(&output->view_list);
+	output->view_list_dirty = PEPPER_TRUE;
 
 	/* FPS */
 	str = getenv("PEPPER_DEBUG_FPS");
 	if (str && atoi(str) != 0)
 		output->frame.print_fps = PEPPER_TRUE;
 
+	/* Repaint window */
+	output->frame.repaint_timer =
+		wl_event_loop_add_timer(wl_display_get_event_loop(compositor->display),
+								repaint_timer_handler, output);
+	PEPPER_CHECK(output->frame.repaint_timer, ,
+				 "Failed to create repaint timer, repaint window is disabled.\n");
+
+	str = getenv("PEPPER_REPAINT_WINDOW");
+	if (str)
+		pepper_output_set_repaint_window(output, atoi(str));
+
 	pepper_object_emit_event(&compositor->base, PEPPER_EVENT_COMPOSITOR_OUTPUT_ADD,
 							 output);
 	return output;
@@ -399,6 +611,15 @@ pepper_output_destroy(pepper_output_t *output)
 							 PEPPER_EVENT_COMPOSITOR_OUTPUT_REMOVE, output);
 	pepper_object_fini(&output->base);
 
+	output_clear_view_list(output);
+	pepper_presentation_feedback_discard_list(&output->feedback_list);
+
+	/* Don't leave the clients waiting for a frame that is never presented. */
+	output_send_frame_callbacks(output, &output->frame.time);
+
+	if (output->frame.repaint_timer)
+		wl_event_source_remove(output->frame.repaint_timer);
+
 	output->compositor->output_id_allocator &= ~(1 << output->id);
 	pepper_list_remove(&output->link);
 	output->backend->destroy(output->data);
@@ -436,6 +657,7 @@ pepper_output_move(pepper_output_t *output, int32_t x, int32_t y)
 	if ((output->geometry.x != x) || (output->geometry.y != y)) {
 		output->geometry.x = x;
 		output->geometry.y = y;
+		output->view_list_dirty = PEPPER_TRUE;
 
 		/* TODO: pepper_output_add_damage_whole(out); */
 
@@ -64,6 +64,44 @@ pepper_input_device_destroy(pepper_input_device_t *device);
 PEPPER_API uint32_t
 pepper_input_device_get_caps(pepper_input_device_t *device);
 
+/**
+ * @typedef pepper_input_recorder_t
+ *
+ * A #pepper_input_recorder_t writes the events of the input devices to a log file.
+ */
+typedef struct pepper_input_recorder            pepper_input_recorder_t;
+
+/**
+ * @typedef pepper_input_replay_t
+ *
+ * A #pepper_input_replay_t feeds a log written by a #pepper_input_recorder_t back to the
+ * compositor.
+ */
+typedef struct pepper_input_replay              pepper_input_replay_t;
+
+typedef void (*pepper_input_replay_done_func_t)(pepper_input_replay_t *replay, void *data);
+
+PEPPER_API pepper_input_recorder_t *
+pepper_input_recorder_create(pepper_compositor_t *compositor, const char *path);
+
+PEPPER_API void
+pepper_input_recorder_destroy(pepper_input_recorder_t *recorder);
+
+PEPPER_API pepper_input_replay_t *
+pepper_input_replay_create(pepper_compositor_t *compositor, const char *path,
+						   pepper_bool_t max_speed, pepper_input_replay_done_func_t done,
+						   void *data);
+
+PEPPER_API void
+pepper_input_replay_destroy(pepper_input_replay_t *replay);
+
+PEPPER_API pepper_bool_t
+pepper_input_replay_is_finished(pepper_input_replay_t *replay);
+
+PEPPER_API pepper_bool_t
+pepper_input_replay_get_stats(pepper_input_replay_t *replay, uint32_t id,
+							  uint32_t *count, uint64_t *total_nsec, uint64_t *max_nsec);
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,11 +40,18 @@
 #define PEPPER_MAX_OUTPUT_COUNT         32
 #define PEPPER_OUTPUT_MAX_TICK_COUNT    10
 
+#define PEPPER_VIEW_GRID_CELL_SHIFT     7
+#define PEPPER_VIEW_GRID_BUCKET_BITS    8
+#define PEPPER_VIEW_GRID_MAX_CELLS      64
+
 typedef struct pepper_wl_region        pepper_wl_region_t;
 typedef struct pepper_surface_state pepper_surface_state_t;
 typedef struct pepper_plane_entry   pepper_plane_entry_t;
 typedef struct pepper_input         pepper_input_t;
 typedef struct pepper_touch_point   pepper_touch_point_t;
+typedef struct pepper_view_grid_entry   pepper_view_grid_entry_t;
+typedef struct pepper_presentation_feedback pepper_presentation_feedback_t;
+typedef struct pepper_dmabuf_format pepper_dmabuf_format_t;
 
 struct pepper_object {
 	pepper_object_type_t    type;
@@ -92,15 +99,42 @@ struct pepper_compositor {
 	uint32_t                 output_id_allocator;
 	pepper_bool_t            update_scheduled;
 
+	/* Spatial index of the view bounding regions used for picking. */
+	struct {
+		pepper_list_t        buckets[1 << PEPPER_VIEW_GRID_BUCKET_BITS];
+		pepper_list_t        large_list;
+		pepper_bool_t        z_order_dirty;
+	} view_grid;
+
 	clockid_t                clock_id;
 	pepper_bool_t            clock_used;
 
+	/* wp_presentation global. */
+	struct {
+		struct wl_global    *global;
+		struct wl_list       resource_list;
+	} presentation;
+
+	/* zwp_linux_dmabuf_v1 global. */
+	struct {
+		struct wl_global    *global;
+		struct wl_array      formats;
+	} linux_dmabuf;
+
+	pepper_bool_t            early_buffer_release;
+
 	struct sockaddr_un       addr;
 };
 
 void
 pepper_compositor_schedule_repaint(pepper_compositor_t *compositor);
 
+void
+pepper_compositor_update_views(pepper_compositor_t *compositor);
+
+void
+pepper_compositor_flush_pointer_motion(pepper_compositor_t *compositor);
+
 struct pepper_output {
 	pepper_object_t             base;
 	pepper_compositor_t        *compositor;
@@ -132,10 +166,27 @@ struct pepper_output {
 		uint32_t                ticks[PEPPER_OUTPUT_MAX_TICK_COUNT];
 		int                     tick_index;
 		uint32_t                total_time;
+
+		/* Repaint window scheduling. Repaint is delayed until the window
+		 * before the predicted vblank, widened by the measured repaint cost. */
+		int32_t                 repaint_window;     /* msec, 0 to disable */
+		int64_t                 repaint_cost;       /* nsec, moving average */
+		struct wl_event_source *repaint_timer;
 	} frame;
 
 	pepper_list_t               plane_list;
+
+	/* Presentation feedbacks waiting for the currently pending frame. */
+	pepper_list_t               feedback_list;
+
+	/* wl_surface.frame callbacks done when the currently pending frame is presented. */
+	struct wl_list              frame_callback_list;
+
+	/* Visible views in z-order, linked through plane_entries[id].output_link.
+	 * Rebuilt only when a view crossing this output changes its stacking,
+	 * visibility or overlap. */
 	pepper_list_t               view_list;
+	pepper_bool_t               view_list_dirty;
 };
 
 void
@@ -170,6 +221,7 @@ struct pepper_surface_state {
 	pepper_region_t           input_region;
 
 	struct wl_list              frame_callback_list;
+	pepper_list_t               feedback_list;
 	pepper_event_listener_t    *buffer_destroy_listener;
 };
 
@@ -204,6 +256,7 @@ struct pepper_surface {
 	pepper_bool_t           pickable;
 
 	struct wl_list          frame_callback_list;
+	pepper_list_t           feedback_list;
 
 	/* Surface states. wl_surface.commit will apply the pending state into current. */
 	pepper_surface_state_t  pending;
@@ -232,10 +285,6 @@ void
 pepper_surface_commit_state(pepper_surface_t *surface,
 							pepper_surface_state_t *state);
 
-void
-pepper_surface_send_frame_callback_done(pepper_surface_t *surface,
-										uint32_t time);
-
 struct pepper_wl_region {
 	pepper_object_t         base;
 	pepper_compositor_t    *compositor;
@@ -258,6 +307,47 @@ void
 pepper_transform_region(pepper_region_t *region,
 							   const pepper_mat4_t *matrix);
 
+/* Presentation */
+struct pepper_presentation_feedback {
+	struct wl_resource     *resource;
+	pepper_list_t           link;
+	uint32_t                flags;
+};
+
+pepper_bool_t
+pepper_presentation_init(pepper_compositor_t *compositor);
+
+void
+pepper_presentation_fini(pepper_compositor_t *compositor);
+
+void
+pepper_presentation_send_clock_id(pepper_compositor_t *compositor);
+
+void
+pepper_presentation_feedback_discard_list(pepper_list_t *list);
+
+void
+pepper_presentation_feedback_sync_list(pepper_list_t *list,
+									   pepper_output_t *output, uint32_t flags);
+
+void
+pepper_presentation_feedback_present_list(pepper_list_t *list,
+		pepper_output_t *output,
+		const struct timespec *ts, uint64_t seq,
+		uint32_t flags);
+
+/* Linux dmabuf */
+struct pepper_dmabuf_format {
+	uint32_t                format;
+	uint64_t                modifier;
+};
+
+pepper_bool_t
+pepper_linux_dmabuf_init(pepper_compositor_t *compositor);
+
+void
+pepper_linux_dmabuf_fini(pepper_compositor_t *compositor);
+
 /* Subcompositor */
 struct pepper_subcompositor {
 	pepper_object_t          base;
@@ -353,6 +443,17 @@ struct pepper_pointer {
 	pepper_view_t                  *cursor_view;
 	int32_t                         hotspot_x;
 	int32_t                         hotspot_y;
+
+	/* Motion coalescing. Raw motion is accumulated and dispatched once per frame. */
+	struct {
+		pepper_bool_t               enabled;
+		pepper_bool_t               pending;
+		uint32_t                    time;
+		double                      x, y;
+
+		uint32_t                    received;
+		uint32_t                    merged;
+	} motion;
 };
 
 pepper_pointer_t *
@@ -369,6 +470,9 @@ void
 pepper_pointer_handle_event(pepper_pointer_t *pointer, uint32_t id,
 							pepper_input_event_t *event);
 
+void
+pepper_pointer_flush_motion(pepper_pointer_t *pointer);
+
 struct pepper_keyboard {
 	pepper_object_t                 base;
 	pepper_seat_t                  *seat;
@@ -423,8 +527,12 @@ void
 pepper_keyboard_handle_event(pepper_keyboard_t *keyboard, uint32_t id,
 							 pepper_input_event_t *event);
 
+/* Maximum number of simultaneous touch points, must be a power of 2. */
+#define PEPPER_TOUCH_MAX_POINTS     16
+
 struct pepper_touch_point {
 	pepper_touch_t             *touch;
+	pepper_bool_t               active;
 
 	uint32_t                    id;
 	double                      x, y;
@@ -432,8 +540,6 @@ struct pepper_touch_point {
 	pepper_view_t              *focus;
 	uint32_t                    focus_serial;
 	pepper_event_listener_t    *focus_destroy_listener;
-
-	pepper_list_t               link;
 };
 
 struct pepper_touch {
@@ -441,7 +547,8 @@ struct pepper_touch {
 	pepper_seat_t              *seat;
 	struct wl_list              resource_list;
 
-	pepper_list_t               point_list;
+	/* Indexed by the touch point id, sparse ids are probed linearly from id modulo the size. */
+	pepper_touch_point_t        points[PEPPER_TOUCH_MAX_POINTS];
 
 	const pepper_touch_grab_t  *grab;
 	void                       *data;
@@ -497,6 +604,7 @@ struct pepper_plane_entry {
 	pepper_bool_t               need_transform_update;
 
 	pepper_list_t               link;
+	pepper_list_t               output_link;    /* link to output's view_list */
 };
 
 enum {
@@ -544,19 +652,45 @@ struct pepper_view {
 	uint32_t                    output_overlap;
 	pepper_plane_entry_t        plane_entries[PEPPER_MAX_OUTPUT_COUNT];
 
-	/* Temporary resource. */
-	pepper_list_t               link;
+	/* Picking. */
+	uint32_t                    z_index;
+	pepper_view_grid_entry_t   *grid_entries;
+	int                         grid_entry_count;
+	int                         grid_entry_size;
+	pepper_list_t               grid_large_link;
 };
 
 void
 pepper_view_mark_dirty(pepper_view_t *view, uint32_t flag);
 
+pepper_bool_t
+pepper_view_move_cursor(pepper_view_t *view, double x, double y);
+
 void
 pepper_view_update(pepper_view_t *view);
 
 void
 pepper_view_surface_damage(pepper_view_t *view);
 
+/* View grid */
+struct pepper_view_grid_entry {
+	int32_t             cx, cy;
+	pepper_list_t       link;
+};
+
+void
+pepper_view_grid_init(pepper_compositor_t *compositor);
+
+void
+pepper_view_grid_update(pepper_view_t *view);
+
+void
+pepper_view_grid_remove(pepper_view_t *view);
+
+pepper_view_t *
+pepper_view_grid_pick(pepper_compositor_t *compositor, double x, double y,
+					  double *vx, double *vy);
+
 struct pepper_plane {
 	pepper_object_t     base;
 	pepper_output_t    *output;
@@ -565,6 +699,9 @@ struct pepper_plane {
 	pepper_region_t   damage_region;
 	pepper_region_t   clip_region;
 
+	/* Views on this plane are scanned out without copy. */
+	pepper_bool_t       zero_copy;
+
 	pepper_list_t       link;
 };
 
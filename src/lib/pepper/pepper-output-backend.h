@@ -56,6 +56,18 @@ typedef struct pepper_output_backend    pepper_output_backend_t;
  */
 typedef struct pepper_render_item       pepper_render_item_t;
 
+/**
+ * @typedef pepper_output_present_flag_t
+ *
+ * Flags describing how a frame has been presented. Values match wp_presentation_feedback.kind.
+ */
+typedef enum pepper_output_present_flag {
+	PEPPER_OUTPUT_PRESENT_VSYNC         = 0x1,  /**< presentation was vsync'd */
+	PEPPER_OUTPUT_PRESENT_HW_CLOCK      = 0x2,  /**< timestamp is provided by hardware */
+	PEPPER_OUTPUT_PRESENT_HW_COMPLETION = 0x4,  /**< hardware signalled the presentation */
+	PEPPER_OUTPUT_PRESENT_ZERO_COPY     = 0x8,  /**< presentation was done zero-copy */
+} pepper_output_present_flag_t;
+
 struct pepper_output_backend {
 	/**
 	 * Destroy all internal resources by the backend for the given output.
@@ -125,6 +137,14 @@ struct pepper_output_backend {
 	 */
 	void            (*flush_surface_damage)(void *output, pepper_surface_t *surface,
 											pepper_bool_t *keep_buffer);
+
+	/**
+	 * Move the given view to (x, y) in global space without a repaint. Called when only the
+	 * position of a pointer cursor view has changed. Backend should return PEPPER_TRUE if the
+	 * view is shown on its cursor plane and has been moved there, otherwise the output is
+	 * repainted as usual. Optional.
+	 */
+	pepper_bool_t   (*move_cursor)(void *output, pepper_view_t *view, double x, double y);
 };
 
 PEPPER_API pepper_output_t *
@@ -162,10 +182,25 @@ pepper_plane_subtract_damage_region(pepper_plane_t *plane,
 PEPPER_API void
 pepper_plane_clear_damage_region(pepper_plane_t *plane);
 
+PEPPER_API void
+pepper_plane_set_zero_copy(pepper_plane_t *plane, pepper_bool_t zero_copy);
+
 PEPPER_API void
 pepper_view_assign_plane(pepper_view_t *view, pepper_output_t *output,
 						 pepper_plane_t *plane);
 
+PEPPER_API pepper_region_t *
+pepper_view_get_bounding_region(pepper_view_t *view);
+
+PEPPER_API pepper_region_t *
+pepper_view_get_opaque_region(pepper_view_t *view);
+
+PEPPER_API pepper_bool_t
+pepper_view_get_cursor_hotspot(pepper_view_t *view, int32_t *x, int32_t *y);
+
+PEPPER_API struct wl_shm_buffer *
+pepper_view_get_cursor_buffer(pepper_view_t *view);
+
 PEPPER_API void
 pepper_output_add_damage_region(pepper_output_t *output,
 								pepper_region_t *region);
@@ -173,6 +208,10 @@ pepper_output_add_damage_region(pepper_output_t *output,
 PEPPER_API void
 pepper_output_finish_frame(pepper_output_t *output, struct timespec *ts);
 
+PEPPER_API void
+pepper_output_finish_frame_presented(pepper_output_t *output, struct timespec *ts,
+									 uint64_t seq, uint32_t flags);
+
 PEPPER_API void
 pepper_output_update_mode(pepper_output_t *output);
 
@@ -94,6 +94,14 @@ typedef struct pepper_surface           pepper_surface_t;
  */
 typedef struct pepper_buffer            pepper_buffer_t;
 
+/**
+ * @typedef pepper_dmabuf_attributes_t
+ *
+ * A #pepper_dmabuf_attributes_t describes the dmabuf planes of a wl_buffer
+ * created through zwp_linux_dmabuf_v1.
+ */
+typedef struct pepper_dmabuf_attributes pepper_dmabuf_attributes_t;
+
 /**
  * @typedef pepper_view_t
  *
@@ -273,6 +281,26 @@ enum pepper_output_mode_flag {
 	PEPPER_OUTPUT_MODE_PREFERRED    = (1 << 2), /**< the mode is preferred mode. */
 };
 
+#define PEPPER_DMABUF_MAX_PLANES    4
+
+struct pepper_dmabuf_attributes {
+	int32_t     width;      /**< width of the buffer. */
+	int32_t     height;     /**< height of the buffer. */
+	uint32_t    format;     /**< DRM fourcc format code. */
+	uint32_t    flags;      /**< bit flag #pepper_dmabuf_flag. */
+	int         n_planes;   /**< number of planes. */
+	int         fd[PEPPER_DMABUF_MAX_PLANES];       /**< dmabuf fd of each plane. */
+	uint32_t    offset[PEPPER_DMABUF_MAX_PLANES];   /**< offset of each plane in bytes. */
+	uint32_t    stride[PEPPER_DMABUF_MAX_PLANES];   /**< stride of each plane in bytes. */
+	uint64_t    modifier[PEPPER_DMABUF_MAX_PLANES]; /**< layout modifier of each plane. */
+};
+
+enum pepper_dmabuf_flag {
+	PEPPER_DMABUF_Y_INVERT          = (1 << 0), /**< contents are y-inverted. */
+	PEPPER_DMABUF_INTERLACED        = (1 << 1), /**< contents are interlaced. */
+	PEPPER_DMABUF_BOTTOM_FIRST      = (1 << 2), /**< bottom field first. */
+};
+
 typedef enum pepper_object_type {
 	PEPPER_OBJECT_COMPOSITOR,   /**< #pepper_compositor_t */
 	PEPPER_OBJECT_OUTPUT,       /**< #pepper_output_t */
@@ -777,6 +805,15 @@ enum pepper_built_in_events {
 	 *  - info : #pepper_keyboard_t
 	 */
 	PEPPER_EVENT_KEYBOARD_KEYMAP_UPDATE,
+
+	/**
+	 * Pointer frame event.
+	 *
+	 * #pepper_input_device_t
+	 *  - when : input backend has emitted all pointer events of a hardware frame (ex. SYN_REPORT)
+	 *  - info : #pepper_input_event_t
+	 */
+	PEPPER_EVENT_INPUT_DEVICE_POINTER_FRAME,
 };
 
 enum pepper_pointer_axis {
@@ -881,6 +918,17 @@ PEPPER_API pepper_bool_t
 pepper_compositor_get_time(pepper_compositor_t *compositor,
 						   struct timespec *ts);
 
+PEPPER_API pepper_bool_t
+pepper_compositor_add_dmabuf_format(pepper_compositor_t *compositor,
+									uint32_t format, uint64_t modifier);
+
+PEPPER_API void
+pepper_compositor_set_early_buffer_release(pepper_compositor_t *compositor,
+										   pepper_bool_t enable);
+
+PEPPER_API pepper_bool_t
+pepper_compositor_get_early_buffer_release(pepper_compositor_t *compositor);
+
 PEPPER_API void
 pepper_output_destroy(pepper_output_t *output);
 
@@ -916,6 +964,12 @@ pepper_output_set_mode(pepper_output_t *output,
 PEPPER_API const char *
 pepper_output_get_name(pepper_output_t *output);
 
+PEPPER_API void
+pepper_output_set_repaint_window(pepper_output_t *output, int32_t msec);
+
+PEPPER_API int32_t
+pepper_output_get_repaint_window(pepper_output_t *output);
+
 PEPPER_API pepper_output_t *
 pepper_compositor_find_output(pepper_compositor_t *compositor,
 							  const char *name);
@@ -1077,6 +1131,16 @@ pepper_pointer_get_cursor_view(pepper_pointer_t *pointer);
 PEPPER_API void
 pepper_pointer_set_hotspot(pepper_pointer_t *pointer, int32_t x, int32_t y);
 
+PEPPER_API void
+pepper_pointer_set_motion_coalescing(pepper_pointer_t *pointer, pepper_bool_t enable);
+
+PEPPER_API pepper_bool_t
+pepper_pointer_get_motion_coalescing(pepper_pointer_t *pointer);
+
+PEPPER_API void
+pepper_pointer_get_motion_stats(pepper_pointer_t *pointer, uint32_t *received,
+								uint32_t *merged);
+
 /* Keyboard. */
 struct pepper_keyboard_grab {
 	/**
@@ -1308,6 +1372,9 @@ pepper_buffer_get_resource(pepper_buffer_t *buffer);
 PEPPER_API pepper_bool_t
 pepper_buffer_get_size(pepper_buffer_t *buffer, int *w, int *h);
 
+PEPPER_API const pepper_dmabuf_attributes_t *
+pepper_buffer_get_dmabuf_attributes(pepper_buffer_t *buffer);
+
 /* View. */
 PEPPER_API pepper_view_t *
 pepper_compositor_add_view(pepper_compositor_t *compositor);
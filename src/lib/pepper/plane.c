@@ -37,12 +37,13 @@ pepper_plane_update(pepper_plane_t *plane, const pepper_list_t *view_list,
 	int                 w = plane->output->geometry.w;
 	int                 h = plane->output->geometry.h;
 	pepper_region_t   plane_clip;
-	pepper_view_t      *view;
+	pepper_list_t      *l;
 
 	pepper_region_init(&plane_clip);
 	pepper_list_init(&plane->entry_list);
 
-	pepper_list_for_each(view, view_list, link) {
+	pepper_list_for_each_list(l, view_list) {
+		pepper_view_t        *view = l->item;
 		pepper_plane_entry_t *entry = &view->plane_entries[plane->output->id];
 
 		if (entry->plane == plane) {
@@ -222,3 +223,17 @@ pepper_plane_clear_damage_region(pepper_plane_t *plane)
 {
 	pepper_region_clear(&plane->damage_region);
 }
+
+/**
+ * Mark whether views on a plane are presented without copy.
+ *
+ * @param plane     plane to mark
+ * @param zero_copy PEPPER_TRUE if the plane scans out client buffers directly
+ *
+ * Presentation feedback of the views on a zero-copy plane is reported with the zero-copy flag.
+ */
+PEPPER_API void
+pepper_plane_set_zero_copy(pepper_plane_t *plane, pepper_bool_t zero_copy)
+{
+	plane->zero_copy = zero_copy;
+}
@@ -29,6 +29,9 @@
 #include "pepper-internal.h"
 #include <float.h>
 
+/* Cursor images larger than this are composited. */
+#define PEPPER_CURSOR_MAX_SIZE  256
+
 static pepper_view_t *
 get_cursor_view(pepper_pointer_t *pointer)
 {
@@ -130,9 +133,12 @@ pointer_set_position(pepper_pointer_t *pointer, uint32_t time, double x,
 
 	pointer_clamp(pointer);
 
-	if (pointer->cursor_view)
-		pepper_view_set_position(pointer->cursor_view,
-								 x - pointer->hotspot_x, y - pointer->hotspot_y);
+	/* A cursor on a hardware cursor plane is moved by the backends without a repaint. */
+	if (pointer->cursor_view &&
+		!pepper_view_move_cursor(pointer->cursor_view, pointer->x - pointer->hotspot_x,
+								 pointer->y - pointer->hotspot_y))
+		pepper_view_set_position(pointer->cursor_view, pointer->x - pointer->hotspot_x,
+								 pointer->y - pointer->hotspot_y);
 
 	if (pointer->grab)
 		pointer->grab->motion(pointer, pointer->data, time, pointer->x, pointer->y);
@@ -146,24 +152,81 @@ pointer_set_position(pepper_pointer_t *pointer, uint32_t time, double x,
 	pepper_object_emit_event(&pointer->base, PEPPER_EVENT_POINTER_MOTION, &event);
 }
 
+static void
+pointer_queue_motion(pepper_pointer_t *pointer, uint32_t time, double x,
+					 double y)
+{
+	pointer->motion.received++;
+
+	/* Apply the clamp on every event so that the result is the same as the one of dispatching
+	 * each motion separately. */
+	x = PEPPER_MIN(PEPPER_MAX(x, pointer->clamp.x0), pointer->clamp.x1);
+	y = PEPPER_MIN(PEPPER_MAX(y, pointer->clamp.y0), pointer->clamp.y1);
+
+	if (pointer->motion.pending) {
+		pointer->motion.merged++;
+	} else {
+		pointer->motion.pending = PEPPER_TRUE;
+		pepper_compositor_schedule_repaint(pointer->seat->compositor);
+	}
+
+	pointer->motion.time = time;
+	pointer->motion.x = x;
+	pointer->motion.y = y;
+}
+
+void
+pepper_pointer_flush_motion(pepper_pointer_t *pointer)
+{
+	if (!pointer->motion.pending)
+		return;
+
+	pointer->motion.pending = PEPPER_FALSE;
+	pointer_set_position(pointer, pointer->motion.time, pointer->motion.x,
+						 pointer->motion.y);
+}
+
 void
 pepper_pointer_handle_event(pepper_pointer_t *pointer, uint32_t id,
 							pepper_input_event_t *event)
 {
-	pointer->time = event->time;
+	double x, y;
+
+	/* Frame events might not carry any info. */
+	if (event)
+		pointer->time = event->time;
 
 	switch (id) {
 	case PEPPER_EVENT_INPUT_DEVICE_POINTER_MOTION_ABSOLUTE: {
-		pointer_set_position(pointer, event->time, event->x, event->y);
+		if (pointer->motion.enabled)
+			pointer_queue_motion(pointer, event->time, event->x, event->y);
+		else
+			pointer_set_position(pointer, event->time, event->x, event->y);
 	}
 	break;
 	case PEPPER_EVENT_INPUT_DEVICE_POINTER_MOTION: {
-		pointer_set_position(pointer, event->time,
-							 pointer->x + event->x * pointer->x_velocity,
-							 pointer->y + event->y * pointer->y_velocity);
+		if (pointer->motion.enabled) {
+			x = pointer->motion.pending ? pointer->motion.x : pointer->x;
+			y = pointer->motion.pending ? pointer->motion.y : pointer->y;
+
+			pointer_queue_motion(pointer, event->time,
+								 x + event->x * pointer->x_velocity,
+								 y + event->y * pointer->y_velocity);
+		} else {
+			pointer_set_position(pointer, event->time,
+								 pointer->x + event->x * pointer->x_velocity,
+								 pointer->y + event->y * pointer->y_velocity);
+		}
+	}
+	break;
+	case PEPPER_EVENT_INPUT_DEVICE_POINTER_FRAME: {
+		pepper_pointer_flush_motion(pointer);
 	}
 	break;
 	case PEPPER_EVENT_INPUT_DEVICE_POINTER_BUTTON: {
+		/* Buttons must be delivered at the position they were pressed. */
+		pepper_pointer_flush_motion(pointer);
+
 		if (pointer->grab) {
 			pointer->grab->button(pointer, pointer->data,
 								  event->time, event->button, event->state);
@@ -173,6 +236,8 @@ pepper_pointer_handle_event(pepper_pointer_t *pointer, uint32_t id,
 	}
 	break;
 	case PEPPER_EVENT_INPUT_DEVICE_POINTER_AXIS: {
+		pepper_pointer_flush_motion(pointer);
+
 		if (pointer->grab)
 			pointer->grab->axis(pointer, pointer->data, event->time, event->axis,
 								event->value);
@@ -705,3 +770,139 @@ pepper_pointer_set_hotspot(pepper_pointer_t *pointer, int32_t x, int32_t y)
 	pointer->hotspot_x = x;
 	pointer->hotspot_y = y;
 }
+
+/**
+ * Get the hotspot of the pointer cursor shown by the given view
+ *
+ * @param view  view object
+ * @param x     pointer to receive x coordinate of the hotspot in surface space
+ * @param y     pointer to receive y coordinate of the hotspot in surface space
+ *
+ * @return PEPPER_TRUE if the view is the cursor view of a pointer, otherwise PEPPER_FALSE
+ *
+ * Output backends showing the cursor through a native cursor of the host window system need the
+ * hotspot to place the cursor image.
+ */
+PEPPER_API pepper_bool_t
+pepper_view_get_cursor_hotspot(pepper_view_t *view, int32_t *x, int32_t *y)
+{
+	pepper_seat_t *seat;
+
+	pepper_list_for_each(seat, &view->compositor->seat_list, link) {
+		if (!seat->pointer || seat->pointer->cursor_view != view)
+			continue;
+
+		if (x)
+			*x = seat->pointer->hotspot_x;
+
+		if (y)
+			*y = seat->pointer->hotspot_y;
+
+		return PEPPER_TRUE;
+	}
+
+	return PEPPER_FALSE;
+}
+
+/**
+ * Get the cursor image of the given view if it can be shown as a native cursor
+ *
+ * @param view  view object
+ *
+ * @return ARGB8888 shm buffer of the cursor image, NULL if the view can't be shown as is
+ *
+ * The view has to be the cursor view of a pointer, drawn unscaled and unrotated from an ARGB8888
+ * shm buffer of at most 256x256 containing the hotspot. Output backends showing the cursor through
+ * a native cursor of the host window system use this to pick the cursor view and its image.
+ */
+PEPPER_API struct wl_shm_buffer *
+pepper_view_get_cursor_buffer(pepper_view_t *view)
+{
+	pepper_buffer_t        *buffer;
+	struct wl_shm_buffer   *shm_buffer;
+	pepper_box_t           *extents;
+	int32_t                 w, h, hot_x, hot_y;
+
+	if (!view->surface || !pepper_view_get_cursor_hotspot(view, &hot_x, &hot_y))
+		return NULL;
+
+	buffer = pepper_surface_get_buffer(view->surface);
+	if (!buffer)
+		return NULL;
+
+	shm_buffer = wl_shm_buffer_get(pepper_buffer_get_resource(buffer));
+	if (!shm_buffer || wl_shm_buffer_get_format(shm_buffer) != WL_SHM_FORMAT_ARGB8888)
+		return NULL;
+
+	w = wl_shm_buffer_get_width(shm_buffer);
+	h = wl_shm_buffer_get_height(shm_buffer);
+
+	if (w > PEPPER_CURSOR_MAX_SIZE || h > PEPPER_CURSOR_MAX_SIZE)
+		return NULL;
+
+	if (hot_x < 0 || hot_y < 0 || hot_x >= w || hot_y >= h)
+		return NULL;
+
+	/* Scaled or rotated cursors can't be shown as is. */
+	extents = pepper_region_extents(pepper_view_get_bounding_region(view));
+	if (extents->x2 - extents->x1 != w || extents->y2 - extents->y1 != h)
+		return NULL;
+
+	return shm_buffer;
+}
+
+/**
+ * Enable or disable pointer motion coalescing
+ *
+ * @param pointer   pointer object
+ * @param enable    PEPPER_TRUE to coalesce motion, PEPPER_FALSE to dispatch every motion
+ *
+ * When coalescing is enabled, motion events from input devices are accumulated and dispatched
+ * as a single motion (one pick and one wl_pointer.motion) at the start of the next output frame
+ * or on a pointer frame event from the input backend. Pending motion is always delivered before
+ * a button or an axis event to keep the event order. Coalescing is disabled by default.
+ *
+ * @see pepper_pointer_get_motion_stats()
+ */
+PEPPER_API void
+pepper_pointer_set_motion_coalescing(pepper_pointer_t *pointer, pepper_bool_t enable)
+{
+	if (pointer->motion.enabled == enable)
+		return;
+
+	if (!enable)
+		pepper_pointer_flush_motion(pointer);
+
+	pointer->motion.enabled = enable;
+}
+
+/**
+ * Check if pointer motion coalescing is enabled
+ *
+ * @param pointer   pointer object
+ *
+ * @return PEPPER_TRUE if motion coalescing is enabled, PEPPER_FALSE otherwise
+ */
+PEPPER_API pepper_bool_t
+pepper_pointer_get_motion_coalescing(pepper_pointer_t *pointer)
+{
+	return pointer->motion.enabled;
+}
+
+/**
+ * Get the motion coalescing statistics of the given pointer
+ *
+ * @param pointer   pointer object
+ * @param received  pointer to receive the number of motion events received while coalescing
+ * @param merged    pointer to receive the number of motion events merged into another one
+ */
+PEPPER_API void
+pepper_pointer_get_motion_stats(pepper_pointer_t *pointer, uint32_t *received,
+								uint32_t *merged)
+{
+	if (received)
+		*received = pointer->motion.received;
+
+	if (merged)
+		*merged = pointer->motion.merged;
+}
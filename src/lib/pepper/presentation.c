@@ -0,0 +1,198 @@
+/*
+* Copyright © 2008-2012 Kristian Høgsberg
+* Copyright © 2010-2012 Intel Corporation
+* Copyright © 2011 Benjamin Franzke
+* Copyright © 2012 Collabora, Ltd.
+* Copyright © 2015 S-Core Corporation
+* Copyright © 2015-2016 Samsung Electronics co., Ltd. All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "pepper-internal.h"
+#include "presentation-time-server-protocol.h"
+
+static void
+feedback_resource_destroy_handler(struct wl_resource *resource)
+{
+	pepper_presentation_feedback_t *feedback = wl_resource_get_user_data(resource);
+
+	pepper_list_remove(&feedback->link);
+	free(feedback);
+}
+
+static void
+presentation_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	wl_resource_destroy(resource);
+}
+
+static void
+presentation_feedback(struct wl_client     *client,
+					  struct wl_resource   *resource,
+					  struct wl_resource   *surface_resource,
+					  uint32_t              callback)
+{
+	pepper_surface_t               *surface = wl_resource_get_user_data(surface_resource);
+	pepper_presentation_feedback_t *feedback;
+
+	feedback = calloc(1, sizeof(pepper_presentation_feedback_t));
+	PEPPER_CHECK(feedback, goto error, "calloc() failed.\n");
+
+	feedback->resource = wl_resource_create(client,
+											&wp_presentation_feedback_interface,
+											1, callback);
+	PEPPER_CHECK(feedback->resource, goto error, "wl_resource_create() failed.\n");
+
+	wl_resource_set_implementation(feedback->resource, NULL, feedback,
+								   feedback_resource_destroy_handler);
+
+	/* Feedback belongs to the next commit of the surface. */
+	feedback->link.item = feedback;
+	pepper_list_insert(surface->pending.feedback_list.prev, &feedback->link);
+	return;
+
+error:
+	if (feedback)
+		free(feedback);
+
+	wl_client_post_no_memory(client);
+}
+
+static const struct wp_presentation_interface presentation_implementation = {
+	presentation_destroy,
+	presentation_feedback,
+};
+
+static void
+unbind_resource(struct wl_resource *resource)
+{
+	wl_list_remove(wl_resource_get_link(resource));
+}
+
+static void
+presentation_bind(struct wl_client *client, void *data, uint32_t version,
+				  uint32_t id)
+{
+	pepper_compositor_t *compositor = data;
+	struct wl_resource  *resource;
+
+	resource = wl_resource_create(client, &wp_presentation_interface, version, id);
+	if (!resource) {
+		PEPPER_ERROR("wl_resource_create failed\n");
+		wl_client_post_no_memory(client);
+		return;
+	}
+
+	wl_list_insert(&compositor->presentation.resource_list,
+				   wl_resource_get_link(resource));
+	wl_resource_set_implementation(resource, &presentation_implementation,
+								   compositor, unbind_resource);
+
+	wp_presentation_send_clock_id(resource, compositor->clock_id);
+}
+
+pepper_bool_t
+pepper_presentation_init(pepper_compositor_t *compositor)
+{
+	wl_list_init(&compositor->presentation.resource_list);
+
+	compositor->presentation.global = wl_global_create(compositor->display,
+									  &wp_presentation_interface, 1,
+									  compositor, presentation_bind);
+	PEPPER_CHECK(compositor->presentation.global, return PEPPER_FALSE,
+				 "wl_global_create() failed.\n");
+
+	return PEPPER_TRUE;
+}
+
+void
+pepper_presentation_fini(pepper_compositor_t *compositor)
+{
+	if (compositor->presentation.global) {
+		wl_global_destroy(compositor->presentation.global);
+		compositor->presentation.global = NULL;
+	}
+}
+
+void
+pepper_presentation_send_clock_id(pepper_compositor_t *compositor)
+{
+	struct wl_resource *resource;
+
+	wl_resource_for_each(resource, &compositor->presentation.resource_list)
+	wp_presentation_send_clock_id(resource, compositor->clock_id);
+}
+
+void
+pepper_presentation_feedback_discard_list(pepper_list_t *list)
+{
+	pepper_presentation_feedback_t *feedback, *tmp;
+
+	pepper_list_for_each_safe(feedback, tmp, list, link) {
+		wp_presentation_feedback_send_discarded(feedback->resource);
+		wl_resource_destroy(feedback->resource);
+	}
+}
+
+void
+pepper_presentation_feedback_sync_list(pepper_list_t *list,
+									   pepper_output_t *output, uint32_t flags)
+{
+	pepper_presentation_feedback_t *feedback;
+	struct wl_resource             *resource;
+
+	pepper_list_for_each(feedback, list, link) {
+		struct wl_client *client = wl_resource_get_client(feedback->resource);
+
+		wl_resource_for_each(resource, &output->resource_list) {
+			if (wl_resource_get_client(resource) == client)
+				wp_presentation_feedback_send_sync_output(feedback->resource, resource);
+		}
+
+		feedback->flags |= flags;
+	}
+}
+
+void
+pepper_presentation_feedback_present_list(pepper_list_t *list,
+		pepper_output_t *output,
+		const struct timespec *ts, uint64_t seq,
+		uint32_t flags)
+{
+	pepper_presentation_feedback_t *feedback, *tmp;
+	uint32_t                        refresh = 0;
+	uint64_t                        sec = ts->tv_sec;
+
+	/* Mode refresh rate is in mHz. */
+	if (output->current_mode.refresh > 0)
+		refresh = (uint32_t)(1000000000000ULL / output->current_mode.refresh);
+
+	pepper_list_for_each_safe(feedback, tmp, list, link) {
+		wp_presentation_feedback_send_presented(feedback->resource,
+												(uint32_t)(sec >> 32),
+												(uint32_t)sec,
+												ts->tv_nsec, refresh,
+												(uint32_t)(seq >> 32),
+												(uint32_t)seq,
+												flags | feedback->flags);
+		wl_resource_destroy(feedback->resource);
+	}
+}
@@ -197,6 +197,10 @@ surface_state_move(pepper_surface_state_t *from, pepper_surface_state_t *to)
 
 	wl_list_insert_list(&to->frame_callback_list, &from->frame_callback_list);
 
+	/* Cached content update replaces the previously cached one. */
+	pepper_presentation_feedback_discard_list(&to->feedback_list);
+	pepper_list_insert_list(&to->feedback_list, &from->feedback_list);
+
 	/* Clear 'from' state */
 	from->x         = 0;
 	from->y         = 0;
@@ -209,6 +213,7 @@ surface_state_move(pepper_surface_state_t *from, pepper_surface_state_t *to)
 	pepper_region_clear(&from->input_region);
 
 	wl_list_init(&from->frame_callback_list);
+	pepper_list_init(&from->feedback_list);
 }
 
 static void
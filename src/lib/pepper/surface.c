@@ -89,6 +89,7 @@ pepper_surface_state_init(pepper_surface_state_t *state)
 							  UINT32_MAX, UINT32_MAX);
 
 	wl_list_init(&state->frame_callback_list);
+	pepper_list_init(&state->feedback_list);
 }
 
 void
@@ -103,6 +104,8 @@ pepper_surface_state_fini(pepper_surface_state_t *state)
 	wl_resource_for_each_safe(callback, next, &state->frame_callback_list)
 	wl_resource_destroy(callback);
 
+	pepper_presentation_feedback_discard_list(&state->feedback_list);
+
 	if (state->buffer)
 		pepper_event_listener_remove(state->buffer_destroy_listener);
 }
@@ -318,6 +321,7 @@ pepper_surface_create(pepper_compositor_t *compositor,
 	surface->pickable = PEPPER_TRUE;
 
 	wl_list_init(&surface->frame_callback_list);
+	pepper_list_init(&surface->feedback_list);
 	pepper_list_init(&surface->view_list);
 	pepper_object_emit_event(&compositor->base, PEPPER_EVENT_COMPOSITOR_SURFACE_ADD,
 							 surface);
@@ -361,6 +365,8 @@ pepper_surface_destroy(pepper_surface_t *surface)
 	wl_resource_for_each_safe(callback, nc, &surface->frame_callback_list)
 	wl_resource_destroy(callback);
 
+	pepper_presentation_feedback_discard_list(&surface->feedback_list);
+
 	if (surface->role)
 		free(surface->role);
 
@@ -432,6 +438,11 @@ pepper_surface_commit_state(pepper_surface_t *surface,
 	wl_list_insert_list(&surface->frame_callback_list, &state->frame_callback_list);
 	wl_list_init(&state->frame_callback_list);
 
+	/* wp_presentation.feedback(). Previous content update is superseded. */
+	pepper_presentation_feedback_discard_list(&surface->feedback_list);
+	pepper_list_insert_list(&surface->feedback_list, &state->feedback_list);
+	pepper_list_init(&state->feedback_list);
+
 	/* surface.damage(). */
 	pepper_region_copy(&surface->damage_region, &state->damage_region);
 	pepper_region_clear(&state->damage_region);
@@ -457,18 +468,6 @@ pepper_surface_commit(pepper_surface_t *surface)
 	pepper_object_emit_event(&surface->base, PEPPER_EVENT_SURFACE_COMMIT, NULL);
 }
 
-void
-pepper_surface_send_frame_callback_done(pepper_surface_t *surface,
-										uint32_t time)
-{
-	struct wl_resource *callback, *next;
-
-	wl_resource_for_each_safe(callback, next, &surface->frame_callback_list) {
-		wl_callback_send_done(callback, time);
-		wl_resource_destroy(callback);
-	}
-}
-
 /**
  * Get the wl_resource of the given surface
  *
@@ -41,10 +41,30 @@ static const struct wl_touch_interface touch_impl = {
 static pepper_touch_point_t *
 get_touch_point(pepper_touch_t *touch, uint32_t id)
 {
-	pepper_touch_point_t *point;
+	pepper_touch_point_t   *point;
+	int                     i;
 
-	pepper_list_for_each(point, &touch->point_list, link) {
-		if (point->id == id)
+	/* Device slots are small and dense, so the first probe hits for them. */
+	for (i = 0; i < PEPPER_TOUCH_MAX_POINTS; i++) {
+		point = &touch->points[(id + i) & (PEPPER_TOUCH_MAX_POINTS - 1)];
+
+		if (point->active && point->id == id)
+			return point;
+	}
+
+	return NULL;
+}
+
+static pepper_touch_point_t *
+get_free_touch_point(pepper_touch_t *touch, uint32_t id)
+{
+	pepper_touch_point_t   *point;
+	int                     i;
+
+	for (i = 0; i < PEPPER_TOUCH_MAX_POINTS; i++) {
+		point = &touch->points[(id + i) & (PEPPER_TOUCH_MAX_POINTS - 1)];
+
+		if (!point->active)
 			return point;
 	}
 
@@ -97,18 +117,22 @@ pepper_touch_handle_event(pepper_touch_t *touch, uint32_t id,
 						  pepper_input_event_t *event)
 {
 	switch (id) {
-	case PEPPER_EVENT_TOUCH_DOWN: {
+	case PEPPER_EVENT_INPUT_DEVICE_TOUCH_DOWN: {
 		if (touch->grab)
 			touch->grab->down(touch, touch->data, event->time, event->slot, event->x,
 							  event->y);
+
+		pepper_object_emit_event(&touch->base, PEPPER_EVENT_TOUCH_DOWN, event);
 	}
 	break;
-	case PEPPER_EVENT_TOUCH_UP: {
+	case PEPPER_EVENT_INPUT_DEVICE_TOUCH_UP: {
 		if (touch->grab)
 			touch->grab->up(touch, touch->data, event->time, event->slot);
+
+		pepper_object_emit_event(&touch->base, PEPPER_EVENT_TOUCH_UP, event);
 	}
 	break;
-	case PEPPER_EVENT_TOUCH_MOTION: {
+	case PEPPER_EVENT_INPUT_DEVICE_TOUCH_MOTION: {
 		pepper_touch_point_t *point = get_touch_point(touch, event->slot);
 
 		PEPPER_CHECK(point, return, "get_touch_point() failed.\n");
@@ -119,21 +143,18 @@ pepper_touch_handle_event(pepper_touch_t *touch, uint32_t id,
 		if (touch->grab)
 			touch->grab->motion(touch, touch->data, event->time, event->slot, event->x,
 								event->y);
+
+		pepper_object_emit_event(&touch->base, PEPPER_EVENT_TOUCH_MOTION, event);
 	}
 	break;
-	case PEPPER_EVENT_TOUCH_FRAME: {
+	case PEPPER_EVENT_INPUT_DEVICE_TOUCH_FRAME: {
 		if (touch->grab)
 			touch->grab->frame(touch, touch->data);
-	}
-	break;
-	case PEPPER_EVENT_TOUCH_CANCEL: {
-		if (touch->grab)
-			touch->grab->cancel(touch, touch->data);
+
+		pepper_object_emit_event(&touch->base, PEPPER_EVENT_TOUCH_FRAME, event);
 	}
 	break;
 	}
-
-	pepper_object_emit_event(&touch->base, id, event);
 }
 
 pepper_touch_t *
@@ -147,7 +168,6 @@ pepper_touch_create(pepper_seat_t *seat)
 
 	touch->seat = seat;
 	wl_list_init(&touch->resource_list);
-	pepper_list_init(&touch->point_list);
 
 	return touch;
 }
@@ -155,15 +175,15 @@ pepper_touch_create(pepper_seat_t *seat)
 void
 pepper_touch_destroy(pepper_touch_t *touch)
 {
-	pepper_touch_point_t *point, *tmp;
+	int i;
 
 	PEPPER_CHECK(touch, return, "pepper_touch_destroy() failed.\n");
 
-	pepper_list_for_each_safe(point, tmp, &touch->point_list, link) {
-		if (point->focus_destroy_listener)
-			pepper_event_listener_remove(point->focus_destroy_listener);
+	for (i = 0; i < PEPPER_TOUCH_MAX_POINTS; i++) {
+		pepper_touch_point_t *point = &touch->points[i];
 
-		free(point);
+		if (point->active && point->focus_destroy_listener)
+			pepper_event_listener_remove(point->focus_destroy_listener);
 	}
 
 	if (touch->grab)
@@ -255,15 +275,15 @@ pepper_touch_add_point(pepper_touch_t *touch, uint32_t id, double x, double y)
 	pepper_touch_point_t *point = get_touch_point(touch, id);
 	PEPPER_CHECK(!point, return, "Touch point %d already exist.\n", id);
 
-	point = calloc(1, sizeof(pepper_touch_point_t));
-	PEPPER_CHECK(point, return, "malloc() failed.\n");
+	point = get_free_touch_point(touch, id);
+	PEPPER_CHECK(point, return, "Too many touch points.\n");
 
+	memset(point, 0, sizeof(pepper_touch_point_t));
 	point->touch = touch;
+	point->active = PEPPER_TRUE;
 	point->id = id;
 	point->x = x;
 	point->y = y;
-
-	pepper_list_insert(touch->point_list.prev, &point->link);
 }
 
 /**
@@ -279,8 +299,7 @@ pepper_touch_remove_point(pepper_touch_t *touch, uint32_t id)
 	PEPPER_CHECK(point, return, "Touch point %d does not exist.\n", id);
 
 	touch_point_set_focus(point, NULL);
-	pepper_list_remove(&point->link);
-	free(point);
+	point->active = PEPPER_FALSE;
 }
 
 /**
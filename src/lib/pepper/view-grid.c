@@ -0,0 +1,217 @@
+/*
+* Copyright © 2008-2012 Kristian Høgsberg
+* Copyright © 2010-2012 Intel Corporation
+* Copyright © 2011 Benjamin Franzke
+* Copyright © 2012 Collabora, Ltd.
+* Copyright © 2015 S-Core Corporation
+* Copyright © 2015-2016 Samsung Electronics co., Ltd. All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "pepper-internal.h"
+
+/* Views are indexed by the grid cells their bounding region extents cover. Cells are hashed into a
+ * fixed number of buckets, so the grid is not bound to any output layout. Views covering too many
+ * cells (ex. background or fullscreen views) are kept in a separate list tested on every pick. */
+
+static inline int32_t
+grid_cell(int32_t v)
+{
+	return v >> PEPPER_VIEW_GRID_CELL_SHIFT;
+}
+
+static inline pepper_list_t *
+grid_bucket(pepper_compositor_t *compositor, int32_t cx, int32_t cy)
+{
+	uint32_t hash = ((uint32_t)cx * 73856093u) ^ ((uint32_t)cy * 19349663u);
+
+	return &compositor->view_grid.buckets[hash & ((1 << PEPPER_VIEW_GRID_BUCKET_BITS) - 1)];
+}
+
+static void
+grid_update_z_order(pepper_compositor_t *compositor)
+{
+	pepper_view_t  *view;
+	uint32_t        z_index = 0;
+
+	if (!compositor->view_grid.z_order_dirty)
+		return;
+
+	pepper_list_for_each(view, &compositor->view_list, compositor_link)
+		view->z_index = z_index++;
+
+	compositor->view_grid.z_order_dirty = PEPPER_FALSE;
+}
+
+static pepper_bool_t
+view_contains_point(pepper_view_t *view, double x, double y, double *lx, double *ly)
+{
+	int ilx, ily;
+
+	if (!view->surface)
+		return PEPPER_FALSE;
+
+	if (!pepper_region_contains_point(&view->bounding_region, (int)x, (int)y, NULL))
+		return PEPPER_FALSE;
+
+	pepper_view_get_local_coordinate(view, x, y, lx, ly);
+
+	ilx = (int)*lx;
+	ily = (int)*ly;
+
+	if (ilx < 0 || ily < 0 || ilx >= view->w || ily >= view->h)
+		return PEPPER_FALSE;
+
+	return pepper_region_contains_point(&view->surface->input_region, ilx, ily, NULL);
+}
+
+void
+pepper_view_grid_init(pepper_compositor_t *compositor)
+{
+	int i;
+
+	for (i = 0; i < (1 << PEPPER_VIEW_GRID_BUCKET_BITS); i++)
+		pepper_list_init(&compositor->view_grid.buckets[i]);
+
+	pepper_list_init(&compositor->view_grid.large_list);
+	compositor->view_grid.z_order_dirty = PEPPER_TRUE;
+}
+
+void
+pepper_view_grid_remove(pepper_view_t *view)
+{
+	int i;
+
+	for (i = 0; i < view->grid_entry_count; i++)
+		pepper_list_remove(&view->grid_entries[i].link);
+
+	view->grid_entry_count = 0;
+
+	if (view->grid_large_link.next)
+		pepper_list_remove(&view->grid_large_link);
+}
+
+void
+pepper_view_grid_update(pepper_view_t *view)
+{
+	pepper_compositor_t    *compositor = view->compositor;
+	pepper_box_t           *box;
+	int32_t                 cx0, cy0, cx1, cy1, cx, cy;
+	int64_t                 count;
+
+	pepper_view_grid_remove(view);
+
+	if (!pepper_region_not_empty(&view->bounding_region))
+		return;
+
+	box = pepper_region_extents(&view->bounding_region);
+
+	cx0 = grid_cell(box->x1);
+	cy0 = grid_cell(box->y1);
+	cx1 = grid_cell(box->x2 - 1);
+	cy1 = grid_cell(box->y2 - 1);
+
+	count = (int64_t)(cx1 - cx0 + 1) * (int64_t)(cy1 - cy0 + 1);
+
+	if (count > PEPPER_VIEW_GRID_MAX_CELLS)
+		goto large;
+
+	if (count > view->grid_entry_size) {
+		pepper_view_grid_entry_t *entries;
+
+		entries = realloc(view->grid_entries, count * sizeof(pepper_view_grid_entry_t));
+		PEPPER_CHECK(entries, goto large, "realloc() failed.\n");
+
+		view->grid_entries = entries;
+		view->grid_entry_size = count;
+	}
+
+	for (cy = cy0; cy <= cy1; cy++) {
+		for (cx = cx0; cx <= cx1; cx++) {
+			pepper_view_grid_entry_t *entry = &view->grid_entries[view->grid_entry_count++];
+
+			entry->cx = cx;
+			entry->cy = cy;
+			entry->link.item = view;
+			pepper_list_insert(grid_bucket(compositor, cx, cy), &entry->link);
+		}
+	}
+
+	return;
+
+large:
+	view->grid_large_link.item = view;
+	pepper_list_insert(&compositor->view_grid.large_list, &view->grid_large_link);
+}
+
+pepper_view_t *
+pepper_view_grid_pick(pepper_compositor_t *compositor, double x, double y,
+					  double *vx, double *vy)
+{
+	int32_t                     cx = grid_cell((int)x);
+	int32_t                     cy = grid_cell((int)y);
+	pepper_view_t              *pick = NULL;
+	pepper_view_grid_entry_t   *entry;
+	pepper_list_t              *l;
+	double                      lx, ly, pick_x = 0.0, pick_y = 0.0;
+
+	grid_update_z_order(compositor);
+
+	/* Candidates are not sorted, keep the topmost one containing the point. */
+	pepper_list_for_each(entry, grid_bucket(compositor, cx, cy), link) {
+		pepper_view_t *view = entry->link.item;
+
+		if (entry->cx != cx || entry->cy != cy)
+			continue;
+
+		if (pick && view->z_index > pick->z_index)
+			continue;
+
+		if (view_contains_point(view, x, y, &lx, &ly)) {
+			pick = view;
+			pick_x = lx;
+			pick_y = ly;
+		}
+	}
+
+	pepper_list_for_each_list(l, &compositor->view_grid.large_list) {
+		pepper_view_t *view = l->item;
+
+		if (pick && view->z_index > pick->z_index)
+			continue;
+
+		if (view_contains_point(view, x, y, &lx, &ly)) {
+			pick = view;
+			pick_x = lx;
+			pick_y = ly;
+		}
+	}
+
+	if (pick) {
+		if (vx)
+			*vx = pick_x;
+
+		if (vy)
+			*vy = pick_y;
+	}
+
+	return pick;
+}
@@ -35,6 +35,8 @@ pepper_view_mark_dirty(pepper_view_t *view, uint32_t flag)
 	pepper_view_t  *child;
 	int             i;
 
+	view->compositor->update_scheduled = PEPPER_TRUE;
+
 	if (view->dirty & flag) {
 		PEPPER_TRACE("pepper_view_mark_dirty view:%p, dirty:%x, flag:%x\n", view, view->dirty, flag);
 		return;
@@ -91,6 +93,7 @@ view_insert(pepper_view_t *view, pepper_list_t *pos, pepper_bool_t subtree)
 	if ((pos != &view->compositor_link) && (pos->next != &view->compositor_link)) {
 		pepper_list_remove(&view->compositor_link);
 		pepper_list_insert(pos, &view->compositor_link);
+		view->compositor->view_grid.z_order_dirty = PEPPER_TRUE;
 		pepper_object_emit_event(&view->base, PEPPER_EVENT_VIEW_STACK_CHANGE, NULL);
 		pepper_view_mark_dirty(view, PEPPER_VIEW_Z_ORDER_DIRTY);
 	}
@@ -143,6 +146,50 @@ pepper_view_assign_plane(pepper_view_t *view, pepper_output_t *output,
 	plane_entry_set_plane(&view->plane_entries[output->id], plane);
 }
 
+/**
+ * Get the bounding region of the view in global space.
+ *
+ * @param view      view object
+ *
+ * @return bounding region of the view
+ *
+ * The region is up to date when the output backend assigns planes.
+ */
+PEPPER_API pepper_region_t *
+pepper_view_get_bounding_region(pepper_view_t *view)
+{
+	return &view->bounding_region;
+}
+
+/**
+ * Get the opaque region of the view in global space.
+ *
+ * @param view      view object
+ *
+ * @return opaque region of the view
+ *
+ * The region is empty when the view is not a pure translation of its surface.
+ */
+PEPPER_API pepper_region_t *
+pepper_view_get_opaque_region(pepper_view_t *view)
+{
+	return &view->opaque_region;
+}
+
+static void
+view_mark_output_view_list_dirty(pepper_view_t *view, uint32_t output_mask)
+{
+	pepper_output_t *output;
+
+	if (!output_mask)
+		return;
+
+	pepper_list_for_each(output, &view->compositor->output_list, link) {
+		if (output_mask & (1 << output->id))
+			output->view_list_dirty = PEPPER_TRUE;
+	}
+}
+
 void
 pepper_view_update(pepper_view_t *view)
 {
@@ -169,11 +216,18 @@ pepper_view_update(pepper_view_t *view)
 		return;
 	}
 
+	/* Visibility and stacking changes invalidate the view list of the outputs the view was on. */
+	if (view->dirty & (PEPPER_VIEW_ACTIVE_DIRTY | PEPPER_VIEW_Z_ORDER_DIRTY))
+		view_mark_output_view_list_dirty(view, view->output_overlap);
+
 	view->active = active;
 
 	/* Damage for the view unmap will be handled by assigning NULL plane. */
 	if (!view->active) {
 		PEPPER_TRACE("pepper_view_update view:%p not active\n", view);
+
+		/* Remaining dirty flags are handled when the view gets activated again. */
+		view->dirty &= ~PEPPER_VIEW_ACTIVE_DIRTY;
 		return;
 	}
 
@@ -216,6 +270,7 @@ pepper_view_update(pepper_view_t *view)
 		pepper_region_fini(&view->bounding_region);
 		pepper_region_init_rect(&view->bounding_region, 0, 0, view->w, view->h);
 		pepper_transform_region(&view->bounding_region, &view->global_transform);
+		pepper_view_grid_update(view);
 
 		/* Opaque region. */
 		if (view->surface && pepper_mat4_is_translation(&view->global_transform)) {
@@ -250,6 +305,9 @@ pepper_view_update(pepper_view_t *view)
 				}
 			}
                 }
+
+		/* Moving within the same set of outputs does not change any output's view list. */
+		view_mark_output_view_list_dirty(view, output_overlap_prev ^ view->output_overlap);
 	}
 
 	/* Mark the plane entries as damaged. */
@@ -260,6 +318,81 @@ pepper_view_update(pepper_view_t *view)
 	view->dirty = 0;
 }
 
+/* Move a view shown on the cursor planes of all the outputs it overlaps. Only the backends move
+ * it, the views below are not affected as long as the cursor has no opaque region. */
+pepper_bool_t
+pepper_view_move_cursor(pepper_view_t *view, double x, double y)
+{
+	pepper_output_t    *output;
+	pepper_mat4_t       transform;
+	pepper_region_t     bounding;
+	uint32_t            overlap = 0;
+
+	if (view->dirty || !view->active || view->parent || !view->output_overlap ||
+		!pepper_list_empty(&view->children_list) ||
+		pepper_region_not_empty(&view->opaque_region))
+		return PEPPER_FALSE;
+
+	pepper_mat4_init_translate(&transform, x, y, 0.0);
+	pepper_mat4_multiply(&transform, &transform, &view->transform);
+
+	pepper_region_init_rect(&bounding, 0, 0, view->w, view->h);
+	pepper_transform_region(&bounding, &transform);
+
+	pepper_list_for_each(output, &view->compositor->output_list, link) {
+		pepper_box_t   box = {
+			output->geometry.x,
+			output->geometry.y,
+			output->geometry.x + output->geometry.w,
+			output->geometry.y + output->geometry.h
+		};
+
+		if (pepper_region_contains_rectangle(&bounding, &box) != PEPPER_REGION_OUT)
+			overlap |= (1 << output->id);
+	}
+
+	/* Entering or leaving an output changes the view lists. */
+	if (overlap != view->output_overlap)
+		goto fail;
+
+	pepper_list_for_each(output, &view->compositor->output_list, link) {
+		if (!(overlap & (1 << output->id)))
+			continue;
+
+		if (!view->plane_entries[output->id].plane || !output->backend->move_cursor ||
+			!output->backend->move_cursor(output->data, view, x, y))
+			goto fail;
+	}
+
+	view->x = x;
+	view->y = y;
+	view->global_transform = transform;
+	pepper_mat4_inverse(&view->global_transform_inverse, &view->global_transform);
+	pepper_region_copy(&view->bounding_region, &bounding);
+	pepper_view_grid_update(view);
+
+	/* Keep the plane entries in sync for the next repaint without damaging the planes. */
+	pepper_list_for_each(output, &view->compositor->output_list, link) {
+		pepper_plane_entry_t *entry = &view->plane_entries[output->id];
+
+		if (!(overlap & (1 << output->id)))
+			continue;
+
+		pepper_region_intersect_rect(&entry->base.visible_region, &bounding,
+									   output->geometry.x, output->geometry.y,
+									   output->geometry.w, output->geometry.h);
+		pepper_region_global_to_output(&entry->base.visible_region, output);
+		entry->need_transform_update = PEPPER_TRUE;
+	}
+
+	pepper_region_fini(&bounding);
+	return PEPPER_TRUE;
+
+fail:
+	pepper_region_fini(&bounding);
+	return PEPPER_FALSE;
+}
+
 static void
 view_init(pepper_view_t *view, pepper_compositor_t *compositor)
 {
@@ -267,11 +400,11 @@ view_init(pepper_view_t *view, pepper_compositor_t *compositor)
 
 	view->compositor_link.item = view;
 	view->parent_link.item = view;
-	view->link.item = view;
 	view->surface_link.item = view;
 
 	view->compositor = compositor;
 	pepper_list_insert(&compositor->view_list, &view->compositor_link);
+	compositor->view_grid.z_order_dirty = PEPPER_TRUE;
 
 	pepper_list_init(&view->children_list);
 
@@ -283,6 +416,7 @@ view_init(pepper_view_t *view, pepper_compositor_t *compositor)
 	for (i = 0; i < PEPPER_MAX_OUTPUT_COUNT; i++) {
 		view->plane_entries[i].base.view = view;
 		view->plane_entries[i].link.item = &view->plane_entries[i];
+		view->plane_entries[i].output_link.item = view;
 	}
 }
 
@@ -375,9 +509,13 @@ pepper_view_destroy(pepper_view_t *view)
 							 PEPPER_EVENT_COMPOSITOR_VIEW_REMOVE, view);
 	pepper_object_fini(&view->base);
 
-	for (i = 0; i < PEPPER_MAX_OUTPUT_COUNT; i++)
+	for (i = 0; i < PEPPER_MAX_OUTPUT_COUNT; i++) {
 		plane_entry_set_plane(&view->plane_entries[i], NULL);
 
+		if (view->plane_entries[i].output_link.next)
+			pepper_list_remove(&view->plane_entries[i].output_link);
+	}
+
 	pepper_list_for_each_safe(child, tmp, &view->children_list, parent_link)
 	pepper_view_destroy(child);
 
@@ -385,6 +523,7 @@ pepper_view_destroy(pepper_view_t *view)
 		pepper_list_remove(&view->parent_link);
 
 	pepper_list_remove(&view->compositor_link);
+	pepper_view_grid_remove(view);
 
 	if (view->surface)
 		pepper_list_remove(&view->surface_link);
@@ -392,6 +531,7 @@ pepper_view_destroy(pepper_view_t *view)
 	pepper_region_fini(&view->opaque_region);
 	pepper_region_fini(&view->bounding_region);
 
+	free(view->grid_entries);
 	free(view);
 }
 
@@ -51,6 +51,8 @@ typedef struct gl_renderer      gl_renderer_t;
 typedef struct gl_shader        gl_shader_t;
 typedef struct gl_surface_state gl_surface_state_t;
 typedef struct gl_render_target gl_render_target_t;
+typedef struct gl_batch         gl_batch_t;
+typedef struct gl_shm_texture   gl_shm_texture_t;
 
 #ifndef EGL_EXT_platform_base
 typedef EGLDisplay  (*PFNEGLGETPLATFORMDISPLAYEXTPROC)(EGLenum
@@ -80,6 +82,20 @@ typedef EGLSurface  (*PFNEGLCREATEPLATFORMWINDOWSURFACEEXTPROC)(
 
 #define NUM_MAX_PLANES  3
 
+#ifdef EGL_EXT_image_dma_buf_import
+#define DMABUF_FOURCC(a, b, c, d)   \
+	((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+#define DMABUF_FORMAT_XRGB8888      DMABUF_FOURCC('X', 'R', '2', '4')
+#define DMABUF_FORMAT_ARGB8888      DMABUF_FOURCC('A', 'R', '2', '4')
+#define DMABUF_FORMAT_XBGR8888      DMABUF_FOURCC('X', 'B', '2', '4')
+#define DMABUF_FORMAT_ABGR8888      DMABUF_FOURCC('A', 'B', '2', '4')
+#define DMABUF_MOD_INVALID          ((1ULL << 56) - 1)
+#endif
+
+/* Number of textures cached per surface for recently attached shm buffers. */
+#define SHM_TEXTURE_CACHE_SIZE  3
+
 static const char vertex_shader[] =
 	"uniform mat4   trans;\n"
 	"attribute vec2 position;\n"
@@ -198,6 +214,18 @@ enum shader_sampler {
 	GL_SHADER_SAMPLER_NONE,
 };
 
+struct gl_batch {
+	gl_shader_t        *shader;
+	GLuint              textures[NUM_MAX_PLANES];
+	int                 num_planes;
+	GLint               filter;
+	pepper_bool_t       blend;
+
+	/* Range of vertices in gl_renderer::vertex_array. */
+	GLint               first;
+	GLsizei             count;
+};
+
 struct gl_shader {
 	GLuint      program;
 	GLuint      vertex_shader;
@@ -213,7 +241,8 @@ enum buffer_type {
 	BUFFER_TYPE_NONE,
 	BUFFER_TYPE_SHM,
 	BUFFER_TYPE_EGL,
-	BUFFER_TYPE_TBM
+	BUFFER_TYPE_TBM,
+	BUFFER_TYPE_DMABUF
 };
 
 #define MAX_BUFFER_COUNT    3
@@ -233,6 +262,9 @@ struct gl_render_target {
 
 	pepper_region_t           damages[MAX_BUFFER_COUNT];
 	int32_t                     damage_index;
+
+	/* Number of draw calls issued for the last repaint. */
+	uint32_t                    draw_calls;
 };
 
 struct gl_renderer {
@@ -256,12 +288,21 @@ struct gl_renderer {
 	PFNEGLSWAPBUFFERSWITHDAMAGEEXTPROC  swap_buffers_with_damage;
 #endif
 
+#ifdef EGL_KHR_partial_update
+	PFNEGLSETDAMAGEREGIONKHRPROC        set_damage_region;
+#endif
+
 	PFNEGLBINDWAYLANDDISPLAYWL      bind_display;
 	PFNEGLUNBINDWAYLANDDISPLAYWL    unbind_display;
 	PFNEGLQUERYWAYLANDBUFFERWL      query_buffer;
 
 	pepper_bool_t   has_buffer_age;
 
+#ifdef EGL_EXT_image_dma_buf_import
+	pepper_bool_t   has_dmabuf_import;
+	pepper_bool_t   has_dmabuf_import_modifiers;
+#endif
+
 	/* GL extensions. */
 	PFNGLEGLIMAGETARGETTEXTURE2DOESPROC image_target_texture_2d;
 
@@ -275,6 +316,31 @@ struct gl_renderer {
 	pepper_bool_t       use_clipper;
 	struct wl_array     vertex_array;
 	int                 triangles;
+
+	pepper_bool_t       use_batch;
+	struct wl_array     batches;
+	GLuint              vertex_buffer;
+
+	/* EGL rects (x, y, w, h) passed to partial update and swap with damage. */
+	struct wl_array     damage_rects;
+};
+
+struct gl_shm_texture {
+	gl_surface_state_t         *state;
+
+	pepper_buffer_t            *buffer;
+	pepper_event_listener_t    *buffer_destroy_listener;
+
+	GLuint                      texture;
+	int                         width, height;
+	int                         pitch;
+	GLenum                      format;
+	GLenum                      pixel_format;
+
+	/* Surface damage accumulated since this texture was last uploaded. */
+	pepper_region_t             damage;
+	pepper_bool_t               need_full_upload;
+	uint32_t                    last_used;
 };
 
 struct gl_surface_state {
@@ -299,10 +365,9 @@ struct gl_surface_state {
 	/* SHM buffer type. */
 	struct {
 		struct wl_shm_buffer   *buffer;
-		pepper_bool_t           need_full_upload;
-		GLenum                  format;
-		GLenum                  pixel_format;
-		int                     pitch;
+		gl_shm_texture_t        textures[SHM_TEXTURE_CACHE_SIZE];
+		gl_shm_texture_t       *current;
+		uint32_t                serial;
 	} shm;
 
 	/*TBM buffer type*/
@@ -408,7 +473,12 @@ gl_renderer_destroy(pepper_renderer_t *renderer)
 {
 	gl_renderer_t *gr = (gl_renderer_t *)renderer;
 
+	if (gr->vertex_buffer)
+		glDeleteBuffers(1, &gr->vertex_buffer);
+
 	wl_array_release(&gr->vertex_array);
+	wl_array_release(&gr->batches);
+	wl_array_release(&gr->damage_rects);
 
 	fini_gl_shaders(gr);
 
@@ -454,7 +524,6 @@ surface_state_ensure_textures(gl_surface_state_t *state, int num_planes)
 			glBindTexture(GL_TEXTURE_2D, state->textures[i]);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			state->shm.need_full_upload = PEPPER_TRUE;
 		} else if (state->textures[i] != 0 && i >= num_planes) {
 			glDeleteTextures(1, &state->textures[i]);
 			state->textures[i] = 0;
@@ -464,10 +533,65 @@ surface_state_ensure_textures(gl_surface_state_t *state, int num_planes)
 	state->num_planes = num_planes;
 }
 
+static void
+shm_texture_fini(gl_shm_texture_t *tex)
+{
+	if (tex->buffer_destroy_listener)
+		pepper_event_listener_remove(tex->buffer_destroy_listener);
+
+	if (tex->texture)
+		glDeleteTextures(1, &tex->texture);
+
+	if (tex->state->shm.current == tex)
+		tex->state->shm.current = NULL;
+
+	pepper_region_clear(&tex->damage);
+	tex->buffer = NULL;
+	tex->buffer_destroy_listener = NULL;
+	tex->texture = 0;
+}
+
+static void
+shm_texture_handle_buffer_destroy(pepper_event_listener_t    *listener,
+								  pepper_object_t            *object,
+								  uint32_t                    id,
+								  void                       *info,
+								  void                       *data)
+{
+	gl_shm_texture_t *tex = data;
+
+	/* Keep the texture of the displayed buffer, the surface still shows it. */
+	if (tex->state->shm.current == tex) {
+		pepper_event_listener_remove(tex->buffer_destroy_listener);
+		tex->buffer_destroy_listener = NULL;
+		tex->buffer = NULL;
+	} else {
+		shm_texture_fini(tex);
+	}
+}
+
+static void
+surface_state_fini_shm_textures(gl_surface_state_t *state)
+{
+	int i;
+
+	for (i = 0; i < SHM_TEXTURE_CACHE_SIZE; i++) {
+		shm_texture_fini(&state->shm.textures[i]);
+		pepper_region_fini(&state->shm.textures[i].damage);
+	}
+}
+
 static void
 surface_state_release_buffer(gl_surface_state_t *state)
 {
 	surface_state_destroy_images(state);
+
+	/* Textures of shm buffers are owned by the shm texture cache. */
+	if (state->buffer_type == BUFFER_TYPE_SHM) {
+		state->textures[0] = 0;
+		state->num_planes = 0;
+	}
+
 	surface_state_ensure_textures(state, 0);
 
 	if (state->buffer) {
@@ -496,6 +620,7 @@ surface_state_handle_surface_destroy(pepper_event_listener_t    *listener,
 {
 	gl_surface_state_t *state = data;
 	surface_state_release_buffer(state);
+	surface_state_fini_shm_textures(state);
 	pepper_event_listener_remove(state->surface_destroy_listener);
 	pepper_object_set_user_data((pepper_object_t *)state->surface, state->renderer,
 								NULL, NULL);
@@ -507,6 +632,7 @@ get_surface_state(pepper_renderer_t *renderer, pepper_surface_t *surface)
 {
 	gl_surface_state_t *state = pepper_object_get_user_data((
 									pepper_object_t *)surface, renderer);
+	int                 i;
 
 	if (!state) {
 		state = (gl_surface_state_t *)calloc(1, sizeof(gl_surface_state_t));
@@ -515,6 +641,11 @@ get_surface_state(pepper_renderer_t *renderer, pepper_surface_t *surface)
 
 		state->renderer = (gl_renderer_t *)renderer;
 		state->surface = surface;
+
+		for (i = 0; i < SHM_TEXTURE_CACHE_SIZE; i++) {
+			state->shm.textures[i].state = state;
+			pepper_region_init(&state->shm.textures[i].damage);
+		}
 		state->surface_destroy_listener =
 			pepper_object_add_event_listener((pepper_object_t *)surface,
 											 PEPPER_EVENT_OBJECT_DESTROY, 0,
@@ -526,6 +657,46 @@ get_surface_state(pepper_renderer_t *renderer, pepper_surface_t *surface)
 	return state;
 }
 
+static gl_shm_texture_t *
+surface_state_get_shm_texture(gl_surface_state_t *state, pepper_buffer_t *buffer)
+{
+	gl_shm_texture_t   *tex = NULL;
+	int                 i;
+
+	for (i = 0; i < SHM_TEXTURE_CACHE_SIZE; i++) {
+		if (state->shm.textures[i].buffer == buffer)
+			return &state->shm.textures[i];
+	}
+
+	/* Drop the texture of a destroyed buffer once it is no longer displayed. */
+	if (state->shm.current && !state->shm.current->buffer)
+		shm_texture_fini(state->shm.current);
+
+	/* Take an unused slot, or evict the least recently attached buffer. */
+	for (i = 0; i < SHM_TEXTURE_CACHE_SIZE; i++) {
+		if (!state->shm.textures[i].buffer) {
+			tex = &state->shm.textures[i];
+			break;
+		}
+
+		if (!tex || state->shm.textures[i].last_used < tex->last_used)
+			tex = &state->shm.textures[i];
+	}
+
+	if (tex->buffer_destroy_listener)
+		pepper_event_listener_remove(tex->buffer_destroy_listener);
+
+	tex->buffer = buffer;
+	tex->buffer_destroy_listener =
+		pepper_object_add_event_listener((pepper_object_t *)buffer,
+										 PEPPER_EVENT_OBJECT_DESTROY, 0,
+										 shm_texture_handle_buffer_destroy, tex);
+	tex->need_full_upload = PEPPER_TRUE;
+	pepper_region_clear(&tex->damage);
+
+	return tex;
+}
+
 static pepper_bool_t
 surface_state_attach_shm(gl_surface_state_t *state, pepper_buffer_t *buffer)
 {
@@ -536,6 +707,7 @@ surface_state_attach_shm(gl_surface_state_t *state, pepper_buffer_t *buffer)
 	GLenum                  format;
 	GLenum                  pixel_format;
 	int                     pitch;
+	gl_shm_texture_t       *tex;
 
 	if (!shm_buffer)
 		return PEPPER_FALSE;
@@ -567,14 +739,21 @@ surface_state_attach_shm(gl_surface_state_t *state, pepper_buffer_t *buffer)
 	w = wl_shm_buffer_get_width(shm_buffer);
 	h = wl_shm_buffer_get_height(shm_buffer);
 
-	if (state->buffer_type != BUFFER_TYPE_SHM ||
-		w != state->buffer_width || h != state->buffer_height ||
-		pitch != state->shm.pitch || format != state->shm.format ||
-		pixel_format != state->shm.pixel_format) {
+	tex = surface_state_get_shm_texture(state, buffer);
+
+	if (tex->width != w || tex->height != h || tex->pitch != pitch ||
+		tex->format != format || tex->pixel_format != pixel_format) {
 		/* Don't use glTexSubImage2D() for shm buffers in this case. */
-		state->shm.need_full_upload = PEPPER_TRUE;
+		tex->need_full_upload = PEPPER_TRUE;
 	}
 
+	tex->width              = w;
+	tex->height             = h;
+	tex->pitch              = pitch;
+	tex->format             = format;
+	tex->pixel_format       = pixel_format;
+	tex->last_used          = ++state->shm.serial;
+
 	state->buffer_type      = BUFFER_TYPE_SHM;
 	state->buffer_width     = w;
 	state->buffer_height    = h;
@@ -583,9 +762,7 @@ surface_state_attach_shm(gl_surface_state_t *state, pepper_buffer_t *buffer)
 	state->y_inverted       = 1;
 
 	state->shm.buffer       = shm_buffer;
-	state->shm.format       = format;
-	state->shm.pixel_format = pixel_format;
-	state->shm.pitch        = pitch;
+	state->shm.current      = tex;
 
 	state->sampler          = sampler;
 
@@ -612,6 +789,25 @@ surface_state_attach_tbm(gl_surface_state_t *state, pepper_buffer_t *buffer)
 }
 #endif
 
+#ifdef EGL_EXT_image_dma_buf_import
+static pepper_bool_t
+surface_state_attach_dmabuf(gl_surface_state_t *state, pepper_buffer_t *buffer)
+{
+	const pepper_dmabuf_attributes_t *attributes =
+		pepper_buffer_get_dmabuf_attributes(buffer);
+
+	if (!attributes || !state->renderer->has_dmabuf_import)
+		return PEPPER_FALSE;
+
+	state->buffer_width     = attributes->width;
+	state->buffer_height    = attributes->height;
+	state->y_inverted       = !(attributes->flags & PEPPER_DMABUF_Y_INVERT);
+	state->buffer_type      = BUFFER_TYPE_DMABUF;
+
+	return PEPPER_TRUE;
+}
+#endif
+
 static pepper_bool_t
 surface_state_attach_egl(gl_surface_state_t *state, pepper_buffer_t *buffer)
 {
@@ -654,6 +850,11 @@ gl_renderer_attach_surface(pepper_renderer_t *renderer,
 		goto done;
 #endif
 
+#ifdef EGL_EXT_image_dma_buf_import
+	if (surface_state_attach_dmabuf(state, buffer))
+		goto done;
+#endif
+
 	if (surface_state_attach_egl(state, buffer))
 		goto done;
 
@@ -787,54 +988,184 @@ surface_state_flush_tbm(gl_surface_state_t *state)
 }
 #endif
 
+#ifdef EGL_EXT_image_dma_buf_import
 static pepper_bool_t
-surface_state_flush_shm(gl_surface_state_t *state)
+surface_state_flush_dmabuf(gl_surface_state_t *state)
 {
-	gl_renderer_t *gr = (gl_renderer_t *)state->renderer;
+	gl_renderer_t                      *gr = (gl_renderer_t *)state->renderer;
+	const pepper_dmabuf_attributes_t   *attributes =
+		pepper_buffer_get_dmabuf_attributes(state->buffer);
+	EGLint                              attribs[64];
+	int                                 sampler;
+	int                                 i, n = 0;
+
+	static const EGLint plane_attribs[4][5] = {
+		{
+			EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT, EGL_DMA_BUF_PLANE0_PITCH_EXT,
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+			EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT,
+#endif
+		},
+		{
+			EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT, EGL_DMA_BUF_PLANE1_PITCH_EXT,
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+			EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT,
+#endif
+		},
+		{
+			EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT, EGL_DMA_BUF_PLANE2_PITCH_EXT,
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+			EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT,
+#endif
+		},
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+		{
+			EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT, EGL_DMA_BUF_PLANE3_PITCH_EXT,
+			EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT,
+		},
+#endif
+	};
+
+	if (!attributes)
+		return PEPPER_FALSE;
+
+	/* The dmabuf is shared with the client, importing once per attach is enough. */
+	if (state->num_planes == 1 && state->images[0] != EGL_NO_IMAGE_KHR)
+		return PEPPER_TRUE;
+
+	/* TODO: YUV dmabufs need per-plane imports or external textures. */
+	switch (attributes->format) {
+	case DMABUF_FORMAT_XRGB8888:
+	case DMABUF_FORMAT_XBGR8888:
+		sampler = GL_SHADER_SAMPLER_RGBX;
+		break;
+	case DMABUF_FORMAT_ARGB8888:
+	case DMABUF_FORMAT_ABGR8888:
+		sampler = GL_SHADER_SAMPLER_RGBA;
+		break;
+	default:
+		PEPPER_ERROR("Unsupported dmabuf format 0x%08x.\n", attributes->format);
+		return PEPPER_FALSE;
+	}
+
+	if (attributes->n_planes > 3 && !gr->has_dmabuf_import_modifiers)
+		return PEPPER_FALSE;
+
+	attribs[n++] = EGL_WIDTH;
+	attribs[n++] = attributes->width;
+	attribs[n++] = EGL_HEIGHT;
+	attribs[n++] = attributes->height;
+	attribs[n++] = EGL_LINUX_DRM_FOURCC_EXT;
+	attribs[n++] = attributes->format;
+
+	for (i = 0; i < attributes->n_planes; i++) {
+		attribs[n++] = plane_attribs[i][0];
+		attribs[n++] = attributes->fd[i];
+		attribs[n++] = plane_attribs[i][1];
+		attribs[n++] = attributes->offset[i];
+		attribs[n++] = plane_attribs[i][2];
+		attribs[n++] = attributes->stride[i];
+
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+		if (gr->has_dmabuf_import_modifiers &&
+			attributes->modifier[i] != DMABUF_MOD_INVALID) {
+			attribs[n++] = plane_attribs[i][3];
+			attribs[n++] = attributes->modifier[i] & 0xffffffff;
+			attribs[n++] = plane_attribs[i][4];
+			attribs[n++] = attributes->modifier[i] >> 32;
+		}
+#endif
+	}
+
+	attribs[n++] = EGL_NONE;
 
 	surface_state_ensure_textures(state, 1);
+	state->images[0] = gr->create_image(gr->display, EGL_NO_CONTEXT,
+										EGL_LINUX_DMA_BUF_EXT, NULL, attribs);
+	PEPPER_CHECK(state->images[0] != EGL_NO_IMAGE_KHR, return PEPPER_FALSE,
+				 "eglCreateImageKHR() failed for dmabuf.\n");
+
+	glActiveTexture(GL_TEXTURE0 + 0);
 	glBindTexture(GL_TEXTURE_2D, state->textures[0]);
+	gr->image_target_texture_2d(GL_TEXTURE_2D, state->images[0]);
+
+	state->sampler = sampler;
+
+	return PEPPER_TRUE;
+}
+#endif
+
+static pepper_bool_t
+surface_state_flush_shm(gl_surface_state_t *state)
+{
+	gl_renderer_t      *gr = (gl_renderer_t *)state->renderer;
+	gl_shm_texture_t   *tex = state->shm.current;
+	pepper_region_t    *damage = pepper_surface_get_damage_region(state->surface);
+	int                 i;
+
+	/* Cached textures of the other buffers miss this damage from now on. */
+	for (i = 0; i < SHM_TEXTURE_CACHE_SIZE; i++) {
+		if (&state->shm.textures[i] != tex && state->shm.textures[i].texture)
+			pepper_region_union(&state->shm.textures[i].damage,
+								&state->shm.textures[i].damage, damage);
+	}
+
+	if (!tex->texture) {
+		glGenTextures(1, &tex->texture);
+		glBindTexture(GL_TEXTURE_2D, tex->texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		tex->need_full_upload = PEPPER_TRUE;
+	}
+
+	state->textures[0] = tex->texture;
+	state->num_planes = 1;
+
+	glBindTexture(GL_TEXTURE_2D, tex->texture);
 
 	if (!gr->has_unpack_subimage) {
 		wl_shm_buffer_begin_access(state->shm.buffer);
-		glTexImage2D(GL_TEXTURE_2D, 0, state->shm.format,
+		glTexImage2D(GL_TEXTURE_2D, 0, tex->format,
 					 state->buffer_width, state->buffer_height, 0,
-					 state->shm.format, state->shm.pixel_format,
+					 tex->format, tex->pixel_format,
 					 wl_shm_buffer_get_data(state->shm.buffer));
 		wl_shm_buffer_end_access(state->shm.buffer);
-	} else if (state->shm.need_full_upload) {
-		glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, state->shm.pitch);
+	} else if (tex->need_full_upload) {
+		glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, tex->pitch);
 		glPixelStorei(GL_UNPACK_SKIP_PIXELS_EXT, 0);
 		glPixelStorei(GL_UNPACK_SKIP_ROWS_EXT, 0);
 
 		wl_shm_buffer_begin_access(state->shm.buffer);
-		glTexImage2D(GL_TEXTURE_2D, 0, state->shm.format,
+		glTexImage2D(GL_TEXTURE_2D, 0, tex->format,
 					 state->buffer_width, state->buffer_height, 0,
-					 state->shm.format, state->shm.pixel_format,
+					 tex->format, tex->pixel_format,
 					 wl_shm_buffer_get_data(state->shm.buffer));
 		wl_shm_buffer_end_access(state->shm.buffer);
-		state->shm.need_full_upload = PEPPER_FALSE;
+		tex->need_full_upload = PEPPER_FALSE;
 	} else {
-		int                 i, nrects;
+		int                 nrects;
 		pepper_box_t     *rects;
-		pepper_region_t  *damage;
 
-		damage = pepper_surface_get_damage_region(state->surface);
-		rects = pepper_region_rectangles(damage, &nrects);
+		/* Everything damaged since this buffer was uploaded the last time. */
+		pepper_region_union(&tex->damage, &tex->damage, damage);
+		rects = pepper_region_rectangles(&tex->damage, &nrects);
 
-		glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, state->shm.pitch);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, tex->pitch);
 		wl_shm_buffer_begin_access(state->shm.buffer);
 		for (i = 0; i < nrects; i++) {
 			glPixelStorei(GL_UNPACK_SKIP_PIXELS_EXT, rects[i].x1);
 			glPixelStorei(GL_UNPACK_SKIP_ROWS_EXT, rects[i].y1);
 			glTexSubImage2D(GL_TEXTURE_2D, 0, rects[i].x1, rects[i].y1,
 							rects[i].x2 - rects[i].x1, rects[i].y2 - rects[i].y1,
-							state->shm.format, state->shm.pixel_format,
+							tex->format, tex->pixel_format,
 							wl_shm_buffer_get_data(state->shm.buffer));
 		}
 		wl_shm_buffer_end_access(state->shm.buffer);
 	}
 
+	pepper_region_clear(&tex->damage);
+
+	pepper_event_listener_remove(state->buffer_destroy_listener);
 	state->buffer = NULL;
 	return PEPPER_TRUE;
 }
@@ -853,11 +1184,25 @@ gl_renderer_flush_surface_damage(pepper_renderer_t *renderer,
 #ifdef HAVE_TBM
 	else if (state->buffer_type == BUFFER_TYPE_TBM)
 		return surface_state_flush_tbm(state);
+#endif
+#ifdef EGL_EXT_image_dma_buf_import
+	else if (state->buffer_type == BUFFER_TYPE_DMABUF)
+		return surface_state_flush_dmabuf(state);
 #endif
 	else
 		return surface_state_flush_egl(state);
 }
 
+static pepper_bool_t
+gl_renderer_has_surface_copy(pepper_renderer_t *renderer,
+							 pepper_surface_t *surface)
+{
+	gl_surface_state_t *state = get_surface_state(renderer, surface);
+
+	/* Contents of shm buffers live in textures once uploaded. */
+	return state->buffer_type == BUFFER_TYPE_SHM && !state->buffer;
+}
+
 static pepper_bool_t
 gl_renderer_read_pixels(pepper_renderer_t *renderer,
 						int x, int y, int w, int h,
@@ -1059,6 +1404,7 @@ calc_vertices(gl_renderer_t *gr, gl_surface_state_t *state,
 	pepper_box_t *rects, *surface_rects;
 
 	GLfloat        *vertex_array;
+	size_t          start = gr->vertex_array.size;
 
 	surface_rects = pepper_region_rectangles(surface_region, &surface_nrects);
 	rects = pepper_region_rectangles(region, &nrects);
@@ -1134,6 +1480,9 @@ calc_vertices(gl_renderer_t *gr, gl_surface_state_t *state,
 			}
 		}
 	}
+
+	/* Drop the unused tail so that following vertices can be appended. */
+	gr->vertex_array.size = start + gr->triangles * 3 * 4 * sizeof(GLfloat);
 }
 
 static void
@@ -1154,6 +1503,7 @@ repaint_region_clip(gl_renderer_t *gr, gl_surface_state_t *state,
 	glEnableVertexAttribArray(1);
 
 	glDrawArrays(GL_TRIANGLES, 0, gr->triangles * 3);
+	((gl_render_target_t *)gr->base.target)->draw_calls++;
 
 	gr->vertex_array.size = 0;
 }
@@ -1237,6 +1587,173 @@ repaint_view_clip(pepper_renderer_t *renderer, pepper_output_t *output,
 	pepper_region_fini(&repaint);
 }
 
+static void
+batch_region(gl_renderer_t *gr, gl_shader_t *shader, gl_surface_state_t *state,
+			 GLint filter, pepper_bool_t blend, pepper_render_item_t *node,
+			 pepper_region_t *damage, pepper_region_t *surface_region)
+{
+	gl_batch_t *batch = NULL;
+	GLint       first = gr->vertex_array.size / (4 * sizeof(GLfloat));
+	int         i;
+
+	calc_vertices(gr, state, node, damage, surface_region);
+
+	if (gr->triangles == 0)
+		return;
+
+	/* Extend the last batch if it draws with exactly the same state. */
+	if (gr->batches.size > 0) {
+		batch = (gl_batch_t *)((char *)gr->batches.data + gr->batches.size) - 1;
+
+		if (batch->shader != shader || batch->filter != filter ||
+			batch->blend != blend || batch->num_planes != state->num_planes ||
+			batch->first + batch->count != first)
+			batch = NULL;
+
+		for (i = 0; batch && i < state->num_planes; i++) {
+			if (batch->textures[i] != state->textures[i])
+				batch = NULL;
+		}
+	}
+
+	if (!batch) {
+		batch = wl_array_add(&gr->batches, sizeof(gl_batch_t));
+		if (!batch) {
+			gr->vertex_array.size = first * 4 * sizeof(GLfloat);
+			return;
+		}
+
+		batch->shader = shader;
+		batch->num_planes = state->num_planes;
+		for (i = 0; i < state->num_planes; i++)
+			batch->textures[i] = state->textures[i];
+		batch->filter = filter;
+		batch->blend = blend;
+		batch->first = first;
+		batch->count = 0;
+	}
+
+	batch->count += gr->triangles * 3;
+}
+
+static void
+batch_view(pepper_renderer_t *renderer, pepper_output_t *output,
+		   pepper_render_item_t *node, pepper_region_t *damage)
+{
+	gl_renderer_t      *gr = (gl_renderer_t *)renderer;
+
+	pepper_surface_t   *surface = pepper_view_get_surface(node->view);
+	gl_surface_state_t *state = get_surface_state(renderer, surface);
+
+	gl_shader_t        *shader;
+	pepper_region_t   repaint;
+	pepper_region_t   surface_blend;
+	pepper_region_t  *surface_opaque;
+
+	pepper_region_init(&repaint);
+	pepper_region_intersect(&repaint, &node->visible_region, damage);
+
+	if (pepper_region_not_empty(&repaint)) {
+		int32_t             w, h;
+		GLint               filter;
+
+		pepper_surface_get_size(surface, &w, &h);
+		surface_opaque = pepper_surface_get_opaque_region(surface);
+		pepper_region_init_rect(&surface_blend, 0, 0, w, h);
+		pepper_region_subtract(&surface_blend, &surface_blend, surface_opaque);
+
+		filter = (node->transform.flags <= PEPPER_MATRIX_TRANSLATE) ? GL_NEAREST :
+				 GL_LINEAR;
+
+		if (pepper_region_not_empty(surface_opaque)) {
+			if (state->sampler == GL_SHADER_SAMPLER_RGBA)
+				shader = &gr->shaders[GL_SHADER_SAMPLER_RGBX];
+			else
+				shader = &gr->shaders[state->sampler];
+
+			batch_region(gr, shader, state, filter, PEPPER_FALSE, node, &repaint,
+						 surface_opaque);
+		}
+
+		if (pepper_region_not_empty(&surface_blend)) {
+			shader = &gr->shaders[state->sampler];
+			batch_region(gr, shader, state, filter, PEPPER_TRUE, node, &repaint,
+						 &surface_blend);
+		}
+
+		pepper_region_fini(&surface_blend);
+	}
+
+	pepper_region_fini(&repaint);
+}
+
+static void
+flush_batches(gl_renderer_t *gr)
+{
+	gl_render_target_t *gt = (gl_render_target_t *)gr->base.target;
+	gl_batch_t         *batch;
+	gl_shader_t        *shader = NULL;
+	float               trans[16];
+	int                 i;
+
+	if (gr->batches.size == 0)
+		goto done;
+
+	if (!gr->vertex_buffer)
+		glGenBuffers(1, &gr->vertex_buffer);
+
+	/* Vertices are already in output space, every batch shares the projection. */
+	for (i = 0; i < 16; i++)
+		trans[i] = (float)gt->proj_mat.m[i];
+
+	glBindBuffer(GL_ARRAY_BUFFER, gr->vertex_buffer);
+	glBufferData(GL_ARRAY_BUFFER, gr->vertex_array.size, gr->vertex_array.data,
+				 GL_STREAM_DRAW);
+
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat),
+						  (void *)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat),
+						  (void *)(2 * sizeof(GLfloat)));
+	glEnableVertexAttribArray(1);
+
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	wl_array_for_each(batch, &gr->batches) {
+		if (batch->shader != shader) {
+			shader = batch->shader;
+			gl_shader_use(gr, shader);
+
+			glUniform1f(shader->alpha_uniform, 1.0f /* FIXME: view->alpha? */);
+			for (i = 0; i < NUM_MAX_PLANES; i++)
+				glUniform1i(shader->texture_uniform[i], i);
+			glUniformMatrix4fv(shader->trans_uniform, 1, GL_FALSE, trans);
+		}
+
+		for (i = 0; i < batch->num_planes; i++) {
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D, batch->textures[i]);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, batch->filter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, batch->filter);
+		}
+
+		if (batch->blend)
+			glEnable(GL_BLEND);
+		else
+			glDisable(GL_BLEND);
+
+		glDrawArrays(GL_TRIANGLES, batch->first, batch->count);
+		gt->draw_calls++;
+	}
+
+	glDisable(GL_BLEND);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+done:
+	gr->batches.size = 0;
+	gr->vertex_array.size = 0;
+}
+
 static void
 set_vertex(gl_surface_state_t *state, int32_t sx, int32_t sy,
 		   GLfloat *vertex_array)
@@ -1284,6 +1801,7 @@ repaint_region_scissor(gl_renderer_t *gr, gl_surface_state_t *state,
 			glScissor(rects[j].x1, gt->height - rects[j].y2,
 					  rects[j].x2 - rects[j].x1, rects[j].y2 - rects[j].y1);
 			glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+			gt->draw_calls++;
 		}
 	}
 }
@@ -1387,6 +1905,71 @@ done:
 	pepper_region_fini(&repaint);
 }
 
+static EGLint *
+region_to_egl_rects(gl_renderer_t *gr, gl_render_target_t *gt,
+					pepper_region_t *region, EGLint *count)
+{
+	pepper_box_t   *boxes;
+	EGLint         *rects;
+	int             i, nboxes;
+
+	/* Damage is in output buffer space with the output transform already applied,
+	 * only the y-axis has to be flipped for the bottom-left origin of EGL. */
+	boxes = pepper_region_rectangles(region, &nboxes);
+
+	gr->damage_rects.size = 0;
+	rects = wl_array_add(&gr->damage_rects, nboxes * 4 * sizeof(EGLint));
+	if (!rects) {
+		*count = 0;
+		return NULL;
+	}
+
+	for (i = 0; i < nboxes; i++) {
+		rects[i * 4 + 0] = boxes[i].x1;
+		rects[i * 4 + 1] = gt->height - boxes[i].y2;
+		rects[i * 4 + 2] = boxes[i].x2 - boxes[i].x1;
+		rects[i * 4 + 3] = boxes[i].y2 - boxes[i].y1;
+	}
+
+	*count = nboxes;
+	return rects;
+}
+
+static void
+gl_renderer_set_damage_region(gl_renderer_t *gr, gl_render_target_t *gt,
+							  pepper_region_t *region)
+{
+#ifdef EGL_KHR_partial_update
+	EGLint *rects, count;
+
+	if (!gr->set_damage_region)
+		return;
+
+	rects = region_to_egl_rects(gr, gt, region, &count);
+	if (rects && count > 0)
+		gr->set_damage_region(gr->display, gt->surface, rects, count);
+#endif
+}
+
+static void
+gl_renderer_swap_buffers(gl_renderer_t *gr, gl_render_target_t *gt,
+						 pepper_region_t *damage)
+{
+#ifdef EGL_EXT_swap_buffers_with_damage
+	if (gr->swap_buffers_with_damage) {
+		EGLint *rects, count;
+
+		rects = region_to_egl_rects(gr, gt, damage, &count);
+		if (rects && count > 0) {
+			gr->swap_buffers_with_damage(gr->display, gt->surface, rects, count);
+			return;
+		}
+	}
+#endif
+
+	eglSwapBuffers(gr->display, gt->surface);
+}
+
 static void
 gl_renderer_repaint_output(pepper_renderer_t *renderer, pepper_output_t *output,
 						   const pepper_list_t *list, pepper_region_t *damage)
@@ -1406,11 +1989,10 @@ gl_renderer_repaint_output(pepper_renderer_t *renderer, pepper_output_t *output,
 	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
 	if (gr->has_buffer_age)
-		eglQuerySurface(gr->display, ((gl_render_target_t *)renderer->target)->surface,
-						EGL_BUFFER_AGE_EXT, &buffer_age);
+		eglQuerySurface(gr->display, gt->surface, EGL_BUFFER_AGE_EXT, &buffer_age);
 
 	if (!buffer_age || buffer_age - 1 > MAX_BUFFER_COUNT) {
-		pepper_region_init_rect(&total_damage, geom->x, geom->y, geom->w, geom->h);
+		pepper_region_init_rect(&total_damage, 0, 0, geom->w, geom->h);
 	} else {
 		int first = gt->damage_index + MAX_BUFFER_COUNT - (buffer_age - 1);
 
@@ -1420,12 +2002,17 @@ gl_renderer_repaint_output(pepper_renderer_t *renderer, pepper_output_t *output,
 		for (i = 0; i < buffer_age - 1; i++)
 			pepper_region_union(&total_damage, &total_damage,
 								  &gt->damages[(first + i) % MAX_BUFFER_COUNT]);
+	}
 
-		pepper_region_copy(&gt->damages[gt->damage_index], damage);
+	pepper_region_copy(&gt->damages[gt->damage_index], damage);
 
-		gt->damage_index += 1;
-		gt->damage_index %= MAX_BUFFER_COUNT;
-	}
+	gt->damage_index += 1;
+	gt->damage_index %= MAX_BUFFER_COUNT;
+
+	gt->draw_calls = 0;
+
+	/* Must be set after querying the buffer age and before any drawing. */
+	gl_renderer_set_damage_region(gr, gt, &total_damage);
 
 	if (pepper_region_not_empty(&total_damage)) {
 		pepper_list_t *l;
@@ -1448,7 +2035,13 @@ gl_renderer_repaint_output(pepper_renderer_t *renderer, pepper_output_t *output,
 			glDisable(GL_SCISSOR_TEST);
 		}
 
-		if (gr->use_clipper)
+		if (gr->use_batch) {
+			pepper_list_for_each_list_reverse(l, list)
+			batch_view(renderer, output, (pepper_render_item_t *)l->item,
+					   &total_damage);
+
+			flush_batches(gr);
+		} else if (gr->use_clipper)
 			pepper_list_for_each_list_reverse(l, list)
 			repaint_view_clip(renderer, output, (pepper_render_item_t *)l->item,
 							  &total_damage);
@@ -1460,10 +2053,63 @@ gl_renderer_repaint_output(pepper_renderer_t *renderer, pepper_output_t *output,
 
 	pepper_region_fini(&total_damage);
 
-	eglSwapBuffers(gr->display, ((gl_render_target_t *)renderer->target)->surface);
+	/* Only the damage of this frame differs from the previously posted one. */
+	gl_renderer_swap_buffers(gr, gt, damage);
+}
+
+#ifdef EGL_EXT_image_dma_buf_import
+static void
+add_dmabuf_formats(gl_renderer_t *gr)
+{
+	pepper_compositor_t    *compositor = gr->base.compositor;
+	static const uint32_t   formats[] = {
+		DMABUF_FORMAT_XRGB8888,
+		DMABUF_FORMAT_ARGB8888,
+		DMABUF_FORMAT_XBGR8888,
+		DMABUF_FORMAT_ABGR8888,
+	};
+	int                     i;
+
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+	PFNEGLQUERYDMABUFMODIFIERSEXTPROC query_modifiers = NULL;
+
+	if (gr->has_dmabuf_import_modifiers)
+		query_modifiers = (void *)eglGetProcAddress("eglQueryDmaBufModifiersEXT");
+#endif
+
+	for (i = 0; i < (int)(sizeof(formats) / sizeof(formats[0])); i++) {
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+		EGLuint64KHR   *modifiers;
+		EGLBoolean     *external_only;
+		EGLint          num_modifiers = 0, j;
+
+		if (query_modifiers &&
+			query_modifiers(gr->display, formats[i], 0, NULL, NULL, &num_modifiers) &&
+			num_modifiers > 0) {
+			modifiers = calloc(num_modifiers, sizeof(EGLuint64KHR));
+			external_only = calloc(num_modifiers, sizeof(EGLBoolean));
+
+			if (modifiers && external_only &&
+				query_modifiers(gr->display, formats[i], num_modifiers, modifiers,
+								external_only, &num_modifiers)) {
+				/* Only the modifiers sampled through GL_TEXTURE_2D are usable here. */
+				for (j = 0; j < num_modifiers; j++) {
+					if (!external_only[j])
+						pepper_compositor_add_dmabuf_format(compositor, formats[i],
+															modifiers[j]);
+				}
+			}
+
+			free(modifiers);
+			free(external_only);
+		}
+#endif
 
-	/* TODO: eglSwapBuffersWithDamage. */
+		/* Implicit modifier, the layout is negotiated by the drivers. */
+		pepper_compositor_add_dmabuf_format(compositor, formats[i], DMABUF_MOD_INVALID);
+	}
 }
+#endif
 
 static pepper_bool_t
 setup_egl_extensions(gl_renderer_t *gr)
@@ -1491,6 +2137,14 @@ setup_egl_extensions(gl_renderer_t *gr)
 	}
 #endif
 
+#ifdef EGL_KHR_partial_update
+	if (strstr(extensions, "EGL_KHR_partial_update")) {
+		gr->set_damage_region = (void *)eglGetProcAddress("eglSetDamageRegionKHR");
+	} else {
+		PEPPER_ERROR("Performance Warning: EGL_KHR_partial_update not supported.\n");
+	}
+#endif
+
 	if (strstr(extensions, "EGL_WL_bind_wayland_display")) {
 		gr->bind_display      = (void *)eglGetProcAddress("eglBindWaylandDisplayWL");
 		gr->unbind_display    = (void *)eglGetProcAddress("eglUnbindWaylandDisplayWL");
@@ -1504,6 +2158,20 @@ setup_egl_extensions(gl_renderer_t *gr)
 		}
 	}
 
+#ifdef EGL_EXT_image_dma_buf_import
+	if (gr->create_image && strstr(extensions, "EGL_EXT_image_dma_buf_import")) {
+		gr->has_dmabuf_import = PEPPER_TRUE;
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+		gr->has_dmabuf_import_modifiers =
+			strstr(extensions, "EGL_EXT_image_dma_buf_import_modifiers") != NULL;
+#endif
+
+		add_dmabuf_formats(gr);
+	} else {
+		PEPPER_ERROR("Performance Warning: EGL_EXT_image_dma_buf_import not supported.\n");
+	}
+#endif
+
 	if (strstr(extensions, "EGL_EXT_buffer_age")) {
 		gr->has_buffer_age = PEPPER_TRUE;
 	} else {
@@ -1651,6 +2319,7 @@ pepper_gl_renderer_create(pepper_compositor_t *compositor, void *native_display,
 	gr->base.destroy                =   gl_renderer_destroy;
 	gr->base.attach_surface         =   gl_renderer_attach_surface;
 	gr->base.flush_surface_damage   =   gl_renderer_flush_surface_damage;
+	gr->base.has_surface_copy       =   gl_renderer_has_surface_copy;
 	gr->base.read_pixels            =   gl_renderer_read_pixels;
 	gr->base.repaint_output         =   gl_renderer_repaint_output;
 
@@ -1677,6 +2346,11 @@ pepper_gl_renderer_create(pepper_compositor_t *compositor, void *native_display,
 	if (env && atoi(env) == 1)
 		gr->use_clipper = PEPPER_TRUE;
 
+	env = getenv("PEPPER_RENDER_GL_USE_BATCH");
+
+	if (env && atoi(env) == 1)
+		gr->use_batch = PEPPER_TRUE;
+
 	return &gr->base;
 
 error:
@@ -1867,3 +2541,9 @@ error:
 	free(target);
 	return NULL;
 }
+
+PEPPER_API uint32_t
+pepper_gl_renderer_get_draw_call_count(pepper_render_target_t *target)
+{
+	return ((gl_render_target_t *)target)->draw_calls;
+}
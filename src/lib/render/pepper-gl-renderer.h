@@ -44,6 +44,9 @@ pepper_gl_renderer_create_target(pepper_renderer_t *renderer, void *window,
 								 pepper_format_t format,
 								 const void *visual_id, int32_t width, int32_t height);
 
+PEPPER_API uint32_t
+pepper_gl_renderer_get_draw_call_count(pepper_render_target_t *target);
+
 #ifdef __cplusplus
 }
 #endif
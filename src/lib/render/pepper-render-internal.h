@@ -50,6 +50,10 @@ struct pepper_renderer {
 	pepper_bool_t   (*flush_surface_damage)(pepper_renderer_t *renderer,
 											pepper_surface_t *surface);
 
+	/* Whether the flushed contents no longer depend on the client buffer. */
+	pepper_bool_t   (*has_surface_copy)(pepper_renderer_t *renderer,
+										pepper_surface_t *surface);
+
 	pepper_bool_t   (*read_pixels)(pepper_renderer_t *renderer,
 								   int x, int y, int w, int h,
 								   void *pixels, pepper_format_t format);
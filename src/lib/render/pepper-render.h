@@ -59,6 +59,10 @@ PEPPER_API pepper_bool_t
 pepper_renderer_flush_surface_damage(pepper_renderer_t *renderer,
 									 pepper_surface_t *surface);
 
+PEPPER_API pepper_bool_t
+pepper_renderer_has_surface_copy(pepper_renderer_t *renderer,
+								 pepper_surface_t *surface);
+
 PEPPER_API void
 pepper_renderer_repaint_output(pepper_renderer_t *renderer,
 							   pepper_output_t *output,
@@ -31,6 +31,8 @@
 #include "pepper-render-internal.h"
 #include <pepper-output-backend.h>
 #include <pepper-utils-pixman.h>
+#include <pthread.h>
+#include <stdlib.h>
 
 #ifdef HAVE_TBM
 #include <tbm_surface.h>
@@ -40,15 +42,48 @@
 typedef struct pixman_renderer      pixman_renderer_t;
 typedef struct pixman_surface_state pixman_surface_state_t;
 typedef struct pixman_render_target pixman_render_target_t;
+typedef struct pixman_render_op     pixman_render_op_t;
+
+/* Bands thinner than this are not worth handing to another thread. */
+#define PIXMAN_RENDERER_MIN_BAND_HEIGHT 32
 
 struct pixman_render_target {
 	pepper_render_target_t  base;
 	pixman_image_t         *image;
 };
 
+/* A single composite of the render list, clipped to its output space region.
+ * Pixman validates images lazily on use, so every band wraps the source bits
+ * in its own image instead of sharing one across threads. */
+struct pixman_render_op {
+	pixman_op_t             op;
+	pixman_image_t         *image;      /* NULL for the background fill */
+	struct wl_shm_buffer   *shm_buffer; /* client memory behind image, if any */
+	pixman_transform_t      transform;
+	pixman_filter_t         filter;
+	pepper_region_t         region;
+};
+
 struct pixman_renderer {
 	pepper_renderer_t   base;
 	pixman_image_t     *background;
+
+	/* Worker threads compositing horizontal bands of the damage in parallel. */
+	struct {
+		int                 count;
+		pthread_t          *threads;
+		pthread_mutex_t     mutex;
+		pthread_cond_t      cond;
+		pthread_cond_t      done_cond;
+		pepper_bool_t       quit;
+
+		pixman_image_t     *target;
+		struct wl_array     ops;
+		pepper_box_t       *bands;
+		int                 num_bands;
+		int                 next_band;
+		int                 pending_bands;
+	} pool;
 };
 
 struct pixman_surface_state {
@@ -63,19 +98,11 @@ struct pixman_surface_state {
 
 	pixman_image_t          *image;
 
+	/* Copy of the shm buffer contents used for early buffer release. */
+	pixman_image_t          *shadow;
+	pepper_bool_t            need_full_copy;
 };
 
-static void
-pixman_renderer_destroy(pepper_renderer_t *renderer)
-{
-	pixman_renderer_t *pr = (pixman_renderer_t *)renderer;
-
-	if (pr->background)
-		pixman_image_unref(pr->background);
-
-	free(renderer);
-}
-
 static void
 surface_state_destroy_image(pixman_surface_state_t *state)
 {
@@ -88,6 +115,10 @@ surface_state_destroy_image(pixman_surface_state_t *state)
 static void
 surface_state_release_buffer(pixman_surface_state_t *state)
 {
+	/* The shadow lags behind unless the last contents were copied into it. */
+	if (state->image && state->image != state->shadow)
+		state->need_full_copy = PEPPER_TRUE;
+
 	surface_state_destroy_image(state);
 
 	if (state->buffer) {
@@ -117,6 +148,10 @@ surface_state_handle_surface_destroy(pepper_event_listener_t    *listener,
 	pixman_surface_state_t *state = data;
 
 	surface_state_release_buffer(state);
+
+	if (state->shadow)
+		pixman_image_unref(state->shadow);
+
 	pepper_event_listener_remove(state->surface_destroy_listener);
 	pepper_object_set_user_data((pepper_object_t *)state->surface, state->renderer,
 								NULL, NULL);
@@ -131,6 +166,10 @@ surface_state_begin_access(pixman_surface_state_t *state)
 	tbm_surface_h tbm_surface;
 #endif
 
+	/* Drawing from the shadow copy, the buffer has already been released. */
+	if (!state->buffer)
+		return;
+
 	shm_buffer = wl_shm_buffer_get(pepper_buffer_get_resource(state->buffer));
 	if (shm_buffer) {
 		wl_shm_buffer_begin_access(shm_buffer);
@@ -155,6 +194,9 @@ surface_state_end_access(pixman_surface_state_t *state)
 	tbm_surface_h tbm_surface;
 #endif
 
+	if (!state->buffer)
+		return;
+
 	shm_buffer = wl_shm_buffer_get(pepper_buffer_get_resource(state->buffer));
 	if (shm_buffer) {
 		wl_shm_buffer_end_access(shm_buffer);
@@ -170,6 +212,24 @@ surface_state_end_access(pixman_surface_state_t *state)
 #endif
 }
 
+/* Like surface_state_begin_access() but leaves shm buffers alone, for buffers read from
+ * other threads. */
+static void
+surface_state_begin_map(pixman_surface_state_t *state)
+{
+	if (state->buffer &&
+		!wl_shm_buffer_get(pepper_buffer_get_resource(state->buffer)))
+		surface_state_begin_access(state);
+}
+
+static void
+surface_state_end_map(pixman_surface_state_t *state)
+{
+	if (state->buffer &&
+		!wl_shm_buffer_get(pepper_buffer_get_resource(state->buffer)))
+		surface_state_end_access(state);
+}
+
 
 static pixman_surface_state_t *
 get_surface_state(pepper_renderer_t *renderer, pepper_surface_t *surface)
@@ -182,6 +242,7 @@ get_surface_state(pepper_renderer_t *renderer, pepper_surface_t *surface)
 		if (!state)
 			return NULL;
 
+		state->renderer = (pixman_renderer_t *)renderer;
 		state->surface = surface;
 		state->surface_destroy_listener =
 			pepper_object_add_event_listener((pepper_object_t *)surface,
@@ -194,6 +255,23 @@ get_surface_state(pepper_renderer_t *renderer, pepper_surface_t *surface)
 	return state;
 }
 
+static void
+surface_state_ensure_shadow(pixman_surface_state_t *state,
+							pixman_format_code_t format, int w, int h)
+{
+	if (state->shadow) {
+		if (pixman_image_get_format(state->shadow) == format &&
+			pixman_image_get_width(state->shadow) == w &&
+			pixman_image_get_height(state->shadow) == h)
+			return;
+
+		pixman_image_unref(state->shadow);
+	}
+
+	state->shadow = pixman_image_create_bits(format, w, h, NULL, 0);
+	state->need_full_copy = PEPPER_TRUE;
+}
+
 static pepper_bool_t
 surface_state_attach_shm(pixman_surface_state_t *state, pepper_buffer_t *buffer)
 {
@@ -235,6 +313,13 @@ surface_state_attach_shm(pixman_surface_state_t *state, pepper_buffer_t *buffer)
 	state->image = image;
 	//state->shm_buffer = shm_buffer;
 
+	if (pepper_compositor_get_early_buffer_release(state->renderer->base.compositor))
+		surface_state_ensure_shadow(state, format, w, h);
+	else if (state->shadow) {
+		pixman_image_unref(state->shadow);
+		state->shadow = NULL;
+	}
+
 	return PEPPER_TRUE;;
 }
 
@@ -336,9 +421,50 @@ static pepper_bool_t
 pixman_renderer_flush_surface_damage(pepper_renderer_t *renderer,
 									 pepper_surface_t *surface)
 {
+	pixman_surface_state_t *state = get_surface_state(renderer, surface);
+	pepper_region_t        *damage;
+
+	if (!state->shadow || !state->buffer || state->image == state->shadow)
+		return PEPPER_TRUE;
+
+	/* Surface damage maps onto the buffer only without buffer transform and scale. */
+	if (pepper_surface_get_buffer_transform(surface) != WL_OUTPUT_TRANSFORM_NORMAL ||
+		pepper_surface_get_buffer_scale(surface) != 1)
+		state->need_full_copy = PEPPER_TRUE;
+
+	damage = pepper_surface_get_damage_region(surface);
+
+	if (!state->need_full_copy)
+		pixman_image_set_clip_region32(state->shadow, (pixman_region32_t *)damage);
+
+	surface_state_begin_access(state);
+	pixman_image_composite32(PIXMAN_OP_SRC, state->image, NULL, state->shadow,
+							 0, 0, 0, 0, 0, 0,
+							 state->buffer_width, state->buffer_height);
+	surface_state_end_access(state);
+
+	pixman_image_set_clip_region32(state->shadow, NULL);
+	state->need_full_copy = PEPPER_FALSE;
+
+	/* Draw from the shadow from now on and let go of the client buffer. */
+	pixman_image_unref(state->image);
+	state->image = pixman_image_ref(state->shadow);
+
+	pepper_event_listener_remove(state->buffer_destroy_listener);
+	state->buffer = NULL;
+
 	return PEPPER_TRUE;
 }
 
+static pepper_bool_t
+pixman_renderer_has_surface_copy(pepper_renderer_t *renderer,
+								 pepper_surface_t *surface)
+{
+	pixman_surface_state_t *state = get_surface_state(renderer, surface);
+
+	return state->shadow && state->image == state->shadow;
+}
+
 static pepper_bool_t
 pixman_renderer_read_pixels(pepper_renderer_t *renderer,
 							int x, int y, int w, int h,
@@ -389,16 +515,104 @@ pixman_transform_from_pepper_mat4(pixman_transform_t *transform,
 	transform->matrix[2][2] = pixman_double_to_fixed(mat->m[15]);
 }
 
+static void
+view_get_transform(pepper_render_item_t *node, pixman_transform_t *trans,
+				   pixman_filter_t *filter)
+{
+	int32_t             x, y, w, h, scale;
+	pepper_surface_t   *surface = pepper_view_get_surface(node->view);
+
+	if (node->transform.flags <= PEPPER_MATRIX_TRANSLATE) {
+		pixman_transform_init_translate(trans,
+										-pixman_double_to_fixed(node->transform.m[12]),
+										-pixman_double_to_fixed(node->transform.m[13]));
+		*filter = PIXMAN_FILTER_NEAREST;
+	} else {
+		pixman_transform_from_pepper_mat4(trans, &node->inverse);
+		*filter = PIXMAN_FILTER_BILINEAR;
+	}
+
+	pepper_surface_get_buffer_offset(surface, &x, &y);
+	pepper_surface_get_size(surface, &w, &h);
+	pixman_transform_translate(trans, NULL,
+							   pixman_int_to_fixed(x), pixman_int_to_fixed(y));
+
+	switch (pepper_surface_get_buffer_transform(surface)) {
+	case WL_OUTPUT_TRANSFORM_FLIPPED:
+	case WL_OUTPUT_TRANSFORM_FLIPPED_90:
+	case WL_OUTPUT_TRANSFORM_FLIPPED_180:
+	case WL_OUTPUT_TRANSFORM_FLIPPED_270:
+		pixman_transform_scale(trans, NULL, pixman_int_to_fixed(-1),
+							   pixman_int_to_fixed(1));
+		pixman_transform_translate(trans, NULL, pixman_int_to_fixed(w), 0);
+		break;
+	}
+
+	switch (pepper_surface_get_buffer_transform(surface)) {
+	case WL_OUTPUT_TRANSFORM_NORMAL:
+	case WL_OUTPUT_TRANSFORM_FLIPPED:
+		break;
+	case WL_OUTPUT_TRANSFORM_90:
+	case WL_OUTPUT_TRANSFORM_FLIPPED_90:
+		pixman_transform_rotate(trans, NULL, 0, pixman_fixed_1);
+		pixman_transform_translate(trans, NULL, pixman_int_to_fixed(h), 0);
+		break;
+	case WL_OUTPUT_TRANSFORM_180:
+	case WL_OUTPUT_TRANSFORM_FLIPPED_180:
+		pixman_transform_rotate(trans, NULL, -pixman_fixed_1, 0);
+		pixman_transform_translate(trans, NULL,
+								   pixman_int_to_fixed(w),
+								   pixman_int_to_fixed(h));
+		break;
+	case WL_OUTPUT_TRANSFORM_270:
+	case WL_OUTPUT_TRANSFORM_FLIPPED_270:
+		pixman_transform_rotate(trans, NULL, 0, -pixman_fixed_1);
+		pixman_transform_translate(trans, NULL, 0, pixman_int_to_fixed(w));
+		break;
+	}
+
+	scale = pepper_surface_get_buffer_scale(surface);
+	pixman_transform_scale(trans, NULL,
+						   pixman_int_to_fixed(scale),
+						   pixman_int_to_fixed(scale));
+}
+
+/* Split the repaint region of a view into output space opaque and blend parts. */
+static void
+view_get_regions(pepper_render_item_t *node, pepper_output_t *output,
+				 pepper_region_t *repaint, pepper_region_t *opaque,
+				 pepper_region_t *blend)
+{
+	int32_t             w, h;
+	pepper_surface_t   *surface = pepper_view_get_surface(node->view);
+
+	pepper_surface_get_size(surface, &w, &h);
+	pepper_region_init_rect(blend, 0, 0, w, h);
+	pepper_region_init(opaque);
+
+	if (node->transform.flags <= PEPPER_MATRIX_TRANSLATE) {
+		pepper_region_copy(opaque, pepper_surface_get_opaque_region(surface));
+		pepper_region_subtract(blend, blend, opaque);
+
+		pepper_region_translate(opaque,
+								  (int)node->transform.m[12], (int)node->transform.m[13]);
+		pepper_region_global_to_output(opaque, output);
+		pepper_region_intersect(opaque, opaque, repaint);
+	}
+
+	pepper_region_translate(blend,
+							  (int)node->transform.m[12], (int)node->transform.m[13]);
+	pepper_region_global_to_output(blend, output);
+	pepper_region_intersect(blend, blend, repaint);
+}
+
 static void
 repaint_view(pepper_renderer_t *renderer, pepper_output_t *output,
 			 pepper_render_item_t *node, pepper_region_t *damage)
 {
-	int32_t                  x, y, w, h, scale;
-	pepper_surface_t        *surface = pepper_view_get_surface(node->view);
-
 	pixman_render_target_t  *target = (pixman_render_target_t *)renderer->target;
-	pepper_region_t        repaint, repaint_surface;
-	pepper_region_t        surface_blend, *surface_opaque;
+	pepper_region_t        repaint;
+	pepper_region_t        surface_blend, surface_opaque;
 	pixman_surface_state_t  *ps = get_surface_state(renderer,
 								  pepper_view_get_surface(node->view));
 
@@ -409,109 +623,27 @@ repaint_view(pepper_renderer_t *renderer, pepper_output_t *output,
 		pixman_transform_t  trans;
 		pixman_filter_t     filter;
 
-		if (node->transform.flags <= PEPPER_MATRIX_TRANSLATE) {
-			pixman_transform_init_translate(&trans,
-											-pixman_double_to_fixed(node->transform.m[12]),
-											-pixman_double_to_fixed(node->transform.m[13]));
-			filter = PIXMAN_FILTER_NEAREST;
-		} else {
-			pixman_transform_from_pepper_mat4(&trans, &node->inverse);
-			filter = PIXMAN_FILTER_BILINEAR;
-		}
-
-		pepper_surface_get_buffer_offset(surface, &x, &y);
-		pepper_surface_get_size(surface, &w, &h);
-		pixman_transform_translate(&trans, NULL,
-								   pixman_int_to_fixed(x), pixman_int_to_fixed(y));
-
-		switch (pepper_surface_get_buffer_transform(surface)) {
-		case WL_OUTPUT_TRANSFORM_FLIPPED:
-		case WL_OUTPUT_TRANSFORM_FLIPPED_90:
-		case WL_OUTPUT_TRANSFORM_FLIPPED_180:
-		case WL_OUTPUT_TRANSFORM_FLIPPED_270:
-			pixman_transform_scale(&trans, NULL, pixman_int_to_fixed(-1),
-								   pixman_int_to_fixed(1));
-			pixman_transform_translate(&trans, NULL, pixman_int_to_fixed(w), 0);
-			break;
-		}
+		view_get_transform(node, &trans, &filter);
+		pixman_image_set_transform(ps->image, &trans);
+		pixman_image_set_filter(ps->image, filter, NULL, 0);
 
-		switch (pepper_surface_get_buffer_transform(surface)) {
-		case WL_OUTPUT_TRANSFORM_NORMAL:
-		case WL_OUTPUT_TRANSFORM_FLIPPED:
-			break;
-		case WL_OUTPUT_TRANSFORM_90:
-		case WL_OUTPUT_TRANSFORM_FLIPPED_90:
-			pixman_transform_rotate(&trans, NULL, 0, pixman_fixed_1);
-			pixman_transform_translate(&trans, NULL, pixman_int_to_fixed(h), 0);
-			break;
-		case WL_OUTPUT_TRANSFORM_180:
-		case WL_OUTPUT_TRANSFORM_FLIPPED_180:
-			pixman_transform_rotate(&trans, NULL, -pixman_fixed_1, 0);
-			pixman_transform_translate(&trans, NULL,
-									   pixman_int_to_fixed(w),
-									   pixman_int_to_fixed(h));
-			break;
-		case WL_OUTPUT_TRANSFORM_270:
-		case WL_OUTPUT_TRANSFORM_FLIPPED_270:
-			pixman_transform_rotate(&trans, NULL, 0, -pixman_fixed_1);
-			pixman_transform_translate(&trans, NULL, 0, pixman_int_to_fixed(w));
-			break;
-		}
+		view_get_regions(node, output, &repaint, &surface_opaque, &surface_blend);
 
-		scale = pepper_surface_get_buffer_scale(surface);
-		pixman_transform_scale(&trans, NULL,
-							   pixman_int_to_fixed(scale),
-							   pixman_int_to_fixed(scale));
+		if (pepper_region_not_empty(&surface_opaque)) {
+			pixman_image_set_clip_region32(target->image, (pixman_region32_t*)&surface_opaque);
 
-		pixman_image_set_transform(ps->image, &trans);
-		pixman_image_set_filter(ps->image, filter, NULL, 0);
+			surface_state_begin_access(ps);
+			pixman_image_composite32(PIXMAN_OP_SRC, ps->image, NULL, target->image,
+									 0, 0, /* src_x, src_y */
+									 0, 0, /* mask_x, mask_y */
+									 0, 0, /* dest_x, dest_y */
+									 pixman_image_get_width(target->image),
+									 pixman_image_get_height(target->image));
+			surface_state_end_access(ps);
+		}
 
-		pepper_region_init(&repaint_surface);
-		pepper_region_init_rect(&surface_blend, 0, 0, w, h);
-
-		if (node->transform.flags <= PEPPER_MATRIX_TRANSLATE) {
-			surface_opaque = pepper_surface_get_opaque_region(surface);
-			pepper_region_subtract(&surface_blend, &surface_blend, surface_opaque);
-
-			if (pepper_region_not_empty(surface_opaque)) {
-				pepper_region_translate(surface_opaque,
-										  (int)node->transform.m[12], (int)node->transform.m[13]);
-				pepper_region_global_to_output(surface_opaque, output);
-				pepper_region_intersect(&repaint_surface, &repaint, surface_opaque);
-				pixman_image_set_clip_region32(target->image, (pixman_region32_t*)&repaint_surface);
-
-				surface_state_begin_access(ps);
-				pixman_image_composite32(PIXMAN_OP_SRC, ps->image, NULL, target->image,
-										 0, 0, /* src_x, src_y */
-										 0, 0, /* mask_x, mask_y */
-										 0, 0, /* dest_x, dest_y */
-										 pixman_image_get_width(target->image),
-										 pixman_image_get_height(target->image));
-				surface_state_end_access(ps);
-			}
-
-			if (pepper_region_not_empty(&surface_blend)) {
-				pepper_region_translate(&surface_blend,
-										  (int)node->transform.m[12], (int)node->transform.m[13]);
-				pepper_region_global_to_output(&surface_blend, output);
-				pepper_region_intersect(&repaint_surface, &repaint, &surface_blend);
-				pixman_image_set_clip_region32(target->image, (pixman_region32_t*)&repaint_surface);
-
-				surface_state_begin_access(ps);
-				pixman_image_composite32(PIXMAN_OP_OVER, ps->image, NULL, target->image,
-										 0, 0, /* src_x, src_y */
-										 0, 0, /* mask_x, mask_y */
-										 0, 0, /* dest_x, dest_y */
-										 pixman_image_get_width(target->image),
-										 pixman_image_get_height(target->image));
-				surface_state_end_access(ps);
-			}
-		} else {
-			pepper_region_translate(&surface_blend,
-									  (int)node->transform.m[12], (int)node->transform.m[13]);
-			pepper_region_global_to_output(&surface_blend, output);
-			pepper_region_intersect(&repaint_surface, &repaint, &surface_blend);
-			pixman_image_set_clip_region32(target->image, (pixman_region32_t*)&repaint_surface);
+		if (pepper_region_not_empty(&surface_blend)) {
+			pixman_image_set_clip_region32(target->image, (pixman_region32_t*)&surface_blend);
 
 			surface_state_begin_access(ps);
 			pixman_image_composite32(PIXMAN_OP_OVER, ps->image, NULL, target->image,
@@ -523,7 +655,7 @@ repaint_view(pepper_renderer_t *renderer, pepper_output_t *output,
 			surface_state_end_access(ps);
 		}
 
-		pepper_region_fini(&repaint_surface);
+		pepper_region_fini(&surface_opaque);
 		pepper_region_fini(&surface_blend);
 	}
 
@@ -544,6 +676,249 @@ clear_background(pixman_renderer_t *renderer, pepper_region_t *damage)
 							 pixman_image_get_height(target->image));
 }
 
+static void
+add_render_op(pixman_renderer_t *pr, pixman_op_t op, pixman_image_t *image,
+			  struct wl_shm_buffer *shm_buffer, pixman_transform_t *transform,
+			  pixman_filter_t filter, pepper_region_t *region)
+{
+	pixman_render_op_t *render_op;
+
+	render_op = wl_array_add(&pr->pool.ops, sizeof(pixman_render_op_t));
+	if (!render_op)
+		return;
+
+	render_op->op = op;
+	render_op->image = image ? pixman_image_ref(image) : NULL;
+	render_op->shm_buffer = shm_buffer;
+	if (transform)
+		render_op->transform = *transform;
+	render_op->filter = filter;
+	pepper_region_init(&render_op->region);
+	pepper_region_copy(&render_op->region, region);
+}
+
+static pixman_image_t *
+render_op_create_source(pixman_render_op_t *op)
+{
+	static const pixman_color_t black = { 0x0000, 0x0000, 0x0000, 0xffff };
+	pixman_image_t             *src;
+
+	if (!op->image)
+		return pixman_image_create_solid_fill(&black);
+
+	src = pixman_image_create_bits(pixman_image_get_format(op->image),
+								   pixman_image_get_width(op->image),
+								   pixman_image_get_height(op->image),
+								   pixman_image_get_data(op->image),
+								   pixman_image_get_stride(op->image));
+	if (!src)
+		return NULL;
+
+	pixman_image_set_transform(src, &op->transform);
+	pixman_image_set_filter(src, op->filter, NULL, 0);
+
+	return src;
+}
+
+static void
+add_view_render_ops(pixman_renderer_t *pr, pepper_output_t *output,
+					pepper_render_item_t *node, pepper_region_t *damage)
+{
+	pepper_region_t         repaint;
+	pepper_region_t         surface_blend, surface_opaque;
+	pixman_surface_state_t *ps = get_surface_state(&pr->base,
+								 pepper_view_get_surface(node->view));
+	struct wl_shm_buffer   *shm_buffer = NULL;
+
+	/* Drawing from the shadow copy doesn't touch client memory. */
+	if (ps->buffer)
+		shm_buffer = wl_shm_buffer_get(pepper_buffer_get_resource(ps->buffer));
+
+	pepper_region_init(&repaint);
+	pepper_region_intersect(&repaint, &node->visible_region, damage);
+
+	if (pepper_region_not_empty(&repaint)) {
+		pixman_transform_t  trans;
+		pixman_filter_t     filter;
+
+		view_get_transform(node, &trans, &filter);
+		view_get_regions(node, output, &repaint, &surface_opaque, &surface_blend);
+
+		if (pepper_region_not_empty(&surface_opaque))
+			add_render_op(pr, PIXMAN_OP_SRC, ps->image, shm_buffer, &trans, filter,
+						  &surface_opaque);
+
+		if (pepper_region_not_empty(&surface_blend))
+			add_render_op(pr, PIXMAN_OP_OVER, ps->image, shm_buffer, &trans, filter,
+						  &surface_blend);
+
+		pepper_region_fini(&surface_opaque);
+		pepper_region_fini(&surface_blend);
+	}
+
+	pepper_region_fini(&repaint);
+}
+
+static void
+composite_band(pixman_renderer_t *pr, pepper_box_t *band)
+{
+	pixman_image_t     *target = pr->pool.target;
+	pixman_image_t     *dst;
+	pixman_render_op_t *op;
+	pepper_region_t     clip;
+	int                 w = band->x2 - band->x1;
+	int                 h = band->y2 - band->y1;
+
+	/* Every band composites into its own image so that clips do not collide. */
+	dst = pixman_image_create_bits(pixman_image_get_format(target),
+								   pixman_image_get_width(target),
+								   pixman_image_get_height(target),
+								   pixman_image_get_data(target),
+								   pixman_image_get_stride(target));
+	if (!dst)
+		return;
+
+	wl_array_for_each(op, &pr->pool.ops) {
+		pixman_image_t *src;
+
+		pepper_region_init_rect(&clip, band->x1, band->y1, w, h);
+		pepper_region_intersect(&clip, &clip, &op->region);
+
+		if (pepper_region_not_empty(&clip) && (src = render_op_create_source(op))) {
+			/* libwayland recovers from a client truncating its pool with per thread
+			 * state, so the thread reading the memory has to be the one holding it. */
+			if (op->shm_buffer)
+				wl_shm_buffer_begin_access(op->shm_buffer);
+
+			pixman_image_set_clip_region32(dst, (pixman_region32_t *)&clip);
+			pixman_image_composite32(op->op, src, NULL, dst,
+									 band->x1, band->y1, /* src_x, src_y */
+									 0, 0,               /* mask_x, mask_y */
+									 band->x1, band->y1, /* dest_x, dest_y */
+									 w, h);
+
+			if (op->shm_buffer)
+				wl_shm_buffer_end_access(op->shm_buffer);
+
+			pixman_image_unref(src);
+		}
+
+		pepper_region_fini(&clip);
+	}
+
+	pixman_image_unref(dst);
+}
+
+/* Composite bands of the posted job until none is left. Called with the pool mutex held. */
+static void
+pool_run_bands(pixman_renderer_t *pr)
+{
+	while (pr->pool.next_band < pr->pool.num_bands) {
+		pepper_box_t *band = &pr->pool.bands[pr->pool.next_band++];
+
+		pthread_mutex_unlock(&pr->pool.mutex);
+		composite_band(pr, band);
+		pthread_mutex_lock(&pr->pool.mutex);
+
+		if (--pr->pool.pending_bands == 0)
+			pthread_cond_signal(&pr->pool.done_cond);
+	}
+}
+
+static void *
+pool_worker(void *data)
+{
+	pixman_renderer_t *pr = data;
+
+	pthread_mutex_lock(&pr->pool.mutex);
+
+	while (!pr->pool.quit) {
+		if (pr->pool.next_band < pr->pool.num_bands)
+			pool_run_bands(pr);
+		else
+			pthread_cond_wait(&pr->pool.cond, &pr->pool.mutex);
+	}
+
+	pthread_mutex_unlock(&pr->pool.mutex);
+	return NULL;
+}
+
+static void
+repaint_output_threaded(pixman_renderer_t *pr, pepper_output_t *output,
+						const pepper_list_t *render_list, pepper_region_t *damage)
+{
+	pixman_render_target_t *target = (pixman_render_target_t *)pr->base.target;
+	pepper_box_t           *extents = pepper_region_extents(damage);
+	pixman_render_op_t     *op;
+	pepper_list_t          *l;
+	int                     i, band_height, num_bands;
+
+	if (pr->background)
+		add_render_op(pr, PIXMAN_OP_SRC, NULL, NULL, NULL, PIXMAN_FILTER_NEAREST, damage);
+
+	pepper_list_for_each_list_reverse(l, render_list)
+	add_view_render_ops(pr, output, (pepper_render_item_t *)l->item, damage);
+
+	/* More bands than threads to even out views of different cost. */
+	num_bands = (pr->pool.count + 1) * 2;
+	band_height = (extents->y2 - extents->y1 + num_bands - 1) / num_bands;
+	if (band_height < PIXMAN_RENDERER_MIN_BAND_HEIGHT)
+		band_height = PIXMAN_RENDERER_MIN_BAND_HEIGHT;
+
+	for (i = 0, num_bands = 0; extents->y1 + i < extents->y2; i += band_height) {
+		pepper_box_t *band = &pr->pool.bands[num_bands++];
+
+		band->x1 = extents->x1;
+		band->x2 = extents->x2;
+		band->y1 = extents->y1 + i;
+		band->y2 = band->y1 + band_height;
+
+		if (band->y2 > extents->y2)
+			band->y2 = extents->y2;
+	}
+
+	/* Keep tbm buffers mapped for the whole job, shm buffers are accessed per band. */
+	pepper_list_for_each_list(l, render_list) {
+		pepper_render_item_t *node = l->item;
+		surface_state_begin_map(get_surface_state(&pr->base,
+								pepper_view_get_surface(node->view)));
+	}
+
+	pthread_mutex_lock(&pr->pool.mutex);
+
+	pr->pool.target = target->image;
+	pr->pool.num_bands = num_bands;
+	pr->pool.next_band = 0;
+	pr->pool.pending_bands = num_bands;
+	pthread_cond_broadcast(&pr->pool.cond);
+
+	pool_run_bands(pr);
+
+	while (pr->pool.pending_bands > 0)
+		pthread_cond_wait(&pr->pool.done_cond, &pr->pool.mutex);
+
+	pr->pool.num_bands = 0;
+	pr->pool.next_band = 0;
+	pr->pool.target = NULL;
+
+	pthread_mutex_unlock(&pr->pool.mutex);
+
+	pepper_list_for_each_list(l, render_list) {
+		pepper_render_item_t *node = l->item;
+		surface_state_end_map(get_surface_state(&pr->base,
+							  pepper_view_get_surface(node->view)));
+	}
+
+	wl_array_for_each(op, &pr->pool.ops) {
+		if (op->image)
+			pixman_image_unref(op->image);
+
+		pepper_region_fini(&op->region);
+	}
+
+	pr->pool.ops.size = 0;
+}
+
 static void
 pixman_renderer_repaint_output(pepper_renderer_t *renderer,
 							   pepper_output_t *output,
@@ -554,6 +929,11 @@ pixman_renderer_repaint_output(pepper_renderer_t *renderer,
 		pepper_list_t       *l;
 		pixman_renderer_t   *pr = (pixman_renderer_t *)renderer;
 
+		if (pr->pool.count > 0) {
+			repaint_output_threaded(pr, output, render_list, damage);
+			return;
+		}
+
 		if (pr->background)
 			clear_background((pixman_renderer_t *)renderer, damage);
 
@@ -562,6 +942,66 @@ pixman_renderer_repaint_output(pepper_renderer_t *renderer,
 	}
 }
 
+static void
+pool_init(pixman_renderer_t *pr, int count)
+{
+	int i;
+
+	pthread_mutex_init(&pr->pool.mutex, NULL);
+	pthread_cond_init(&pr->pool.cond, NULL);
+	pthread_cond_init(&pr->pool.done_cond, NULL);
+
+	pr->pool.bands = calloc((count + 1) * 2, sizeof(pepper_box_t));
+	pr->pool.threads = calloc(count, sizeof(pthread_t));
+	if (!pr->pool.bands || !pr->pool.threads)
+		return;
+
+	for (i = 0; i < count; i++) {
+		if (pthread_create(&pr->pool.threads[i], NULL, pool_worker, pr) != 0) {
+			PEPPER_ERROR("Failed to create pixman renderer worker thread.\n");
+			break;
+		}
+	}
+
+	pr->pool.count = i;
+}
+
+static void
+pool_fini(pixman_renderer_t *pr)
+{
+	int i;
+
+	pthread_mutex_lock(&pr->pool.mutex);
+	pr->pool.quit = PEPPER_TRUE;
+	pthread_cond_broadcast(&pr->pool.cond);
+	pthread_mutex_unlock(&pr->pool.mutex);
+
+	for (i = 0; i < pr->pool.count; i++)
+		pthread_join(pr->pool.threads[i], NULL);
+
+	free(pr->pool.threads);
+	free(pr->pool.bands);
+	wl_array_release(&pr->pool.ops);
+
+	pthread_cond_destroy(&pr->pool.done_cond);
+	pthread_cond_destroy(&pr->pool.cond);
+	pthread_mutex_destroy(&pr->pool.mutex);
+}
+
+static void
+pixman_renderer_destroy(pepper_renderer_t *renderer)
+{
+	pixman_renderer_t *pr = (pixman_renderer_t *)renderer;
+
+	if (pr->pool.threads)
+		pool_fini(pr);
+
+	if (pr->background)
+		pixman_image_unref(pr->background);
+
+	free(renderer);
+}
+
 PEPPER_API pepper_renderer_t *
 pepper_pixman_renderer_create(pepper_compositor_t *compositor)
 {
@@ -581,10 +1021,17 @@ pepper_pixman_renderer_create(pepper_compositor_t *compositor)
 		renderer->background = pixman_image_create_solid_fill(&bg_color);
 	}
 
+	env = getenv("PEPPER_RENDER_PIXMAN_THREADS");
+
+	/* The repainting thread takes bands as well, so spawn one less. */
+	if (env && atoi(env) > 1)
+		pool_init(renderer, atoi(env) - 1);
+
 	/* Backend functions. */
 	renderer->base.destroy              = pixman_renderer_destroy;
 	renderer->base.attach_surface       = pixman_renderer_attach_surface;
 	renderer->base.flush_surface_damage = pixman_renderer_flush_surface_damage;
+	renderer->base.has_surface_copy     = pixman_renderer_has_surface_copy;
 	renderer->base.read_pixels          = pixman_renderer_read_pixels;
 	renderer->base.repaint_output       = pixman_renderer_repaint_output;
 
@@ -350,7 +350,10 @@ __tdm_output_commit_cb(tdm_output *o, unsigned int sequence,
 
 	ts.tv_sec = tv_sec;
 	ts.tv_nsec = tv_usec * 1000;
-	pepper_output_finish_frame(output->base, &ts);
+	pepper_output_finish_frame_presented(output->base, &ts, sequence,
+										 PEPPER_OUTPUT_PRESENT_VSYNC |
+										 PEPPER_OUTPUT_PRESENT_HW_CLOCK |
+										 PEPPER_OUTPUT_PRESENT_HW_COMPLETION);
 }
 
 static void
@@ -523,16 +526,9 @@ pepper_tdm_output_flush_surface_damage(void *o, pepper_surface_t *surface,
 									   pepper_bool_t *keep_buffer)
 {
 	pepper_tdm_output_t    *output = o;
-	pepper_buffer_t *buffer = pepper_surface_get_buffer(surface);
 
 	pepper_renderer_flush_surface_damage(output->renderer, surface);
-
-	if (output->render_type == TDM_RENDER_TYPE_GL &&
-		(buffer && wl_shm_buffer_get(pepper_buffer_get_resource(buffer)))) {
-		*keep_buffer = PEPPER_FALSE;
-	} else {
-		*keep_buffer = PEPPER_TRUE;
-	}
+	*keep_buffer = !pepper_renderer_has_surface_copy(output->renderer, surface);
 }
 
 struct pepper_output_backend tdm_output_backend = {
@@ -61,8 +61,10 @@ handle_global(void *data, struct wl_registry *registry,
 	pepper_wayland_t *conn = data;
 
 	if (strcmp(interface, "wl_compositor") == 0) {
+		/* wl_surface.damage_buffer is available since version 4. */
+		conn->compositor_version = version < 4 ? version : 4;
 		conn->compositor = wl_registry_bind(registry, name, &wl_compositor_interface,
-											1);
+											conn->compositor_version);
 	} else if (strcmp(interface, "wl_seat") == 0) {
 		wayland_handle_global_seat(conn, registry, name, version);
 	} else if (strcmp(interface, "wl_shell") == 0) {
@@ -0,0 +1,159 @@
+/*
+* Copyright © 2008-2012 Kristian Høgsberg
+* Copyright © 2010-2012 Intel Corporation
+* Copyright © 2011 Benjamin Franzke
+* Copyright © 2012 Collabora, Ltd.
+* Copyright © 2015 S-Core Corporation
+* Copyright © 2015-2016 Samsung Electronics co., Ltd. All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include "wayland-internal.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void
+cursor_buffer_release(void *data, struct wl_buffer *buffer)
+{
+	wl_buffer_destroy(buffer);
+}
+
+static const struct wl_buffer_listener cursor_buffer_listener = {
+	cursor_buffer_release,
+};
+
+/* Copy the cursor image into a buffer of the host compositor. */
+static struct wl_buffer *
+create_cursor_buffer(wayland_output_t *output, struct wl_shm_buffer *shm_buffer)
+{
+	int32_t             w = wl_shm_buffer_get_width(shm_buffer);
+	int32_t             h = wl_shm_buffer_get_height(shm_buffer);
+	int32_t             stride = wl_shm_buffer_get_stride(shm_buffer);
+	int32_t             size = w * h * 4;
+	struct wl_shm_pool *pool;
+	struct wl_buffer   *buffer;
+	uint8_t            *pixels, *src;
+	int                 fd, i;
+
+	fd = pepper_create_anonymous_file(size);
+	PEPPER_CHECK(fd >= 0, return NULL, "Failed to create anonymous file.\n");
+
+	pixels = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (pixels == MAP_FAILED) {
+		PEPPER_ERROR("mmap() failed for fd=%d\n", fd);
+		close(fd);
+		return NULL;
+	}
+
+	wl_shm_buffer_begin_access(shm_buffer);
+	src = wl_shm_buffer_get_data(shm_buffer);
+	for (i = 0; i < h; i++)
+		memcpy(pixels + i * w * 4, src + i * stride, w * 4);
+	wl_shm_buffer_end_access(shm_buffer);
+
+	pool = wl_shm_create_pool(output->conn->shm, fd, size);
+	buffer = wl_shm_pool_create_buffer(pool, 0, w, h, w * 4, WL_SHM_FORMAT_ARGB8888);
+	wl_buffer_add_listener(buffer, &cursor_buffer_listener, NULL);
+	wl_shm_pool_destroy(pool);
+
+	munmap(pixels, size);
+	close(fd);
+
+	return buffer;
+}
+
+/* Set the host cursor of the seat to the cursor shown on its focused output. */
+void
+wayland_seat_set_cursor(wayland_seat_t *seat)
+{
+	wayland_output_t *output = seat->pointer.focus;
+
+	if (!output || !seat->pointer.wl_pointer)
+		return;
+
+	if (output->cursor.view) {
+		wl_pointer_set_cursor(seat->pointer.wl_pointer, seat->pointer.enter_serial,
+							  output->cursor.surface, output->cursor.hot_x,
+							  output->cursor.hot_y);
+	} else {
+		wl_pointer_set_cursor(seat->pointer.wl_pointer, seat->pointer.enter_serial,
+							  NULL, 0, 0);
+	}
+}
+
+static void
+update_seat_cursors(wayland_output_t *output)
+{
+	wayland_seat_t *seat;
+
+	pepper_list_for_each(seat, &output->conn->seat_list, link) {
+		if (seat->pointer.focus == output)
+			wayland_seat_set_cursor(seat);
+	}
+}
+
+void
+wayland_output_update_cursor(wayland_output_t *output)
+{
+	pepper_region_t        *damage = pepper_plane_get_damage_region(output->cursor_plane);
+	pepper_view_t          *view = output->cursor_view;
+	struct wl_shm_buffer   *shm_buffer;
+	struct wl_buffer       *buffer;
+	int32_t                 hot_x, hot_y;
+
+	if (!view) {
+		if (output->cursor.view) {
+			output->cursor.view = NULL;
+			update_seat_cursors(output);
+		}
+
+		pepper_plane_clear_damage_region(output->cursor_plane);
+		return;
+	}
+
+	/* The cursor image is only uploaded again when it has been changed. */
+	if (view != output->cursor.view || pepper_region_not_empty(damage)) {
+		shm_buffer = pepper_view_get_cursor_buffer(view);
+		buffer = shm_buffer ? create_cursor_buffer(output, shm_buffer) : NULL;
+
+		if (buffer) {
+			wl_surface_attach(output->cursor.surface, buffer, 0, 0);
+			wl_surface_damage(output->cursor.surface, 0, 0,
+							  wl_shm_buffer_get_width(shm_buffer),
+							  wl_shm_buffer_get_height(shm_buffer));
+			wl_surface_commit(output->cursor.surface);
+		}
+	}
+
+	pepper_view_get_cursor_hotspot(view, &hot_x, &hot_y);
+
+	if (view != output->cursor.view || hot_x != output->cursor.hot_x ||
+		hot_y != output->cursor.hot_y) {
+		output->cursor.view = view;
+		output->cursor.hot_x = hot_x;
+		output->cursor.hot_y = hot_y;
+		update_seat_cursors(output);
+	}
+
+	pepper_plane_clear_damage_region(output->cursor_plane);
+}
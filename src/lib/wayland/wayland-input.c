@@ -29,26 +29,58 @@
 #include "wayland-internal.h"
 #include <stdlib.h>
 
+static void
+pointer_emit_motion(wayland_seat_t *seat, uint32_t time,
+					wl_fixed_t surface_x, wl_fixed_t surface_y)
+{
+	const pepper_output_geometry_t *geometry;
+	pepper_input_event_t            event;
+
+	if (!seat->pointer.focus)
+		return;
+
+	/* Host surface coordinates are relative to the output. */
+	geometry = pepper_output_get_geometry(seat->pointer.focus->base);
+
+	event.time = time;
+	event.x    = wl_fixed_to_double(surface_x) + geometry->x;
+	event.y    = wl_fixed_to_double(surface_y) + geometry->y;
+
+	pepper_object_emit_event((pepper_object_t *)seat->pointer.base,
+							 PEPPER_EVENT_INPUT_DEVICE_POINTER_MOTION_ABSOLUTE, &event);
+}
+
 static void
 pointer_handle_enter(void *data, struct wl_pointer *pointer,
 					 uint32_t serial, struct wl_surface *surface,
 					 wl_fixed_t surface_x, wl_fixed_t surface_y)
 {
-	/* TODO */
+	wayland_seat_t *seat = data;
+
+	if (!surface)
+		return;
+
+	seat->pointer.enter_serial = serial;
+	seat->pointer.focus = wl_surface_get_user_data(surface);
+
+	pointer_emit_motion(seat, 0, surface_x, surface_y);
+	wayland_seat_set_cursor(seat);
 }
 
 static void
 pointer_handle_leave(void *data, struct wl_pointer *pointer,
 					 uint32_t serial, struct wl_surface *surface)
 {
-	/* TODO */
+	wayland_seat_t *seat = data;
+
+	seat->pointer.focus = NULL;
 }
 
 static void
 pointer_handle_motion(void *data, struct wl_pointer *pointer,
 					  uint32_t time, wl_fixed_t surface_x, wl_fixed_t surface_y)
 {
-	/* TODO */
+	pointer_emit_motion(data, time, surface_x, surface_y);
 }
 
 static void
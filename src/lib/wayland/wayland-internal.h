@@ -57,6 +57,7 @@ struct pepper_wayland {
 
 	struct wl_registry     *registry;
 	struct wl_compositor   *compositor;
+	uint32_t                compositor_version;
 	struct wl_shell        *shell;
 	pepper_list_t           seat_list;
 	pepper_list_t           output_list;
@@ -81,7 +82,9 @@ struct wayland_shm_buffer {
 	int                     w, h;
 
 	pepper_render_target_t *target;
-	pepper_region_t       damage;
+
+	/* Damage this buffer missed while other buffers were rendered. */
+	pepper_region_t         damage;
 
 	void                   *data;
 };
@@ -103,8 +106,8 @@ struct wayland_output {
 	pepper_render_target_t     *render_target;
 	pepper_render_target_t     *gl_render_target;
 
-	void    (*render_pre)(wayland_output_t *output);
-	void    (*render_post)(wayland_output_t *output);
+	void    (*render_pre)(wayland_output_t *output, pepper_region_t *damage);
+	void    (*render_post)(wayland_output_t *output, pepper_region_t *damage);
 
 	struct {
 		/* list containing free buffers. */
@@ -124,6 +127,16 @@ struct wayland_output {
 #endif
 
 	pepper_plane_t             *primary_plane;
+	pepper_plane_t             *cursor_plane;
+	pepper_view_t              *cursor_view;
+
+	/* Cursor image set on the pointers of the host compositor. */
+	struct {
+		pepper_view_t          *view;
+		struct wl_surface      *surface;
+		int32_t                 hot_x, hot_y;
+	} cursor;
+
 	pepper_list_t               link;
 };
 
@@ -135,6 +148,8 @@ struct wayland_seat {
 	struct {
 		pepper_input_device_t      *base;
 		struct wl_pointer          *wl_pointer;
+		uint32_t                    enter_serial;
+		wayland_output_t           *focus;
 	} pointer;
 
 	struct {
@@ -160,6 +175,12 @@ wayland_shm_buffer_create(wayland_output_t *output);
 void
 wayland_shm_buffer_destroy(wayland_shm_buffer_t *buffer);
 
+void
+wayland_output_update_cursor(wayland_output_t *output);
+
+void
+wayland_seat_set_cursor(wayland_seat_t *seat);
+
 char *
 string_alloc(int len);
 
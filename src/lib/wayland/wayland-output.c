@@ -87,10 +87,19 @@ static const struct wl_shell_surface_listener shell_surface_listener = {
 static void
 wayland_output_destroy(void *o)
 {
-	wayland_output_t *output = o;
+	wayland_output_t   *output = o;
+	wayland_seat_t     *seat;
 
 	wl_list_remove(&output->conn_destroy_listener.link);
 
+	pepper_list_for_each(seat, &output->conn->seat_list, link) {
+		if (seat->pointer.focus == output)
+			seat->pointer.focus = NULL;
+	}
+
+	if (output->cursor.surface)
+		wl_surface_destroy(output->cursor.surface);
+
 	wl_surface_destroy(output->surface);
 	wl_shell_surface_destroy(output->shell_surface);
 
@@ -179,8 +188,18 @@ wayland_output_assign_planes(void *o, const pepper_list_t *view_list)
 	wayland_output_t   *output = (wayland_output_t *)o;
 	pepper_list_t      *l;
 
+	output->cursor_view = NULL;
+
 	pepper_list_for_each_list(l, view_list) {
 		pepper_view_t *view = l->item;
+
+		/* The host cursor is always on top, only the topmost view can be shown with it. */
+		if (l == view_list->next && pepper_view_get_cursor_buffer(view)) {
+			output->cursor_view = view;
+			pepper_view_assign_plane(view, output->base, output->cursor_plane);
+			continue;
+		}
+
 		pepper_view_assign_plane(view, output->base, output->primary_plane);
 	}
 }
@@ -209,23 +228,33 @@ wayland_output_repaint(void *o, const pepper_list_t *plane_list)
 		if (plane == output->primary_plane) {
 			const pepper_list_t *render_list = pepper_plane_get_render_list(plane);
 			pepper_region_t   *damage = pepper_plane_get_damage_region(plane);
+			pepper_region_t    frame_damage;
+
+			/* render_pre might extend the damage with what the render target
+			 * missed, but only this frame's damage is new to the parent. */
+			pepper_region_init(&frame_damage);
+			pepper_region_copy(&frame_damage, damage);
 
 			if (output->render_pre)
-				output->render_pre(output);
+				output->render_pre(output, damage);
 
 			pepper_renderer_repaint_output(output->renderer, output->base, render_list,
 										   damage);
 			pepper_plane_clear_damage_region(plane);
 
 			if (output->render_post)
-				output->render_post(output);
+				output->render_post(output, &frame_damage);
+
+			pepper_region_fini(&frame_damage);
 
 			callback = wl_surface_frame(output->surface);
 			wl_callback_add_listener(callback, &frame_listener, output);
 			wl_surface_commit(output->surface);
-			wl_display_flush(output->conn->display);
 		}
 	}
+
+	wayland_output_update_cursor(output);
+	wl_display_flush(output->conn->display);
 }
 
 static void
@@ -241,16 +270,25 @@ wayland_output_flush_surface_damage(void *o, pepper_surface_t *surface,
 									pepper_bool_t *keep_buffer)
 {
 	wayland_output_t   *output = o;
-	pepper_buffer_t    *buffer = pepper_surface_get_buffer(surface);
 
 	pepper_renderer_flush_surface_damage(output->renderer, surface);
+	*keep_buffer = !pepper_renderer_has_surface_copy(output->renderer, surface);
+}
 
-	if (output->renderer == output->conn->pixman_renderer ||
-		(buffer && !wl_shm_buffer_get(pepper_buffer_get_resource(buffer)))) {
-		*keep_buffer = PEPPER_TRUE;
-	} else {
-		*keep_buffer = PEPPER_FALSE;
-	}
+static pepper_bool_t
+wayland_output_move_cursor(void *o, pepper_view_t *view, double x, double y)
+{
+	wayland_output_t   *output = o;
+	int32_t             hot_x, hot_y;
+
+	/* The host cursor follows the host pointer, which the seat pointer follows. */
+	if (!output->cursor.view || output->cursor.view != view)
+		return PEPPER_FALSE;
+
+	if (!pepper_view_get_cursor_hotspot(view, &hot_x, &hot_y))
+		return PEPPER_FALSE;
+
+	return hot_x == output->cursor.hot_x && hot_y == output->cursor.hot_y;
 }
 
 static const pepper_output_backend_t wayland_output_backend = {
@@ -269,12 +307,13 @@ static const pepper_output_backend_t wayland_output_backend = {
 	wayland_output_repaint,
 	wayland_output_attach_surface,
 	wayland_output_flush_surface_damage,
+	wayland_output_move_cursor,
 };
 
 static void
-pixman_render_pre(wayland_output_t *output)
+pixman_render_pre(wayland_output_t *output, pepper_region_t *damage)
 {
-	wayland_shm_buffer_t *buffer = NULL;
+	wayland_shm_buffer_t *buffer = NULL, *other;
 
 	if (pepper_list_empty(&output->shm.free_buffers)) {
 		buffer = wayland_shm_buffer_create(output);
@@ -287,6 +326,17 @@ pixman_render_pre(wayland_output_t *output)
 		pepper_list_remove(&buffer->link);
 	}
 
+	/* Other buffers miss this frame, accumulate it to repaint them on reuse. */
+	pepper_list_for_each(other, &output->shm.free_buffers, link)
+	pepper_region_union(&other->damage, &other->damage, damage);
+
+	pepper_list_for_each(other, &output->shm.attached_buffers, link)
+	pepper_region_union(&other->damage, &other->damage, damage);
+
+	/* Bring the buffer up to date with the frames it missed. */
+	pepper_region_union(damage, damage, &buffer->damage);
+	pepper_region_clear(&buffer->damage);
+
 	pepper_list_insert(output->shm.attached_buffers.prev, &buffer->link);
 	output->shm.current_buffer = buffer;
 
@@ -294,10 +344,28 @@ pixman_render_pre(wayland_output_t *output)
 }
 
 static void
-pixman_render_post(wayland_output_t *output)
+pixman_render_post(wayland_output_t *output, pepper_region_t *damage)
 {
+	pepper_box_t   *rects;
+	int             i, count;
+
 	wl_surface_attach(output->surface, output->shm.current_buffer->buffer, 0, 0);
-	wl_surface_damage(output->surface, 0, 0, output->w, output->h);
+
+	rects = pepper_region_rectangles(damage, &count);
+
+	for (i = 0; i < count; i++) {
+#ifdef WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION
+		if (output->conn->compositor_version >= WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION) {
+			wl_surface_damage_buffer(output->surface, rects[i].x1, rects[i].y1,
+									 rects[i].x2 - rects[i].x1,
+									 rects[i].y2 - rects[i].y1);
+			continue;
+		}
+#endif
+		/* Output is not transformed nor scaled, so buffer is in surface space. */
+		wl_surface_damage(output->surface, rects[i].x1, rects[i].y1,
+						  rects[i].x2 - rects[i].x1, rects[i].y2 - rects[i].y1);
+	}
 }
 
 static pepper_bool_t
@@ -382,6 +450,8 @@ pepper_wayland_output_create(pepper_wayland_t *conn, int32_t w, int32_t h,
 	wl_shell_surface_add_listener(output->shell_surface, &shell_surface_listener,
 								  output);
 	wl_shell_surface_set_toplevel(output->shell_surface);
+	wl_surface_set_user_data(output->surface, output);
+	output->cursor.surface = wl_compositor_create_surface(conn->compositor);
 	snprintf(&output->name[0], 32, "wayland-%p", output);
 
 	/* Add compositor base class output object for this output. */
@@ -400,6 +470,7 @@ pepper_wayland_output_create(pepper_wayland_t *conn, int32_t w, int32_t h,
 	}
 
 	output->primary_plane = pepper_output_add_plane(output->base, NULL);
+	output->cursor_plane = pepper_output_add_plane(output->base, output->primary_plane);
 	pepper_list_insert(&conn->output_list, &output->link);
 
 	return output->base;
@@ -78,6 +78,40 @@ x11_handle_event(int fd, uint32_t mask, void *data)
 	while (x11_get_next_event(connection->xcb_connection, &event, mask)) {
 		uint32_t type = event->response_type & ~0x80;
 
+		if (connection->shm_first_event &&
+			type == (uint32_t)connection->shm_first_event + XCB_SHM_COMPLETION) {
+			xcb_shm_completion_event_t *completion;
+			x11_output_t *output;
+
+			completion = (xcb_shm_completion_event_t *)event;
+			output = x11_find_output_by_window(connection, completion->drawable);
+			if (output)
+				x11_output_handle_shm_completion(output);
+
+			free(event);
+			count++;
+			continue;
+		}
+
+		/* Errors of the unchecked shm uploads. */
+		if (type == 0 && connection->shm_first_event) {
+			xcb_generic_error_t *error = (xcb_generic_error_t *)event;
+
+			if (error->major_code == connection->shm_major_opcode &&
+				error->minor_code == XCB_SHM_PUT_IMAGE) {
+				x11_output_t *output, *tmp;
+
+				PEPPER_ERROR("Failed to put shm image, err: %d\n", error->error_code);
+
+				pepper_list_for_each_safe(output, tmp, &connection->output_list, link)
+				x11_output_handle_shm_error(output, error);
+
+				free(event);
+				count++;
+				continue;
+			}
+		}
+
 		switch (type) {
 		case XCB_ENTER_NOTIFY:
 		case XCB_LEAVE_NOTIFY:
@@ -252,6 +286,16 @@ pepper_x11_connect(pepper_compositor_t *compositor, const char *display_name)
 	connection->screen = scr_iter.data;
 
 	connection->fd = xcb_get_file_descriptor(connection->xcb_connection);
+
+	{
+		const xcb_query_extension_reply_t *ext;
+
+		ext = xcb_get_extension_data(connection->xcb_connection, &xcb_shm_id);
+		if (ext && ext->present) {
+			connection->shm_first_event = ext->first_event;
+			connection->shm_major_opcode = ext->major_opcode;
+		}
+	}
 	if (display_name)
 		connection->display_name = strdup(display_name);
 	else
@@ -29,125 +29,135 @@
 #include "x11-internal.h"
 #include <stdlib.h>
 
-static void *
-x11_output_cursor_set(void *o, void *c)
+static xcb_render_pictformat_t
+get_argb_format(pepper_x11_connection_t *conn)
 {
-	x11_output_t     *output = o;
-	x11_cursor_t     *cursor = c;
-	x11_cursor_t     *current_cursor;
-	pepper_x11_connection_t *conn;
+	xcb_render_query_pict_formats_cookie_t  cookie;
+	xcb_render_query_pict_formats_reply_t  *reply;
+	xcb_render_pictforminfo_iterator_t      iter;
 
-	if (!output) {
-		PEPPER_ERROR("x11:output:cursor:%s output is null\n", __FUNCTION__);
-		return NULL;
-	}
+	if (conn->argb_format_queried)
+		return conn->argb_format;
 
-	if (!cursor) {
-		PEPPER_ERROR("x11:output:cursor:%s cursor is null\n", __FUNCTION__);
-		return NULL;
-	}
+	conn->argb_format_queried = PEPPER_TRUE;
 
-	conn = output->connection;
+	cookie = xcb_render_query_pict_formats(conn->xcb_connection);
+	reply = xcb_render_query_pict_formats_reply(conn->xcb_connection, cookie, NULL);
+	PEPPER_CHECK(reply, return 0, "xcb_render_query_pict_formats() failed.\n");
 
-	current_cursor = output->cursor;
-	output->cursor = cursor;
+	iter = xcb_render_query_pict_formats_formats_iterator(reply);
 
-	/* set cursor for window*/
-	{
-		uint32_t mask       = XCB_CW_CURSOR;
-		uint32_t value_list = cursor->xcb_cursor;
-		xcb_change_window_attributes(conn->xcb_connection,
-									 output->window,
-									 mask,
-									 &value_list);
+	for (; iter.rem; xcb_render_pictforminfo_next(&iter)) {
+		xcb_render_directformat_t *direct = &iter.data->direct;
+
+		if (iter.data->type != XCB_RENDER_PICT_TYPE_DIRECT || iter.data->depth != 32)
+			continue;
+
+		if (direct->alpha_mask == 0xff && direct->alpha_shift == 24 &&
+			direct->red_mask == 0xff && direct->red_shift == 16 &&
+			direct->green_mask == 0xff && direct->green_shift == 8 &&
+			direct->blue_mask == 0xff && direct->blue_shift == 0) {
+			conn->argb_format = iter.data->id;
+			break;
+		}
 	}
 
-	return current_cursor;
+	free(reply);
+	return conn->argb_format;
 }
 
-static void *
-x11_output_cursor_create(void *output, int32_t w, int32_t h, void *image)
+/* Check whether the view can be shown as the cursor of the output window. */
+pepper_bool_t
+x11_output_cursor_supported(x11_output_t *output, pepper_view_t *view)
 {
-	xcb_pixmap_t     pixmap;
-	xcb_gc_t         gc;
-	pepper_x11_connection_t *conn;
-	x11_cursor_t     *cursor;
+	return pepper_view_get_cursor_buffer(view) && get_argb_format(output->connection);
+}
 
-	if (!output) {
-		PEPPER_ERROR("x11:output:cursor:%s: output is null\n", __FUNCTION__);
-		return NULL;
-	}
-	if (!image) {
-		PEPPER_ERROR("x11:output:cursor:%s: image is null\n", __FUNCTION__);
-		return NULL;
-	}
-	if (w < 0 || h < 0) {
-		PEPPER_ERROR("x11:output:cursor:%s: width(%d) or height(%d) is invalid\n",
-					 __FUNCTION__, w, h);
-		return NULL;
-	}
+x11_cursor_t *
+x11_cursor_create(x11_output_t *output, pepper_view_t *view)
+{
+	xcb_connection_t       *conn = output->connection->xcb_connection;
+	struct wl_shm_buffer   *shm_buffer = pepper_view_get_cursor_buffer(view);
+	x11_cursor_t           *cursor;
+	xcb_pixmap_t            pixmap;
+	xcb_gc_t                gc;
+	xcb_render_picture_t    picture;
+	uint8_t                *data, *src;
+	int32_t                 w, h, stride, i;
+
+	PEPPER_CHECK(shm_buffer, return NULL, "cursor view has no shm buffer.\n");
 
 	cursor = calloc(1, sizeof(x11_cursor_t));
-	if (!cursor) {
-		PEPPER_ERROR("x11:cursor: memory allocation failed");
+	PEPPER_CHECK(cursor, return NULL, "calloc() failed.\n");
+
+	w = wl_shm_buffer_get_width(shm_buffer);
+	h = wl_shm_buffer_get_height(shm_buffer);
+	stride = wl_shm_buffer_get_stride(shm_buffer);
+
+	data = malloc(w * h * 4);
+	if (!data) {
+		PEPPER_ERROR("malloc() failed.\n");
+		free(cursor);
 		return NULL;
 	}
-	cursor->data = image;
+
+	/* Pack the rows, the request has no stride. */
+	wl_shm_buffer_begin_access(shm_buffer);
+	src = wl_shm_buffer_get_data(shm_buffer);
+	for (i = 0; i < h; i++)
+		memcpy(data + i * w * 4, src + i * stride, w * 4);
+	wl_shm_buffer_end_access(shm_buffer);
+
+	cursor->view = view;
 	cursor->w = w;
 	cursor->h = h;
+	pepper_view_get_cursor_hotspot(view, &cursor->hot_x, &cursor->hot_y);
+
+	pixmap = xcb_generate_id(conn);
+	xcb_create_pixmap(conn, 32, pixmap, output->connection->screen->root, w, h);
+
+	gc = xcb_generate_id(conn);
+	xcb_create_gc(conn, gc, pixmap, 0, NULL);
+	xcb_put_image(conn, XCB_IMAGE_FORMAT_Z_PIXMAP, pixmap, gc, w, h, 0, 0, 0, 32,
+				  w * h * 4, data);
 
-	conn = ((x11_output_t *)output)->connection;
-
-	pixmap = xcb_generate_id(conn->xcb_connection);
-	gc = xcb_generate_id(conn->xcb_connection);
-
-	xcb_create_pixmap(conn->xcb_connection, 1/*depth?*/,
-					  pixmap, conn->screen->root, w, h);
-	xcb_create_gc(conn->xcb_connection, gc, pixmap, 0, NULL);
-	xcb_put_image(conn->xcb_connection, XCB_IMAGE_FORMAT_XY_PIXMAP, pixmap,
-				  gc, w, h, 0, 0, 0, 32, w * h * sizeof(uint8_t), cursor->data);
-	cursor->xcb_cursor = xcb_generate_id(conn->xcb_connection);
-	/*
-	 * cb_void_cookie_t xcb_create_cursor(xcb_connection_t *conn,
-	 *                                    xcb_cursor_t cid,
-	 *                                    xcb_pixmap_t source,
-	 *                                    xcb_pixmap_t mask,
-	 *                                    uint16_t fore_red,    TODO: NOT YET DOCUMENTED.
-	 *                                    uint16_t fore_green,
-	 *                                    uint16_t fore_blue,
-	 *                                    uint16_t back_red,
-	 *                                    uint16_t back_green,
-	 *                                    uint16_t back_blue,
-	 *                                    uint16_t x,
-	 *                                    uint16_t y);
-	 */
-	xcb_create_cursor(conn->xcb_connection, cursor->xcb_cursor,
-					  pixmap, pixmap, 0, 0, 0,  0, 0, 0,  1, 1);
-
-	xcb_free_gc(conn->xcb_connection, gc);
-	xcb_free_pixmap(conn->xcb_connection, pixmap);
-
-	return (void *)cursor;
+	picture = xcb_generate_id(conn);
+	xcb_render_create_picture(conn, picture, pixmap,
+							  get_argb_format(output->connection), 0, NULL);
+
+	cursor->xcb_cursor = xcb_generate_id(conn);
+	xcb_render_create_cursor(conn, cursor->xcb_cursor, picture,
+							 cursor->hot_x, cursor->hot_y);
+
+	xcb_render_free_picture(conn, picture);
+	xcb_free_gc(conn, gc);
+	xcb_free_pixmap(conn, pixmap);
+	free(data);
+
+	return cursor;
 }
 
-static void
-x11_output_cursor_destroy(void *o, void *c)
+void
+x11_cursor_destroy(x11_output_t *output, x11_cursor_t *cursor)
 {
-	xcb_connection_t *conn;
-	x11_cursor_t     *cursor;
+	xcb_free_cursor(output->connection->xcb_connection, cursor->xcb_cursor);
+	free(cursor);
+}
 
-	if (!o) {
-		PEPPER_ERROR("x11:output:cursor:%s: output is null\n", __FUNCTION__);
-		return ;
-	}
-	if (!c) {
-		PEPPER_ERROR("x11:output:cursor:%s: cursor is null\n", __FUNCTION__);
-		return ;
-	}
+/* Set the cursor of the output window, NULL for the default cursor. */
+void
+x11_output_set_cursor(x11_output_t *output, x11_cursor_t *cursor)
+{
+	uint32_t value = cursor ? cursor->xcb_cursor : XCB_CURSOR_NONE;
 
-	conn = ((x11_output_t *)o)->connection->xcb_connection;
-	cursor = (x11_cursor_t *)c;
+	if (output->cursor == cursor)
+		return;
 
-	xcb_free_cursor(conn, cursor->xcb_cursor);
-	free(cursor);
+	xcb_change_window_attributes(output->connection->xcb_connection, output->window,
+								 XCB_CW_CURSOR, &value);
+
+	if (output->cursor)
+		x11_cursor_destroy(output, output->cursor);
+
+	output->cursor = cursor;
 }
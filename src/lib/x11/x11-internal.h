@@ -33,6 +33,7 @@
 
 #include <xcb/xcb.h>
 #include <xcb/shm.h>
+#include <xcb/render.h>
 #include <X11/Xlib.h>
 #include <X11/Xlib-xcb.h>
 #include <string.h>
@@ -43,6 +44,7 @@
 #include <stdio.h>
 
 #define X11_BACKEND_INPUT_ID    0x12345678
+#define X11_MAX_DAMAGE_RECTS    16
 
 typedef struct x11_output       x11_output_t;
 typedef struct x11_cursor       x11_cursor_t;
@@ -74,6 +76,7 @@ struct x11_output {
 	xcb_window_t             window;
 	xcb_gc_t                 gc;
 	x11_cursor_t            *cursor;
+	pepper_view_t           *cursor_view;
 
 	pepper_renderer_t       *renderer;
 	x11_shm_image_t          shm;
@@ -81,9 +84,12 @@ struct x11_output {
 	pepper_render_target_t  *gl_target;
 
 	struct wl_event_source  *frame_done_timer;
+	pepper_bool_t            shm_pending;
+	uint32_t                 shm_sequence;  /* request that sends the completion */
 	struct wl_listener       conn_destroy_listener;
 
 	pepper_plane_t          *primary_plane;
+	pepper_plane_t          *cursor_plane;
 };
 
 struct x11_seat {
@@ -113,6 +119,12 @@ struct pepper_x11_connection {
 	struct wl_event_source *xcb_event_source;
 	int fd;
 
+	uint8_t                 shm_first_event;
+	uint8_t                 shm_major_opcode;
+
+	pepper_bool_t           argb_format_queried;
+	xcb_render_pictformat_t argb_format;
+
 	pepper_list_t           output_list;
 
 	pepper_bool_t           use_xinput;
@@ -142,8 +154,9 @@ struct pepper_x11_connection {
 
 struct x11_cursor {
 	xcb_cursor_t     xcb_cursor;
-	int              w, h;
-	uint8_t         *data;
+	pepper_view_t   *view;
+	int32_t          w, h;
+	int32_t          hot_x, hot_y;
 };
 
 /* it declared in xcb-icccm.h */
@@ -172,7 +185,25 @@ x11_handle_input_event(x11_seat_t *seat, uint32_t type,
 void
 x11_output_destroy(void *o);
 
+void
+x11_output_handle_shm_completion(x11_output_t *output);
+
+void
+x11_output_handle_shm_error(x11_output_t *output, xcb_generic_error_t *error);
+
 void
 x11_seat_destroy(void *data);
 
+pepper_bool_t
+x11_output_cursor_supported(x11_output_t *output, pepper_view_t *view);
+
+x11_cursor_t *
+x11_cursor_create(x11_output_t *output, pepper_view_t *view);
+
+void
+x11_cursor_destroy(x11_output_t *output, x11_cursor_t *cursor);
+
+void
+x11_output_set_cursor(x11_output_t *output, x11_cursor_t *cursor);
+
 #endif  /*X11_INTERNAL_H*/
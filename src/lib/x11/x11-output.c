@@ -310,6 +310,7 @@ x11_output_destroy(void *o)
 
 	/* XXX */
 	x11_shm_image_deinit(conn->xcb_connection, &output->shm);
+	x11_output_set_cursor(output, NULL);
 	wl_event_source_remove(output->frame_done_timer);
 	xcb_destroy_window(conn->xcb_connection, output->window);
 	pepper_list_remove(&output->link);
@@ -430,8 +431,18 @@ x11_output_assign_planes(void *o, const pepper_list_t *view_list)
 	x11_output_t   *output = (x11_output_t *)o;
 	pepper_list_t  *l;
 
+	output->cursor_view = NULL;
+
 	pepper_list_for_each_list(l, view_list) {
 		pepper_view_t *view = l->item;
+
+		/* The window cursor is always on top, only the topmost view can be shown with it. */
+		if (l == view_list->next && x11_output_cursor_supported(output, view)) {
+			output->cursor_view = view;
+			pepper_view_assign_plane(view, output->base, output->cursor_plane);
+			continue;
+		}
+
 		pepper_view_assign_plane(view, output->base, output->primary_plane);
 	}
 }
@@ -446,6 +457,106 @@ x11_output_start_repaint_loop(void *o)
 	pepper_output_finish_frame(output->base, &ts);
 }
 
+static void
+x11_output_put_damage(x11_output_t *output, pepper_region_t *damage)
+{
+	xcb_connection_t    *conn = output->connection->xcb_connection;
+	pepper_region_t      clip;
+	pepper_box_t        *rects;
+	int                  i, count;
+
+	pepper_region_init_rect(&clip, 0, 0, output->shm.w, output->shm.h);
+	pepper_region_intersect(&clip, &clip, damage);
+
+	rects = pepper_region_rectangles(&clip, &count);
+
+	/* Too many small requests cost more than uploading a few extra pixels. */
+	if (count > X11_MAX_DAMAGE_RECTS) {
+		rects = pepper_region_extents(&clip);
+		count = 1;
+	}
+
+	/* Upload only damaged rectangles without waiting for the server. Ask for a
+	 * completion event on the last request, the server is done reading the shm
+	 * segment when it arrives and the frame is finished then. Failures come back
+	 * as errors, see x11_output_handle_shm_error(). */
+	for (i = 0; i < count; i++) {
+		xcb_void_cookie_t cookie;
+
+		cookie = xcb_shm_put_image(conn,
+								   output->window,
+								   output->gc,
+								   output->shm.w,    /* total_width */
+								   output->shm.h,    /* total_height */
+								   rects[i].x1,      /* src_x */
+								   rects[i].y1,      /* src_y */
+								   rects[i].x2 - rects[i].x1,    /* src_w */
+								   rects[i].y2 - rects[i].y1,    /* src_h */
+								   rects[i].x1,      /* dst_x */
+								   rects[i].y1,      /* dst_y */
+								   output->depth,    /* depth */
+								   XCB_IMAGE_FORMAT_Z_PIXMAP,    /* format */
+								   i == count - 1,   /* send_event */
+								   output->shm.segment,  /* xcb shm segment */
+								   0);   /* offset */
+
+		output->shm_sequence = cookie.sequence;
+	}
+
+	pepper_region_fini(&clip);
+
+	if (count > 0 && output->connection->shm_first_event) {
+		output->shm_pending = PEPPER_TRUE;
+		xcb_flush(conn);
+	} else {
+		xcb_flush(conn);
+		wl_event_source_timer_update(output->frame_done_timer, 10);
+	}
+}
+
+void
+x11_output_handle_shm_completion(x11_output_t *output)
+{
+	if (!output->shm_pending)
+		return;
+
+	output->shm_pending = PEPPER_FALSE;
+	pepper_output_finish_frame(output->base, NULL);
+}
+
+void
+x11_output_handle_shm_error(x11_output_t *output, xcb_generic_error_t *error)
+{
+	/* No completion event is sent for a failed request, finish the frame here. */
+	if (output->shm_pending && error->full_sequence == output->shm_sequence)
+		x11_output_handle_shm_completion(output);
+}
+
+static void
+x11_output_update_cursor(x11_output_t *output)
+{
+	pepper_region_t    *damage = pepper_plane_get_damage_region(output->cursor_plane);
+	x11_cursor_t       *cursor = output->cursor;
+	int32_t             hot_x, hot_y;
+
+	if (!output->cursor_view) {
+		x11_output_set_cursor(output, NULL);
+		pepper_plane_clear_damage_region(output->cursor_plane);
+		return;
+	}
+
+	pepper_view_get_cursor_hotspot(output->cursor_view, &hot_x, &hot_y);
+
+	/* The cursor image is only uploaded again when it has been changed. */
+	if (!cursor || cursor->view != output->cursor_view || cursor->hot_x != hot_x ||
+		cursor->hot_y != hot_y || pepper_region_not_empty(damage)) {
+		cursor = x11_cursor_create(output, output->cursor_view);
+		x11_output_set_cursor(output, cursor);
+	}
+
+	pepper_plane_clear_damage_region(output->cursor_plane);
+}
+
 static void
 x11_output_repaint(void *o, const pepper_list_t *plane_list)
 {
@@ -458,46 +569,47 @@ x11_output_repaint(void *o, const pepper_list_t *plane_list)
 		if (plane == output->primary_plane) {
 			const pepper_list_t *render_list = pepper_plane_get_render_list(plane);
 			pepper_region_t   *damage = pepper_plane_get_damage_region(plane);
+			pepper_region_t    damage_copy;
+
+			/* Damage region is cleared below, keep what has to be uploaded. */
+			pepper_region_init(&damage_copy);
+			pepper_region_copy(&damage_copy, damage);
 
 			pepper_renderer_set_target(output->renderer, output->target);
 			pepper_renderer_repaint_output(output->renderer, output->base, render_list,
 										   damage);
 			pepper_plane_clear_damage_region(plane);
 
-			if (output->renderer == output->connection->pixman_renderer) {
-				xcb_void_cookie_t    cookie;
-				xcb_generic_error_t *err;
-
-				cookie = xcb_shm_put_image_checked(output->connection->xcb_connection,
-												   output->window,
-												   output->gc,
-												   output->w,
-												   output->h,
-												   0,   /* src_x */
-												   0,   /* src_y */
-												   output->shm.w,  /* src_w */
-												   output->shm.h, /* src_h */
-												   0,   /* dst_x */
-												   0,   /* dst_y */
-												   output->depth,   /* depth */
-												   XCB_IMAGE_FORMAT_Z_PIXMAP,   /* format */
-												   0,   /* send_event */
-												   output->shm.segment, /* xcb shm segment */
-												   0);  /* offset */
-
-				err = xcb_request_check(output->connection->xcb_connection, cookie);
-				if (err) {
-					PEPPER_ERROR("Failed to put shm image, err: %d\n", err->error_code);
-					free(err);
-				}
+			if (output->renderer == output->connection->pixman_renderer &&
+				pepper_region_not_empty(&damage_copy)) {
+				x11_output_put_damage(output, &damage_copy);
+			} else {
+				/* XXX: No completion event to wait for, frame_done callback called
+				 * after 10ms, referenced from weston */
+				wl_event_source_timer_update(output->frame_done_timer, 10);
 			}
 
-			/* XXX: frame_done callback called after 10ms, referenced from weston */
-			wl_event_source_timer_update(output->frame_done_timer, 10);
+			pepper_region_fini(&damage_copy);
 		}
-
-		/* TODO: Cursor??? */
 	}
+
+	x11_output_update_cursor(output);
+}
+
+static pepper_bool_t
+x11_output_move_cursor(void *o, pepper_view_t *view, double x, double y)
+{
+	x11_output_t   *output = o;
+	int32_t         hot_x, hot_y;
+
+	/* The window cursor follows the host pointer, which the seat pointer follows. */
+	if (!output->cursor || output->cursor->view != view)
+		return PEPPER_FALSE;
+
+	if (!pepper_view_get_cursor_hotspot(view, &hot_x, &hot_y))
+		return PEPPER_FALSE;
+
+	return hot_x == output->cursor->hot_x && hot_y == output->cursor->hot_y;
 }
 
 static void
@@ -511,16 +623,9 @@ x11_output_flush_surface_damage(void *o, pepper_surface_t *surface,
 								pepper_bool_t *keep_buffer)
 {
 	x11_output_t    *output = o;
-	pepper_buffer_t *buffer = pepper_surface_get_buffer(surface);
 
 	pepper_renderer_flush_surface_damage(output->renderer, surface);
-
-	if (output->renderer == output->connection->pixman_renderer ||
-		(buffer && !wl_shm_buffer_get(pepper_buffer_get_resource(buffer)))) {
-		*keep_buffer = PEPPER_TRUE;
-	} else {
-		*keep_buffer = PEPPER_FALSE;
-	}
+	*keep_buffer = !pepper_renderer_has_surface_copy(output->renderer, surface);
 }
 
 /* X11 output backend to export for PePPer core */
@@ -540,6 +645,7 @@ static const pepper_output_backend_t x11_output_backend = {
 	x11_output_repaint,
 	x11_output_attach_surface,
 	x11_output_flush_surface_damage,
+	x11_output_move_cursor,
 };
 
 PEPPER_API pepper_output_t *
@@ -657,6 +763,7 @@ pepper_x11_output_create(pepper_x11_connection_t *connection,
 
 	output->base = base;
 	output->primary_plane = pepper_output_add_plane(output->base, NULL);
+	output->cursor_plane = pepper_output_add_plane(output->base, output->primary_plane);
 	pepper_output_move(base, x, y);
 
 	return base;